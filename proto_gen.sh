@@ -1,9 +1,9 @@
 #! /bin/sh
 
-# The nautic_net_protobuf repository must exist alongside nautic_net_tracker_mini
+# Regenerates src/lora_packet.pb.{h,c} from proto/lora_packet.proto and its nanopb options
 
 python2.7 \
     .pio/libdeps/adafruit_feather_m0/Nanopb/generator/nanopb_generator.py \
-    -I ../nautic_net_protobuf/lib/nautic_net/protobuf \
+    -I proto \
     -D src \
     lora_packet.proto 
@@ -0,0 +1,440 @@
+#include <Arduino.h>
+
+#include "commands.h"
+#include "config.h"
+#include "main.h"
+#include "nautic_net/util.h"
+
+using namespace nautic_net;
+using nautic_net::console::Args;
+using nautic_net::console::Response;
+
+static void CommandHelp(const Args &args, Response *response)
+{
+    kConsole.PrintHelp(response);
+}
+
+static void CommandFrame(const Args &args, Response *response)
+{
+    kConsole.SetFramed(args.GetUInt(0) != 0);
+}
+
+static void CommandBeginCompassCalibration(const Args &args, Response *response)
+{
+    kIMU.BeginCompassCalibration();
+}
+
+static void CommandFinishCompassCalibration(const Args &args, Response *response)
+{
+    kIMU.FinishCompassCalibration();
+}
+
+static void CommandEEPROM(const Args &args, Response *response)
+{
+    response->Field("Serial number", (unsigned long)kEEPROM.ReadSerialNumber());
+
+    hw::eeprom::CompassCalibration cal = kEEPROM.ReadCompassCalibration();
+    response->Field("Compass cal X", cal.x, 2);
+    response->Field("Compass cal Y", cal.y, 2);
+    response->Field("Compass cal Z", cal.z, 2);
+
+    response->Field("Record writes", kEEPROM.write_count_);
+    response->Field("CRC errors", kEEPROM.crc_error_count_);
+}
+
+static void CommandSerialNumber(const Args &args, Response *response)
+{
+    if (args.Has(0))
+    {
+        kEEPROM.WriteSerialNumber(args.GetUInt(0));
+        response->Field("New serial number", (unsigned long)args.GetUInt(0));
+    }
+    else
+    {
+        response->Field("Serial number", (unsigned long)kEEPROM.ReadSerialNumber());
+    }
+}
+
+static void CommandResetEEPROM(const Args &args, Response *response)
+{
+    kEEPROM.Reset();
+    response->Text("Reset EEPROM to default values");
+}
+
+static void CommandStatus(const Args &args, Response *response)
+{
+    response->Text("--- STATUS ---");
+    response->Field("Firmware", config::kFirmwareVersion.c_str());
+    response->Field("Battery voltage", util::ReadBatteryVoltage(), 2);
+    response->Field("Battery percent", util::ReadBatteryPercentage());
+    response->Field("Mode", kMode == Mode::kBase ? "Base Station" : "Rover");
+    response->Field("Uptime ms", millis());
+    response->Field("GPS fix", kGPS.gps_.fix ? 1 : 0);
+    response->Field("GPS TTFF ms", kGPS.ttff_ms_);
+    response->Field("GPS start", hw::gps::GPS::GetStartTypeName(kGPS.start_type_));
+    response->Field("GPS aided", kGPS.is_aided_ ? 1 : 0);
+
+    if (kMode == Mode::kRover)
+    {
+        response->Field("Configured", kRover.IsConfigured() ? 1 : 0);
+        response->Field("Discovery attempts", kRover.backoff_.attempt_count_);
+        response->Field("Discovery window", kRover.backoff_.GetWindow());
+        response->Field("Backfill pending", kRover.backfill_.GetPendingCount());
+        response->Field("Backfill sent", kRover.backfill_.sent_count_);
+    }
+}
+
+static void CommandStats(const Args &args, Response *response)
+{
+    response->Field("Uptime ms", millis());
+    response->Field("Radio TX", kRadio.tx_count_);
+    response->Field("Radio RX", kRadio.rx_count_);
+    response->Field("Radio RX malformed", kRadio.rx_malformed_count_);
+    response->Field("Radio RX filtered", kRadio.rx_filtered_count_);
+    response->Field("Radio oversize", kRadio.oversize_count_);
+    response->Field("Console lines", kConsole.line_count_);
+    response->Field("Console errors", kConsole.error_count_);
+    response->Field("Console overflows", kConsole.overflow_count_);
+}
+
+static void CommandRoster(const Args &args, Response *response)
+{
+    if (kMode != Mode::kBase)
+    {
+        response->Error("not a base station");
+        return;
+    }
+
+    const base::Roster &roster = kBase.GetRoster();
+    response->Field("Rovers", roster.Count());
+    response->Field("Capacity", base::kRosterSize);
+
+    char label[24];
+    for (unsigned int i = 0; i < roster.Count(); i++)
+    {
+        snprintf(label, sizeof(label), "Rover %u hwid", i);
+        response->Field(label, (unsigned long)roster.hardware_ids_[i], HEX);
+
+        snprintf(label, sizeof(label), "Rover %u serial", i);
+        response->Field(label, (unsigned long)roster.serial_numbers_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u slot", i);
+        response->Field(label, (unsigned int)roster.base_slots_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u address", i);
+        response->Field(label, base::Base::GetAddress(i));
+
+        snprintf(label, sizeof(label), "Rover %u micro-slot", i);
+        response->Field(label, (unsigned int)roster.micro_slots_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u channel", i);
+        response->Field(label, (unsigned int)roster.channels_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u CR 4/", i);
+        response->Field(label, (unsigned int)roster.coding_rates_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u RSSI", i);
+        response->Field(label, (int)roster.links_[i].rssi);
+
+        snprintf(label, sizeof(label), "Rover %u period", i);
+        response->Field(label, (unsigned int)roster.periods_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u phase", i);
+        response->Field(label, (unsigned int)roster.phases_[i]);
+
+        snprintf(label, sizeof(label), "Rover %u configured", i);
+        response->Field(label, roster.is_configured_[i] ? 1 : 0);
+    }
+}
+
+static void CommandLink(const Args &args, Response *response)
+{
+    if (kMode != Mode::kBase)
+    {
+        response->Error("not a base station");
+        return;
+    }
+
+    const base::Roster &roster = kBase.GetRoster();
+
+    char label[24];
+    for (unsigned int i = 0; i < roster.Count(); i++)
+    {
+        const base::LinkStats &link = roster.links_[i];
+
+        snprintf(label, sizeof(label), "Rover %u hwid", i);
+        response->Field(label, (unsigned long)roster.hardware_ids_[i], HEX);
+
+        snprintf(label, sizeof(label), "Rover %u received", i);
+        response->Field(label, (unsigned long)link.received);
+
+        snprintf(label, sizeof(label), "Rover %u missed", i);
+        response->Field(label, (unsigned int)link.missed);
+
+        snprintf(label, sizeof(label), "Rover %u duplicates", i);
+        response->Field(label, (unsigned int)link.duplicates);
+
+        snprintf(label, sizeof(label), "Rover %u slot misses", i);
+        response->Field(label, (unsigned int)link.slot_misses);
+
+        snprintf(label, sizeof(label), "Rover %u RSSI", i);
+        response->Field(label, (int)link.rssi);
+
+        snprintf(label, sizeof(label), "Rover %u RSSI min", i);
+        response->Field(label, (int)link.rssi_min);
+
+        snprintf(label, sizeof(label), "Rover %u RSSI max", i);
+        response->Field(label, (int)link.rssi_max);
+
+        snprintf(label, sizeof(label), "Rover %u SNR", i);
+        response->Field(label, (int)link.snr);
+
+        snprintf(label, sizeof(label), "Rover %u last cycle", i);
+        response->Field(label, (unsigned int)link.last_heard_cycle);
+    }
+}
+
+static void CommandBacklog(const Args &args, Response *response)
+{
+    if (kMode != Mode::kBase)
+    {
+        response->Error("not a base station");
+        return;
+    }
+
+    const base::Backlog &backlog = kBase.GetBacklog();
+
+    response->Field("Host connected", base::Base::IsHostConnected() ? 1 : 0);
+    response->Field("Pending", backlog.GetPendingCount());
+    response->Field("Staged", backlog.GetStagedCount());
+    response->Field("Capacity", base::Backlog::GetCapacity());
+    response->Field("Written", backlog.written_count_);
+    response->Field("Drained", backlog.drained_count_);
+    response->Field("Overwritten", backlog.overwritten_count_);
+    response->Field("Dropped", backlog.dropped_count_);
+    response->Field("CRC errors", backlog.crc_error_count_);
+}
+
+static void CommandTrack(const Args &args, Response *response)
+{
+    if (kMode != Mode::kRover)
+    {
+        response->Error("not a rover");
+        return;
+    }
+
+    rover::TrackLog &track_log = kRover.track_log_;
+
+    response->Field("Pages", track_log.GetPageCount());
+    response->Field("Capacity", track_log.GetCapacity());
+    response->Field("Dropped pages", track_log.dropped_page_count_);
+    response->Field("Flash writes", track_log.flash_.write_count_);
+    response->Field("Flash erases", track_log.flash_.erase_count_);
+    response->Field("Flash stall ms", track_log.flash_.stalled_ticks_);
+    response->Field("Dumping", track_log.IsDumping() ? 1 : 0);
+}
+
+static void CommandTrackDump(const Args &args, Response *response)
+{
+    if (kMode != Mode::kRover)
+    {
+        response->Error("not a rover");
+        return;
+    }
+
+    if (!kRover.track_log_.BeginDump())
+    {
+        response->Error("no track log, or already dumping");
+        return;
+    }
+
+    // The pages follow this response as binary frames, ending with a kTrackEnd frame
+    response->Field("Pages", kRover.track_log_.GetPageCount());
+}
+
+static void CommandRadio(const Args &args, Response *response)
+{
+    hw::radio::Config radio_config = kRadio.GetConfig();
+
+    response->Field("Frequency MHz", hw::radio::Radio::GetFrequency(radio_config.channel), 1);
+    response->Field("Channel", radio_config.channel);
+    response->Field("Power dBm", config::kLoraPower);
+    response->Field("SBW kHz", radio_config.sbw);
+    response->Field("SF", radio_config.sf);
+    response->Field("CR 4/", radio_config.coding_rate);
+    response->Field("Preamble", radio_config.preamble);
+    response->Field("Implicit header", radio_config.is_implicit_header ? 1 : 0);
+    response->Field("Data frame us", tdma::kRoverDataAirtime);
+    response->Field("Micro-slots", tdma::kMicroSlotCount);
+    response->Field("Max data CR 4/", tdma::kMaxRoverDataCodingRate);
+}
+
+static void CommandRate(const Args &args, Response *response)
+{
+    if (kMode != Mode::kRover)
+    {
+        response->Error("not a rover");
+        return;
+    }
+
+    if (args.Has(0))
+    {
+        if (args.GetUInt(0) < 1 || args.GetUInt(0) > tdma::kSuperframeCycleCount)
+        {
+            response->Error("period must be 1 through the superframe length");
+            return;
+        }
+
+        // Rounded up to a divisor of the superframe length; the rover rediscovers to pick up the new rate class
+        kRover.SetRequestedPeriod(args.GetUInt(0));
+    }
+
+    response->Field("Requested period", kRover.GetRequestedPeriod());
+    response->Field("Period", kRover.GetPeriod());
+    response->Field("Phase", kRover.GetPhase());
+    response->Field("Superframe cycles", tdma::kSuperframeCycleCount);
+    response->Field("Stationary", kRover.IsStationary() ? 1 : 0);
+}
+
+static void CommandBoot(const Args &args, Response *response)
+{
+    char label[24];
+    for (int i = 0; i < (int)boot::Subsystem::kCount; i++)
+    {
+        boot::Subsystem subsystem = (boot::Subsystem)i;
+        const boot::Status &status = kBoot.GetStatus(subsystem);
+        const char *name = boot::Boot::GetName(subsystem);
+
+        snprintf(label, sizeof(label), "%s state", name);
+        response->Field(label, boot::Boot::GetStateName(status.state));
+
+        snprintf(label, sizeof(label), "%s ready ms", name);
+        response->Field(label, status.ready_ms);
+
+        snprintf(label, sizeof(label), "%s attempts", name);
+        response->Field(label, status.attempts);
+    }
+}
+
+static void CommandProfile(const Args &args, Response *response)
+{
+    if (args.Has(0))
+    {
+        if (strcmp(args.GetString(0), "reset") != 0)
+        {
+            response->Error("expected 'reset'");
+            return;
+        }
+
+        kProfiler.Reset();
+    }
+
+    char label[24];
+    for (int i = 0; i < (int)profiler::Section::kCount; i++)
+    {
+        profiler::Section section = (profiler::Section)i;
+        const profiler::Stats &stats = kProfiler.GetStats(section);
+        const char *name = profiler::Profiler::GetName(section);
+
+        snprintf(label, sizeof(label), "%s count", name);
+        response->Field(label, stats.count);
+
+        snprintf(label, sizeof(label), "%s avg us", name);
+        response->Field(label, stats.count == 0 ? 0UL : stats.total_us / stats.count);
+
+        snprintf(label, sizeof(label), "%s min us", name);
+        response->Field(label, stats.min_us);
+
+        snprintf(label, sizeof(label), "%s max us", name);
+        response->Field(label, stats.max_us);
+    }
+}
+
+static void CommandMemory(const Args &args, Response *response)
+{
+    memory::Stats stats = kMemory.GetStats();
+
+    response->Field("RAM", memory::kRamSize);
+    response->Field("Static data", stats.static_data);
+    response->Field("Static bss", stats.static_bss);
+    response->Field("Static budget", memory::kStaticRamBudget);
+    response->Field("Heap arena", stats.heap_arena);
+    response->Field("Heap used", stats.heap_used);
+    response->Field("Heap free", stats.heap_free);
+    response->Field("Heap free chunks", stats.heap_free_chunks);
+    response->Field("Heap reserve", memory::kHeapReserve);
+    response->Field("Stack used", stats.stack_used);
+    response->Field("Stack max", stats.stack_max);
+    response->Field("Stack reserve", memory::kStackReserve);
+    response->Field("Gap", stats.gap);
+    response->Field("Min gap", stats.min_gap);
+    response->Field("Within budget", kMemory.IsWithinBudget(stats) ? 1 : 0);
+}
+
+static void CommandTrace(const Args &args, Response *response)
+{
+    if (args.Has(0))
+    {
+        const char *action = args.GetString(0);
+        if (strcmp(action, "dump") == 0)
+        {
+            if (!trace::kTrace.BeginDump())
+            {
+                response->Error("already dumping");
+                return;
+            }
+
+            // The entries follow this response as binary frames, ending with a kTraceEnd frame
+        }
+        else if (strcmp(action, "stream") == 0 && args.Has(1))
+        {
+            trace::kTrace.SetStreaming(args.GetUInt(1) != 0);
+        }
+        else if (strcmp(action, "clear") == 0)
+        {
+            trace::kTrace.Clear();
+        }
+        else
+        {
+            response->Error("expected 'dump', 'stream <0/1>' or 'clear'");
+            return;
+        }
+    }
+
+#ifdef TRACE
+    response->Field("Enabled", 1);
+#else
+    response->Field("Enabled", 0);
+#endif
+    response->Field("Entries", trace::kTrace.GetCount());
+    response->Field("Capacity", trace::Trace::kCapacity);
+    response->Field("Recorded", trace::kTrace.GetTotal());
+    response->Field("Lost", trace::kTrace.lost_count_);
+    response->Field("Streaming", trace::kTrace.IsStreaming() ? 1 : 0);
+    response->Field("Dumping", trace::kTrace.IsDumping() ? 1 : 0);
+}
+
+void RegisterCommands(console::Console *console)
+{
+    // Legacy single-character commands keep their aliases, e.g. "s12345" still sets the serial number
+    console->Register({"help", 'h', "", "List commands", CommandHelp});
+    console->Register({"frame", 0, "u", "Framed responses for host tools (1) or human-readable (0)", CommandFrame});
+    console->Register({"cal", 'c', "", "Begin compass calibration", CommandBeginCompassCalibration});
+    console->Register({"calfinish", 'f', "", "Finish compass calibration", CommandFinishCompassCalibration});
+    console->Register({"eeprom", 'e', "", "Print EEPROM contents", CommandEEPROM});
+    console->Register({"serial", 's', "?u", "Read or write serial number", CommandSerialNumber});
+    console->Register({"eepromreset", 'z', "", "Reset EEPROM to default values", CommandResetEEPROM});
+    console->Register({"status", '?', "", "Print general info", CommandStatus});
+    console->Register({"stats", 0, "", "Print radio and console counters", CommandStats});
+    console->Register({"roster", 0, "", "Print discovered rovers (base station only)", CommandRoster});
+    console->Register({"link", 0, "", "Print per-rover link and delivery statistics (base station only)", CommandLink});
+    console->Register({"backlog", 0, "", "Print the rover data log kept while no host is connected (base station only)", CommandBacklog});
+    console->Register({"track", 0, "", "Print track log state (rover only)", CommandTrack});
+    console->Register({"trackdump", 0, "", "Stream the track log as binary frames, for tools/track_dump (rover only)", CommandTrackDump});
+    console->Register({"radio", 0, "", "Print radio configuration", CommandRadio});
+    console->Register({"rate", 0, "?u", "Read or request the rate class (transmit every Nth cycle; rover only)", CommandRate});
+    console->Register({"boot", 0, "", "Print subsystem bring-up state and time to ready", CommandBoot});
+    console->Register({"prof", 0, "?s", "Print loop profiling; 'prof reset' clears it", CommandProfile});
+    console->Register({"mem", 0, "", "Print static, heap and stack usage against the RAM budget", CommandMemory});
+    console->Register({"trace", 0, "?su", "Print trace state; 'trace dump', 'trace stream <0/1>' or 'trace clear' (see tools/trace_dump)", CommandTrace});
+}
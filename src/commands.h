@@ -0,0 +1,9 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include "nautic_net/console.h"
+
+// Adds every serial command to the console's command table
+void RegisterCommands(nautic_net::console::Console *console);
+
+#endif
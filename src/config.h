@@ -5,11 +5,15 @@
 #include <Arduino.h>
 
 #include "nautic_net/hw/radio.h"
+#include "nautic_net/tdma/channel_plan.h"
 
 // Uncomment to enable debug() and debugln() macros for printing to Serial
 // #define SERIAL_DEBUG
 // #define WAIT_FOR_SERIAL
 
+// Comment out to compile trace() calls away (see nautic_net/trace.h); unlike SERIAL_DEBUG, fine to leave on
+#define TRACE
+
 namespace nautic_net::config
 {
     // Firmware version - follow SemVer (https://semver.org/)
@@ -22,6 +26,14 @@ namespace nautic_net::config
     static const std::set<int> kRoverDiscoverySlots = {0, 10, 20, 30, 40, 50, 60, 70, 80, 90};
     static const std::set<int> kRoverConfigurationSlots = {1, 11, 21, 31, 41, 51, 61, 71, 81, 91};
     static const unsigned int kSlotCountPerTransmit = 1;
+    static const unsigned int kSuperframeCycleCount = 12; // Cycles per superframe (see tdma/superframe.h); must divide evenly into 86400 / kCycleDurationSec
+    static const unsigned long kMicroSlotGuard = 1000;    // µs of silence between micro-slots, for clock and loop latency
+    static const unsigned int kMaxMicroSlotCount = 4;     // Upper bound on micro-slots per data slot; every one multiplies the roster's RAM
+
+    // Channel plan for rover data slots (see tdma/channel_plan.h); channels are RF95_CHANNEL_SPACING apart, starting at
+    // RF95_FREQ
+    static const nautic_net::tdma::ChannelPlan kChannelPlan = nautic_net::tdma::ChannelPlan::kSingle;
+    static const unsigned int kChannelCount = 4;
 
     // Base station configuration
     static const unsigned int kMaxRoverCount = 8; // The number of supported rovers; must divide evenly into tdma::kRoverDataSlotCount
@@ -30,15 +42,28 @@ namespace nautic_net::config
     static const uint8_t kLoraPower = 20; // dBm (0 through 20)
 
     // The FIXED radio mode for rover discovery and configuration (slots 0 and 1)
-    static const nautic_net::hw::radio::Config kLoraDefaultConfig = {
-        .sbw = 500, // kHz (125, 250, or 500)
-        .sf = 7     // Spreading factor (7 through 12)
+    static constexpr nautic_net::hw::radio::Config kLoraDefaultConfig = {
+        .sbw = 500,                // kHz (125, 250, or 500)
+        .sf = 7,                   // Spreading factor (7 through 12)
+        .channel = 0,              // Always 0 for discovery and configuration
+        .coding_rate = 5,          // 4/5
+        .preamble = 8,             // Symbols; unsynchronized rovers listen here, so keep RadioHead's default
+        .is_implicit_header = false,
+        .implicit_length = 0
     };
 
-    // The CONFIGURABLE radio mode for rover data, which is handed out to the rovers from the base
-    static const nautic_net::hw::radio::Config kLoraRoverDataConfig = {
-        .sbw = 500, // kHz (125, 250, or 500)
-        .sf = 9     // Spreading factor (7 through 12)
+    // The CONFIGURABLE radio mode for rover data, which is handed out to the rovers from the base. Data slots are
+    // GPS-timed, so the base is already listening when a frame starts and the shortest preamble is enough. Run
+    // tools/airtime_table before changing the header mode: implicit frames are padded to tdma::kRoverDataFrameSize,
+    // which usually costs more than the header saves.
+    static constexpr nautic_net::hw::radio::Config kLoraRoverDataConfig = {
+        .sbw = 500,                // kHz (125, 250, or 500)
+        .sf = 9,                   // Spreading factor (7 through 12)
+        .channel = 0,              // Replaced per slot, according to kChannelPlan
+        .coding_rate = 5,          // 4/5; raised per rover on weak links, as far as the micro-slot allows
+        .preamble = 6,             // Symbols
+        .is_implicit_header = false,
+        .implicit_length = 0       // Set per slot from tdma::kRoverDataFrameSize
     };
 
     // Serial logging configuration
@@ -23,4 +23,13 @@
 #define debugln2(x, y)
 #endif
 
+// Cheap enough for timing-sensitive code, unlike debug(); see nautic_net/trace.h
+#ifdef TRACE
+#include "nautic_net/trace.h"
+
+#define trace(event, a, b) nautic_net::trace::kTrace.Record(nautic_net::trace::Event::event, a, b)
+#else
+#define trace(event, a, b)
+#endif
+
 #endif
\ No newline at end of file
@@ -21,4 +21,22 @@ PB_BIND(RoverConfiguration, RoverConfiguration, 2)
 PB_BIND(RoverReset, RoverReset, AUTO)
 
 
+PB_BIND(BackfillRequest, BackfillRequest, AUTO)
+
+
+PB_BIND(BaseBeacon, BaseBeacon, AUTO)
+
+
+PB_BIND(BackfillDelta, BackfillDelta, AUTO)
+
+
+PB_BIND(RoverBackfill, RoverBackfill, AUTO)
+
+
+PB_BIND(RoverAssignment, RoverAssignment, AUTO)
+
+
+PB_BIND(RoverConfigurationBatch, RoverConfigurationBatch, 2)
+
+
 
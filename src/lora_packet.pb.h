@@ -19,11 +19,13 @@ typedef struct _RoverData {
     uint32_t cog; /* degrees, fixed-point decimal with 0.1 precision, 0 to 3600 */
     uint32_t sog; /* knots, fixed-point decimal with 0.1 precision */
     uint32_t battery; /* percent, 0 implies null */
+    uint32_t sequence; /* counts data frames, modulo 128, so receivers can tell how many were lost */
 } RoverData;
 
 /* Message from a newly-powered-on rover, asking base station for configuration */
 typedef struct _RoverDiscovery {
-    char dummy_field;
+    /* Requested rate class: transmit every Nth cycle (0 is the same as 1) */
+    uint32_t period;
 } RoverDiscovery;
 
 /* Message from the base station to a new rover, configuring it for communication */
@@ -43,6 +45,97 @@ typedef struct _RoverReset {
     char dummy_field;
 } RoverReset;
 
+/* Data frames the base station hasn't heard from one rover, which it should resend from its history */
+typedef struct _BackfillRequest {
+    /* RoverAssignment.address of the rover */
+    uint32_t address;
+    /* RoverData.sequence of the oldest missing frame */
+    uint32_t sequence;
+    /* Bit n set: sequence + n (modulo 128) is missing too; bit 0 is always set */
+    uint32_t missing;
+    /* 1 + a slot set nobody transmits in for the rest of this cycle, lent to the rover for backfill; 0 for none */
+    uint32_t slot_set;
+    /* Micro-slot within the lent slot set */
+    uint32_t micro_slot;
+} BackfillRequest;
+
+/* Periodic broadcast from the base station, sent in configuration slots that have nothing else to send */
+typedef struct _BaseBeacon {
+    /* Minimum number of discovery slots an unconfigured rover should spread its discovery attempts over */
+    uint32_t contention_window;
+    pb_size_t backfill_requests_count;
+    BackfillRequest backfill_requests[4];
+} BaseBeacon;
+
+/* A resent sample, as the difference from the one before it in the same RoverBackfill */
+typedef struct _BackfillDelta {
+    /* RoverData.sequence steps since the previous sample, less one */
+    uint32_t sequence;
+    /* TDMA slots since the previous sample was sent */
+    uint32_t slots;
+    /* degrees * 1e7 */
+    int32_t latitude;
+    /* degrees * 1e7 */
+    int32_t longitude;
+    /* In RoverData's units */
+    int32_t heading;
+    int32_t heel;
+    int32_t cog;
+    int32_t sog;
+} BackfillDelta;
+
+/* Samples the base station missed (see BackfillRequest), resent from the rover's history in spare slots: the oldest
+ in full, with the cycle and slot it was first sent in, and the rest as deltas */
+typedef struct _RoverBackfill {
+    /* RoverData.sequence of the first sample */
+    uint32_t sequence;
+    /* Cycle of the day (see tdma/superframe.h) and slot the first sample was sent in */
+    uint32_t cycle;
+    uint32_t slot;
+    /* degrees * 1e7 */
+    int32_t latitude;
+    /* degrees * 1e7 */
+    int32_t longitude;
+    /* In RoverData's units */
+    uint32_t heading;
+    uint32_t heel;
+    uint32_t cog;
+    uint32_t sog;
+    pb_size_t deltas_count;
+    BackfillDelta deltas[4];
+} RoverBackfill;
+
+/* One rover's TDMA assignment: it sends RoverData in slots offset + i * interval, for i < count */
+typedef struct _RoverAssignment {
+    uint32_t hardware_id;
+    uint32_t offset;
+    uint32_t interval;
+    uint32_t count;
+    /* LoRa bandwidth (kHz) when sending RoverData */
+    uint32_t sbw;
+    /* LoRa spreading factor when sending RoverData */
+    uint32_t sf;
+    /* Channel when sending RoverData, for channel plans that assign one */
+    uint32_t channel;
+    /* Send only in cycles where cycle % period == phase (period 0 is the same as 1) */
+    uint32_t period;
+    uint32_t phase;
+    /* Micro-slot within each data slot */
+    uint32_t micro_slot;
+    /* Network address to put in LoRaPacket.address (1 or more) */
+    uint32_t address;
+    /* LoRa coding rate denominator (5 through 8) when sending RoverData; 0 for the default */
+    uint32_t coding_rate;
+} RoverAssignment;
+
+/* Message from the base station configuring several rovers at once; each rover picks out its own assignment */
+typedef struct _RoverConfigurationBatch {
+    pb_size_t assignments_count;
+    RoverAssignment assignments[8];
+    /* Same as BaseBeacon.contention_window, since this replaces the beacon in its configuration slot */
+    uint32_t contention_window;
+} RoverConfigurationBatch;
+
 typedef struct _LoRaPacket {
     /* The fixed hardware identifier for the rover, based on the serial number of the ARM Cortex chip */
     uint32_t hardware_id;
@@ -52,9 +145,15 @@ typedef struct _LoRaPacket {
         RoverDiscovery rover_discovery;
         RoverConfiguration rover_configuration;
         RoverReset rover_reset;
+        BaseBeacon base_beacon;
+        RoverConfigurationBatch rover_configuration_batch;
+        RoverBackfill rover_backfill;
     } payload;
     /* A logical, human-friendly identifier for the rover */
     uint32_t serial_number;
+    /* Short network address assigned by the base (RoverAssignment.address); once a rover has one, most of its
+ RoverData frames carry only this instead of hardware_id and serial_number */
+    uint32_t address;
 } LoRaPacket;
 
 
@@ -63,16 +162,28 @@ extern "C" {
 #endif
 
 /* Initializer values for message structs */
-#define LoRaPacket_init_default                  {0, 0, {RoverData_init_default}, 0}
-#define RoverData_init_default                   {0, 0, 0, 0, 0, 0, 0}
+#define LoRaPacket_init_default                  {0, 0, {RoverData_init_default}, 0, 0}
+#define RoverData_init_default                   {0, 0, 0, 0, 0, 0, 0, 0}
 #define RoverDiscovery_init_default              {0}
 #define RoverConfiguration_init_default          {0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 0, 0}
 #define RoverReset_init_default                  {0}
-#define LoRaPacket_init_zero                     {0, 0, {RoverData_init_zero}, 0}
-#define RoverData_init_zero                      {0, 0, 0, 0, 0, 0, 0}
+#define BackfillRequest_init_default             {0, 0, 0, 0, 0}
+#define BaseBeacon_init_default                  {0, 0, {BackfillRequest_init_default, BackfillRequest_init_default, BackfillRequest_init_default, BackfillRequest_init_default}}
+#define BackfillDelta_init_default               {0, 0, 0, 0, 0, 0, 0, 0}
+#define RoverBackfill_init_default               {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {BackfillDelta_init_default, BackfillDelta_init_default, BackfillDelta_init_default, BackfillDelta_init_default}}
+#define RoverAssignment_init_default             {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define RoverConfigurationBatch_init_default     {0, {RoverAssignment_init_default, RoverAssignment_init_default, RoverAssignment_init_default, RoverAssignment_init_default, RoverAssignment_init_default, RoverAssignment_init_default, RoverAssignment_init_default, RoverAssignment_init_default}, 0}
+#define LoRaPacket_init_zero                     {0, 0, {RoverData_init_zero}, 0, 0}
+#define RoverData_init_zero                      {0, 0, 0, 0, 0, 0, 0, 0}
 #define RoverDiscovery_init_zero                 {0}
 #define RoverConfiguration_init_zero             {0, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 0, 0}
 #define RoverReset_init_zero                     {0}
+#define BackfillRequest_init_zero                {0, 0, 0, 0, 0}
+#define BaseBeacon_init_zero                     {0, 0, {BackfillRequest_init_zero, BackfillRequest_init_zero, BackfillRequest_init_zero, BackfillRequest_init_zero}}
+#define BackfillDelta_init_zero                  {0, 0, 0, 0, 0, 0, 0, 0}
+#define RoverBackfill_init_zero                  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {BackfillDelta_init_zero, BackfillDelta_init_zero, BackfillDelta_init_zero, BackfillDelta_init_zero}}
+#define RoverAssignment_init_zero                {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define RoverConfigurationBatch_init_zero        {0, {RoverAssignment_init_zero, RoverAssignment_init_zero, RoverAssignment_init_zero, RoverAssignment_init_zero, RoverAssignment_init_zero, RoverAssignment_init_zero, RoverAssignment_init_zero, RoverAssignment_init_zero}, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define RoverData_latitude_tag                   1
@@ -82,15 +193,60 @@ extern "C" {
 #define RoverData_cog_tag                        5
 #define RoverData_sog_tag                        6
 #define RoverData_battery_tag                    7
+#define RoverData_sequence_tag                   8
+#define RoverDiscovery_period_tag                1
 #define RoverConfiguration_slots_tag             1
 #define RoverConfiguration_sbw_tag               2
 #define RoverConfiguration_sf_tag                3
+#define BackfillRequest_address_tag              1
+#define BackfillRequest_sequence_tag             2
+#define BackfillRequest_missing_tag              3
+#define BackfillRequest_slot_set_tag             4
+#define BackfillRequest_micro_slot_tag           5
+#define BaseBeacon_contention_window_tag         1
+#define BaseBeacon_backfill_requests_tag         2
+#define BackfillDelta_sequence_tag               1
+#define BackfillDelta_slots_tag                  2
+#define BackfillDelta_latitude_tag               3
+#define BackfillDelta_longitude_tag              4
+#define BackfillDelta_heading_tag                5
+#define BackfillDelta_heel_tag                   6
+#define BackfillDelta_cog_tag                    7
+#define BackfillDelta_sog_tag                    8
+#define RoverBackfill_sequence_tag               1
+#define RoverBackfill_cycle_tag                  2
+#define RoverBackfill_slot_tag                   3
+#define RoverBackfill_latitude_tag               4
+#define RoverBackfill_longitude_tag              5
+#define RoverBackfill_heading_tag                6
+#define RoverBackfill_heel_tag                   7
+#define RoverBackfill_cog_tag                    8
+#define RoverBackfill_sog_tag                    9
+#define RoverBackfill_deltas_tag                 10
+#define RoverAssignment_hardware_id_tag          1
+#define RoverAssignment_offset_tag               2
+#define RoverAssignment_interval_tag             3
+#define RoverAssignment_count_tag                4
+#define RoverAssignment_sbw_tag                  5
+#define RoverAssignment_sf_tag                   6
+#define RoverAssignment_channel_tag              7
+#define RoverAssignment_period_tag               8
+#define RoverAssignment_phase_tag                9
+#define RoverAssignment_micro_slot_tag           10
+#define RoverAssignment_address_tag              11
+#define RoverAssignment_coding_rate_tag          12
+#define RoverConfigurationBatch_assignments_tag  1
+#define RoverConfigurationBatch_contention_window_tag 2
 #define LoRaPacket_hardware_id_tag               1
 #define LoRaPacket_rover_data_tag                2
 #define LoRaPacket_rover_discovery_tag           3
 #define LoRaPacket_rover_configuration_tag       4
 #define LoRaPacket_rover_reset_tag               6
+#define LoRaPacket_base_beacon_tag               7
+#define LoRaPacket_rover_configuration_batch_tag 8
 #define LoRaPacket_serial_number_tag             5
+#define LoRaPacket_address_tag                   9
+#define LoRaPacket_rover_backfill_tag            10
 
 /* Struct field encoding specification for nanopb */
 #define LoRaPacket_FIELDLIST(X, a) \
@@ -99,13 +255,20 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_data,payload.rover_data),   2)
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_discovery,payload.rover_discovery),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_configuration,payload.rover_configuration),   4) \
 X(a, STATIC,   SINGULAR, UINT32,   serial_number,     5) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_reset,payload.rover_reset),   6)
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_reset,payload.rover_reset),   6) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,base_beacon,payload.base_beacon),   7) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_configuration_batch,payload.rover_configuration_batch),   8) \
+X(a, STATIC,   SINGULAR, UINT32,   address,           9) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload,rover_backfill,payload.rover_backfill),  10)
 #define LoRaPacket_CALLBACK NULL
 #define LoRaPacket_DEFAULT NULL
 #define LoRaPacket_payload_rover_data_MSGTYPE RoverData
 #define LoRaPacket_payload_rover_discovery_MSGTYPE RoverDiscovery
 #define LoRaPacket_payload_rover_configuration_MSGTYPE RoverConfiguration
 #define LoRaPacket_payload_rover_reset_MSGTYPE RoverReset
+#define LoRaPacket_payload_base_beacon_MSGTYPE BaseBeacon
+#define LoRaPacket_payload_rover_configuration_batch_MSGTYPE RoverConfigurationBatch
+#define LoRaPacket_payload_rover_backfill_MSGTYPE RoverBackfill
 
 #define RoverData_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, FLOAT,    latitude,          1) \
@@ -114,12 +277,13 @@ X(a, STATIC,   SINGULAR, UINT32,   heading,           3) \
 X(a, STATIC,   SINGULAR, UINT32,   heel,              4) \
 X(a, STATIC,   SINGULAR, UINT32,   cog,               5) \
 X(a, STATIC,   SINGULAR, UINT32,   sog,               6) \
-X(a, STATIC,   SINGULAR, UINT32,   battery,           7)
+X(a, STATIC,   SINGULAR, UINT32,   battery,           7) \
+X(a, STATIC,   SINGULAR, UINT32,   sequence,          8)
 #define RoverData_CALLBACK NULL
 #define RoverData_DEFAULT NULL
 
 #define RoverDiscovery_FIELDLIST(X, a) \
-
+X(a, STATIC,   SINGULAR, UINT32,   period,            1)
 #define RoverDiscovery_CALLBACK NULL
 #define RoverDiscovery_DEFAULT NULL
 
@@ -135,11 +299,83 @@ X(a, STATIC,   SINGULAR, UINT32,   sf,                3)
 #define RoverReset_CALLBACK NULL
 #define RoverReset_DEFAULT NULL
 
+#define BackfillRequest_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   address,           1) \
+X(a, STATIC,   SINGULAR, UINT32,   sequence,          2) \
+X(a, STATIC,   SINGULAR, FIXED32,  missing,           3) \
+X(a, STATIC,   SINGULAR, UINT32,   slot_set,          4) \
+X(a, STATIC,   SINGULAR, UINT32,   micro_slot,        5)
+#define BackfillRequest_CALLBACK NULL
+#define BackfillRequest_DEFAULT NULL
+
+#define BaseBeacon_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   contention_window,   1) \
+X(a, STATIC,   REPEATED, MESSAGE,  backfill_requests,   2)
+#define BaseBeacon_CALLBACK NULL
+#define BaseBeacon_DEFAULT NULL
+#define BaseBeacon_backfill_requests_MSGTYPE BackfillRequest
+
+#define BackfillDelta_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   sequence,          1) \
+X(a, STATIC,   SINGULAR, UINT32,   slots,             2) \
+X(a, STATIC,   SINGULAR, SINT32,   latitude,          3) \
+X(a, STATIC,   SINGULAR, SINT32,   longitude,         4) \
+X(a, STATIC,   SINGULAR, SINT32,   heading,           5) \
+X(a, STATIC,   SINGULAR, SINT32,   heel,              6) \
+X(a, STATIC,   SINGULAR, SINT32,   cog,               7) \
+X(a, STATIC,   SINGULAR, SINT32,   sog,               8)
+#define BackfillDelta_CALLBACK NULL
+#define BackfillDelta_DEFAULT NULL
+
+#define RoverBackfill_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   sequence,          1) \
+X(a, STATIC,   SINGULAR, UINT32,   cycle,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   slot,              3) \
+X(a, STATIC,   SINGULAR, SFIXED32, latitude,          4) \
+X(a, STATIC,   SINGULAR, SFIXED32, longitude,         5) \
+X(a, STATIC,   SINGULAR, UINT32,   heading,           6) \
+X(a, STATIC,   SINGULAR, UINT32,   heel,              7) \
+X(a, STATIC,   SINGULAR, UINT32,   cog,               8) \
+X(a, STATIC,   SINGULAR, UINT32,   sog,               9) \
+X(a, STATIC,   REPEATED, MESSAGE,  deltas,           10)
+#define RoverBackfill_CALLBACK NULL
+#define RoverBackfill_DEFAULT NULL
+#define RoverBackfill_deltas_MSGTYPE BackfillDelta
+
+#define RoverAssignment_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, FIXED32,  hardware_id,       1) \
+X(a, STATIC,   SINGULAR, UINT32,   offset,            2) \
+X(a, STATIC,   SINGULAR, UINT32,   interval,          3) \
+X(a, STATIC,   SINGULAR, UINT32,   count,             4) \
+X(a, STATIC,   SINGULAR, UINT32,   sbw,               5) \
+X(a, STATIC,   SINGULAR, UINT32,   sf,                6) \
+X(a, STATIC,   SINGULAR, UINT32,   channel,           7) \
+X(a, STATIC,   SINGULAR, UINT32,   period,            8) \
+X(a, STATIC,   SINGULAR, UINT32,   phase,             9) \
+X(a, STATIC,   SINGULAR, UINT32,   micro_slot,       10) \
+X(a, STATIC,   SINGULAR, UINT32,   address,          11) \
+X(a, STATIC,   SINGULAR, UINT32,   coding_rate,      12)
+#define RoverAssignment_CALLBACK NULL
+#define RoverAssignment_DEFAULT NULL
+
+#define RoverConfigurationBatch_FIELDLIST(X, a) \
+X(a, STATIC,   REPEATED, MESSAGE,  assignments,       1) \
+X(a, STATIC,   SINGULAR, UINT32,   contention_window,   2)
+#define RoverConfigurationBatch_CALLBACK NULL
+#define RoverConfigurationBatch_DEFAULT NULL
+#define RoverConfigurationBatch_assignments_MSGTYPE RoverAssignment
+
 extern const pb_msgdesc_t LoRaPacket_msg;
 extern const pb_msgdesc_t RoverData_msg;
 extern const pb_msgdesc_t RoverDiscovery_msg;
 extern const pb_msgdesc_t RoverConfiguration_msg;
 extern const pb_msgdesc_t RoverReset_msg;
+extern const pb_msgdesc_t BackfillRequest_msg;
+extern const pb_msgdesc_t BaseBeacon_msg;
+extern const pb_msgdesc_t BackfillDelta_msg;
+extern const pb_msgdesc_t RoverBackfill_msg;
+extern const pb_msgdesc_t RoverAssignment_msg;
+extern const pb_msgdesc_t RoverConfigurationBatch_msg;
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
 #define LoRaPacket_fields &LoRaPacket_msg
@@ -147,12 +383,24 @@ extern const pb_msgdesc_t RoverReset_msg;
 #define RoverDiscovery_fields &RoverDiscovery_msg
 #define RoverConfiguration_fields &RoverConfiguration_msg
 #define RoverReset_fields &RoverReset_msg
+#define BackfillRequest_fields &BackfillRequest_msg
+#define BaseBeacon_fields &BaseBeacon_msg
+#define BackfillDelta_fields &BackfillDelta_msg
+#define RoverBackfill_fields &RoverBackfill_msg
+#define RoverAssignment_fields &RoverAssignment_msg
+#define RoverConfigurationBatch_fields &RoverConfigurationBatch_msg
 
 /* Maximum encoded size of messages (where known) */
-#define LoRaPacket_size                          1126
+#define BackfillDelta_size                       48
+#define BackfillRequest_size                     29
+#define BaseBeacon_size                          130
+#define LoRaPacket_size                          1132
+#define RoverAssignment_size                     71
+#define RoverBackfill_size                       252
+#define RoverConfigurationBatch_size             590
 #define RoverConfiguration_size                  1112
-#define RoverData_size                           40
-#define RoverDiscovery_size                      0
+#define RoverData_size                           46
+#define RoverDiscovery_size                      6
 #define RoverReset_size                          0
 
 #ifdef __cplusplus
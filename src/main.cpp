@@ -2,37 +2,36 @@
 #include <Adafruit_Sensor.h>
 #include <Arduino.h>
 
+#include "commands.h"
 #include "debug.h"
 #include "lora_packet.pb.h"
 #include "main.h"
-#include "nautic_net/base.h"
-#include "nautic_net/hw/eeprom.h"
-#include "nautic_net/hw/gps.h"
-#include "nautic_net/hw/imu.h"
-#include "nautic_net/hw/radio.h"
-#include "nautic_net/rover.h"
-#include "nautic_net/tdma.h"
 #include "nautic_net/util.h"
 
 using namespace nautic_net;
 
 Mode kMode = Mode::kRover;
 
+memory::Memory kMemory;
+profiler::Profiler kProfiler;
 hw::eeprom::EEPROM kEEPROM;
-hw::radio::Radio kRadio;
+hw::radio::Radio kRadio(&kProfiler);
 hw::imu::IMU kIMU(&kEEPROM);
-hw::gps::GPS kGPS(&Serial1, config::kPinGPSPPS);
+hw::gps::GPS kGPS(&Serial1, config::kPinGPSPPS, &kEEPROM);
 rover::Rover kRover(&kRadio, &kGPS, &kIMU, &kEEPROM);
-base::Base kBase(&kRadio);
+base::Base kBase(&kRadio, &kEEPROM);
 tdma::TDMA kTDMA;
+trace::Trace trace::kTrace;
+console::Console kConsole(&Serial);
+boot::Boot kBoot(&kEEPROM, &kRadio, &kIMU, &kGPS, &kRover, &kBase);
 
-static const int kSerialBufferSize = 128;
-char serial_buffer_[kSerialBufferSize];
-uint16_t serial_buffer_index_;
 // bool is_serial_connected_;
 
 void setup()
 {
+  // Before anything gets a chance to use the stack deeply
+  kMemory.PaintStack();
+
   // A0 is disconnected, so we can seed with random noise
   randomSeed(analogRead(0));
 
@@ -57,30 +56,29 @@ void setup()
   // Serial and debug
   Serial.begin(115200);
   debugWait();
+  RegisterCommands(&kConsole);
 
-  // Configure rover-only hardware
-  if (kMode == Mode::kRover)
-  {
-    kEEPROM.Setup();
-    kIMU.Setup();
-    kRover.Setup();
-  }
-
-  // Configure common hardware
-  kRadio.Setup();
-  kGPS.Setup();
+  // Rovers only decode frames addressed to them; the base logs everything
+  kRadio.SetFilter(kMode == Mode::kRover ? rover::Rover::IsForMe : nullptr);
 
-  // Can't continue until GPS has a fix, because we need accurate timing
-  kGPS.WaitForFix();
+  // Starts GPS acquisition; the rest of the hardware comes up in loop() while the GPS acquires
+  kBoot.Setup(kMode == Mode::kBase);
 }
 
 void loop()
 {
+  unsigned long loop_started_at = micros();
+
+  //
+  // Bring up hardware without blocking
+  //
+  kBoot.Loop();
+
   //
   // Sync TDMA at the top of every 10th second
   //
-  int second = kGPS.GetSyncedSecond();
-  kTDMA.SyncToGPS(second);
+  long second_of_day = kGPS.GetSyncedSecondOfDay();
+  kTDMA.SyncToGPS(second_of_day);
   kGPS.Read();
 
   //
@@ -91,9 +89,16 @@ void loop()
   //
   // Handle slot transitions
   //
+  // TDMA only starts once the GPS has a fix, because we need accurate timing. Until then, the base station can
+  // already receive and log traffic from rovers that are ahead of it.
+  //
+  bool is_radio_ready = kBoot.IsReady(boot::Subsystem::kRadio);
   tdma::Slot newSlot;
-  if (kTDMA.TryGetSlotTransition(&newSlot))
+  if (kTDMA.TryGetSlotTransition(&newSlot) && is_radio_ready)
   {
+    unsigned long slot_started_at = micros();
+    trace(kSlot, newSlot.number, newSlot.cycle);
+
     switch (kMode)
     {
     case Mode::kRover:
@@ -104,14 +109,17 @@ void loop()
       kBase.HandleSlot(newSlot);
       break;
     }
+
+    kProfiler.Record(profiler::Section::kSlot, slot_started_at);
   }
 
   //
   // Handle received packets
   //
+  unsigned long receive_started_at = micros();
   LoRaPacket rx_packet;
   int rssi;
-  if (kRadio.TryReceive(&rx_packet, &rssi))
+  if (is_radio_ready && kRadio.TryReceive(&rx_packet, &rssi))
   {
     switch (kMode)
     {
@@ -123,6 +131,8 @@ void loop()
       kBase.HandlePacket(rx_packet, rssi);
       break;
     }
+
+    kProfiler.Record(profiler::Section::kReceive, receive_started_at);
   }
 
   //
@@ -132,8 +142,6 @@ void loop()
   // {
   //   delay(50);
   //   PrintNarwin();
-  //   PrintEEPROM();
-  //   PrintStatus();
   //   is_serial_connected_ = true;
   // }
   // else if (!Serial && is_serial_connected_)
@@ -141,73 +149,14 @@ void loop()
   //   is_serial_connected_ = false;
   // }
 
-  if (Serial.available())
-  {
-    char byte = Serial.read();
-    serial_buffer_[serial_buffer_index_] = byte;
+  unsigned long console_started_at = micros();
+  kConsole.Loop();
+  kProfiler.Record(profiler::Section::kConsole, console_started_at);
 
-    // Use line feed (LF) as the line separator
-    if (byte == '\n')
-    {
-      // Replace \n with null terminator
-      serial_buffer_[serial_buffer_index_] = 0;
-
-      // If a CRLF ("\r\n") was used as the line terminator, replace \r with null terminator, too
-      if (serial_buffer_index_ >= 1 && serial_buffer_[serial_buffer_index_ - 1] == '\r')
-      {
-        serial_buffer_[serial_buffer_index_ - 1] = 0;
-      }
-
-      switch (serial_buffer_[0])
-      {
-      case 'c': // Begin compass cal
-        kIMU.BeginCompassCalibration();
-        break;
-
-      case 'e': // Read EEPROM
-        PrintEEPROM();
-        break;
-
-      case 'f': // Finish compass cal
-        kIMU.FinishCompassCalibration();
-        break;
-
-      case 's': // Read or write serial number
-      {
-        if (serial_buffer_index_ == 1)
-        {
-          Serial.print("Serial number: ");
-          Serial.println(kEEPROM.ReadSerialNumber());
-        }
-        else
-        {
-          // Convert "s12345" to an integer
-          uint32_t new_serial_number_ = (uint32_t)atoi(serial_buffer_ + 1);
-
-          kEEPROM.WriteSerialNumber(new_serial_number_);
-          Serial.print("New serial number: ");
-          Serial.println(new_serial_number_);
-        }
-        break;
-      }
-
-      case 'z': // Reset EEPROM to default values
-        kEEPROM.Reset();
-        Serial.println("Reset EEPROM to default values");
-        break;
-
-      case '?': // Print general info
-        PrintStatus();
-        break;
-      }
-
-      serial_buffer_index_ = 0;
-    }
-    else
-    {
-      serial_buffer_index_ = (serial_buffer_index_ + 1) % kSerialBufferSize;
-    }
-  }
+  //
+  // Trace frames, if the host asked for them
+  //
+  trace::kTrace.Loop();
 
   //
   // Give some processor time
@@ -215,53 +164,21 @@ void loop()
   switch (kMode)
   {
   case Mode::kRover:
-    kRover.Loop();
+    if (kBoot.IsSettled(boot::Subsystem::kEEPROM))
+    {
+      kRover.Loop();
+    }
     break;
 
   case Mode::kBase:
-    // nothing yet
+    if (kBoot.IsSettled(boot::Subsystem::kEEPROM))
+    {
+      kBase.Loop();
+    }
     break;
   }
-}
-
-void PrintEEPROM()
-{
-  Serial.print("Serial number: ");
-  Serial.println(kEEPROM.ReadSerialNumber());
-
-  nautic_net::hw::eeprom::CompassCalibration cal = kEEPROM.ReadCompassCalibration();
-  Serial.print("Compass cal X: ");
-  Serial.println(cal.x);
 
-  Serial.print("Compass cal Y: ");
-  Serial.println(cal.y);
-
-  Serial.print("Compass cal Z: ");
-  Serial.println(cal.z);
-}
-
-void PrintStatus()
-{
-  Serial.println("--- STATUS ---");
-
-  Serial.print("Firmware: ");
-  Serial.println(config::kFirmwareVersion);
-
-  Serial.print("Battery: ");
-  Serial.print(util::ReadBatteryVoltage(), 2);
-  Serial.print("V (");
-  Serial.print(util::ReadBatteryPercentage());
-  Serial.println("%)");
-
-  Serial.print("Mode: ");
-  if (kMode == Mode::kBase)
-  {
-    Serial.println("Base Station");
-  }
-  else
-  {
-    Serial.println("Rover");
-  }
+  kProfiler.Record(profiler::Section::kLoop, loop_started_at);
 }
 
 void PrintNarwin()
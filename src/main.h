@@ -1,14 +1,39 @@
 #ifndef MAIN_H
 #define MAIN_H
 
+#include "nautic_net/base.h"
+#include "nautic_net/boot.h"
+#include "nautic_net/console.h"
+#include "nautic_net/hw/eeprom.h"
+#include "nautic_net/hw/gps.h"
+#include "nautic_net/hw/imu.h"
+#include "nautic_net/hw/radio.h"
+#include "nautic_net/memory_stats.h"
+#include "nautic_net/profiler.h"
+#include "nautic_net/rover.h"
+#include "nautic_net/tdma.h"
+#include "nautic_net/trace.h"
+
 enum class Mode
 {
     kRover,
     kBase
 };
 
-void PrintEEPROM();
+// Defined in main.cpp, shared with the serial commands in commands.cpp
+extern Mode kMode;
+extern nautic_net::hw::eeprom::EEPROM kEEPROM;
+extern nautic_net::hw::radio::Radio kRadio;
+extern nautic_net::hw::imu::IMU kIMU;
+extern nautic_net::hw::gps::GPS kGPS;
+extern nautic_net::rover::Rover kRover;
+extern nautic_net::base::Base kBase;
+extern nautic_net::tdma::TDMA kTDMA;
+extern nautic_net::console::Console kConsole;
+extern nautic_net::profiler::Profiler kProfiler;
+extern nautic_net::memory::Memory kMemory;
+extern nautic_net::boot::Boot kBoot;
+
 void PrintNarwin();
-void PrintStatus();
 
-#endif
\ No newline at end of file
+#endif
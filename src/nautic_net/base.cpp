@@ -4,89 +4,290 @@
 
 using namespace nautic_net::base;
 
-Base::Base(nautic_net::hw::radio::Radio *radio) : radio_(radio)
+Base::Base(nautic_net::hw::radio::Radio *radio, nautic_net::hw::eeprom::EEPROM *eeprom)
+    : radio_(radio), eeprom_(eeprom), backlog_(eeprom)
 {
 }
 
-void Base::DiscoverRover(LoRaPacket packet)
+void Base::Setup()
 {
-    int rover_index = FindRoverIndex(packet.hardware_id);
+    // Not in the constructor: the slot types it reads are static objects in another translation unit
+    ClearSlotSets();
+    ClearLentSlotSets();
+    backlog_.Setup();
 
-    if (rover_index == -1)
+    if (TryLoadRoster())
     {
-        debug("Found a new rover: ");
-        debugln2(packet.hardware_id, 16);
+        // The rovers in the roster resume their persisted configurations too, so don't knock them all back into
+        // discovery; anything that conflicts with the roster gets reset or reconfigured individually
+        debugln("Resumed persisted roster");
+        reset_sent_count_ = kResetBroadcastCount;
+    }
+}
 
-        // Determine the next set of slots to hand out
-        while (true)
-        {
-            next_base_slot_ = (next_base_slot_ + tdma::kSlotCountPerTransmit) % tdma::kRoverSlotInterval;
+void Base::HandleRadioReady()
+{
+    // Until the GPS has a fix and slots begin, listen for data rather than discoveries: rovers that resumed their
+    // configuration (see TryLoadRoster()) are already transmitting, and their frames would go unlogged at the default
+    // profile. Only channel 0 under plans with several.
+    if (current_slot_.number == -1)
+    {
+        hw::radio::Config rx_config = config::kLoraRoverDataConfig;
+        rx_config.implicit_length = tdma::kRoverDataImplicitLength;
+        radio_->Configure(rx_config);
+    }
+}
 
-            if (tdma::TDMA::GetSlotType(next_base_slot_) == tdma::SlotType::kRoverData)
-            {
-                break;
-            }
+void Base::Loop()
+{
+    // Backlog I2C blocks the loop, so only start a transaction that ends before the next slot transition, where the
+    // radio gets reconfigured and may have to transmit on time
+    if (current_slot_.number != -1)
+    {
+        long remaining = tdma::TDMA::GetNextSlot(current_slot_).started_at - micros();
+        if (remaining < (long)(Backlog::GetTransferTime() + kBacklogGuard))
+        {
+            return;
         }
+    }
 
-        // Wrap around if we have too many rovers
-        rover_index = rover_count_ % tdma::kMaxRoverCount;
-        rover_count_ = min(rover_count_ + 1, tdma::kMaxRoverCount);
+    // Drained records go out between live ones, a batch per loop, as fast as USB takes them
+    LoggedRover drained[Backlog::kMaxTransferRecords];
+    unsigned int count = backlog_.Step(IsHostConnected(), drained);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        PrintLoggedRover(drained[i], true);
+    }
+}
 
-        // TODO: Deallocate a RoverInfo if it already exists at rover_index?
+void Base::DiscoverRover(LoRaPacket packet, int rssi)
+{
+    unsigned int rover_index = roster_.Find(packet.hardware_id);
+    unsigned int period = tdma::GetValidPeriod(packet.payload.rover_discovery.period, tdma::kSuperframeCycleCount);
 
-        rovers_[rover_index] = new RoverInfo(packet.hardware_id, packet.serial_number);
-        rovers_[rover_index]->radio_config_ = config::kLoraRoverDataConfig;
+    if (rover_index == Roster::kNotFound)
+    {
+        debug("Found a new rover: ");
+        debugln2(packet.hardware_id, 16);
 
-        for (unsigned int i = 0; i < tdma::kRoverSlotCount; i++)
+        // Hand out the lowest free (channel, slot set, phase) that fits the requested rate class
+        int slot_set_index = roster_.IsFull() ? -1 : AllocateSlotSet(period);
+        if (slot_set_index < 0)
         {
-            rovers_[rover_index]->slots_[i] = next_base_slot_ + (tdma::kRoverSlotInterval * i);
+            debugln("No free slots for this rate class; ignoring rover");
+            return;
         }
+
+        rover_index = roster_.Insert(packet.hardware_id);
+        roster_.serial_numbers_[rover_index] = packet.serial_number;
+        roster_.sbws_[rover_index] = config::kLoraRoverDataConfig.sbw;
+        roster_.sfs_[rover_index] = config::kLoraRoverDataConfig.sf;
+        roster_.coding_rates_[rover_index] = SelectCodingRate(rssi, config::kLoraRoverDataConfig.coding_rate);
+        AssignSlotSet(rover_index, slot_set_index, period);
+
+        SaveRoster();
     }
     else
     {
         debug("Rediscovered existing rover: ");
         debugln2(packet.hardware_id, 16);
+
+        // The rover asked for a different rate class
+        if (period != roster_.periods_[rover_index])
+        {
+            ReleaseSlotSet(rover_index);
+
+            int slot_set_index = AllocateSlotSet(period);
+            if (slot_set_index < 0)
+            {
+                debugln("No free slots for the new rate class; keeping the old one");
+                ReserveSlotSet(rover_index);
+            }
+            else
+            {
+                AssignSlotSet(rover_index, slot_set_index, period);
+                SaveRoster();
+            }
+        }
     }
 
     // Enqueue for TX later
-    rovers_[rover_index]->is_configured_ = false;
+    roster_.is_configured_[rover_index] = false;
 }
 
-bool Base::TryPopConfigPacket(LoRaPacket *packet)
+int Base::AllocateSlotSet(unsigned int period)
+{
+    // One placement per phase within every (channel, slot set) group
+    return slot_sets_.AllocatePattern(tdma::GetPhasePattern(period, tdma::kSuperframeCycleCount), tdma::kSuperframeGroupBits, period);
+}
+
+void Base::AssignSlotSet(unsigned int rover_index, int slot_set_index, unsigned int period)
+{
+    unsigned int group = slot_set_index / tdma::kSuperframeGroupBits;
+
+    roster_.micro_slots_[rover_index] = group % tdma::kMicroSlotCount;
+    roster_.base_slots_[rover_index] = (group / tdma::kMicroSlotCount % tdma::kSlotSetCount) * tdma::kSlotCountPerTransmit;
+    roster_.channels_[rover_index] = group / tdma::kMicroSlotCount / tdma::kSlotSetCount;
+    roster_.periods_[rover_index] = period;
+    roster_.phases_[rover_index] = slot_set_index % tdma::kSuperframeGroupBits;
+    SetSlotSetOwner(rover_index, rover_index);
+}
+
+void Base::ReserveSlotSet(unsigned int rover_index)
 {
-    for (unsigned int i = 0; i < rover_count_; i++)
+    slot_sets_.ReservePattern(GetSlotSetIndex(rover_index), tdma::GetPhasePattern(roster_.periods_[rover_index], tdma::kSuperframeCycleCount));
+    SetSlotSetOwner(rover_index, rover_index);
+}
+
+void Base::ReleaseSlotSet(unsigned int rover_index)
+{
+    slot_sets_.ReleasePattern(GetSlotSetIndex(rover_index), tdma::GetPhasePattern(roster_.periods_[rover_index], tdma::kSuperframeCycleCount));
+    SetSlotSetOwner(rover_index, Roster::kNotFound);
+}
+
+void Base::SetSlotSetOwner(unsigned int rover_index, unsigned int owner)
+{
+    unsigned int group = GetSlotSetGroup(roster_.channels_[rover_index], roster_.base_slots_[rover_index] / tdma::kSlotCountPerTransmit, roster_.micro_slots_[rover_index]);
+
+    unsigned int period = roster_.periods_[rover_index] > 0 ? roster_.periods_[rover_index] : 1;
+    if (group >= tdma::kSlotSetCount * tdma::kMicroSlotCount * tdma::kAssignableChannelCount)
     {
-        RoverInfo *rover_info = rovers_[i];
-        if (!rover_info->is_configured_)
-        {
-            debug("Sending config to rover ");
-            debugln2(rover_info->hardware_id_, 16);
+        return;
+    }
+
+    for (unsigned int cycle = roster_.phases_[rover_index]; cycle < tdma::kSuperframeCycleCount; cycle += period)
+    {
+        slot_set_owners_[group * tdma::kSuperframeCycleCount + cycle] = owner;
+    }
+}
+
+unsigned int Base::GetSlotSetIndex(unsigned int rover_index)
+{
+    unsigned int group = GetSlotSetGroup(roster_.channels_[rover_index], roster_.base_slots_[rover_index] / tdma::kSlotCountPerTransmit, roster_.micro_slots_[rover_index]);
+
+    return group * tdma::kSuperframeGroupBits + roster_.phases_[rover_index];
+}
+
+unsigned int Base::GetSlotSetGroup(unsigned int channel, unsigned int slot_set, unsigned int micro_slot)
+{
+    return (channel * tdma::kSlotSetCount + slot_set) * tdma::kMicroSlotCount + micro_slot;
+}
+
+void Base::ClearSlotSets()
+{
+    slot_sets_.Clear();
+
+    for (unsigned int i = 0; i < sizeof(slot_set_owners_) / sizeof(slot_set_owners_[0]); i++)
+    {
+        slot_set_owners_[i] = Roster::kNotFound;
+    }
+
+    for (unsigned int group = 0; group < tdma::kSlotSetCount * tdma::kMicroSlotCount * tdma::kAssignableChannelCount; group++)
+    {
+        // Reserved slots repeat with the same period as rover slots, so checking a set's base slot is enough
+        unsigned int slot_set = group / tdma::kMicroSlotCount % tdma::kSlotSetCount;
+        bool is_reserved = tdma::TDMA::GetSlotType(slot_set * tdma::kSlotCountPerTransmit) != tdma::SlotType::kRoverData;
 
-            RoverConfiguration config;
-            config.sf = rover_info->radio_config_.sf;
-            config.sbw = rover_info->radio_config_.sbw;
-            config.slots_count = tdma::kRoverSlotCount;
-            for (unsigned int i = 0; i < tdma::kRoverSlotCount; i++)
+        // Bits past the end of the superframe are padding
+        for (unsigned int cycle = 0; cycle < tdma::kSuperframeGroupBits; cycle++)
+        {
+            if (is_reserved || cycle >= tdma::kSuperframeCycleCount)
             {
-                config.slots[i] = rover_info->slots_[i];
+                slot_sets_.Reserve(group * tdma::kSuperframeGroupBits + cycle);
             }
+        }
+    }
+}
+
+bool Base::TryPopConfigPacket(LoRaPacket *packet)
+{
+    RoverConfigurationBatch batch = RoverConfigurationBatch_init_zero;
+    batch.contention_window = contention_.GetWindow();
+
+    // Start after the last rover we configured, so that a rover that never confirms (e.g. it powered off) doesn't
+    // keep everyone behind it out of the batch
+    unsigned int rover_count = roster_.Count();
+    for (unsigned int n = 0; n < rover_count && batch.assignments_count < kMaxAssignmentsPerBatch; n++)
+    {
+        unsigned int i = (next_config_index_ + n) % rover_count;
+
+        if (!roster_.is_configured_[i])
+        {
+            debug("Sending config to rover ");
+            debugln2(roster_.hardware_ids_[i], 16);
 
-            packet->hardware_id = rover_info->hardware_id_;
-            packet->payload.rover_configuration = config;
-            packet->which_payload = LoRaPacket_rover_configuration_tag;
+            // Slots are always evenly spaced from the rover's first slot (see DiscoverRover)
+            RoverAssignment &assignment = batch.assignments[batch.assignments_count++];
+            assignment.hardware_id = roster_.hardware_ids_[i];
+            assignment.offset = roster_.base_slots_[i];
+            assignment.interval = tdma::kRoverSlotInterval;
+            assignment.count = tdma::kRoverSlotCount;
+            assignment.sbw = roster_.sbws_[i];
+            assignment.sf = roster_.sfs_[i];
+            assignment.channel = roster_.channels_[i];
+            assignment.period = roster_.periods_[i];
+            assignment.phase = roster_.phases_[i];
+            assignment.micro_slot = roster_.micro_slots_[i];
+            assignment.address = GetAddress(i);
+            assignment.coding_rate = roster_.coding_rates_[i] == config::kLoraRoverDataConfig.coding_rate ? 0 : roster_.coding_rates_[i];
 
-            return true;
+            next_config_index_ = i + 1;
         }
     }
 
-    return false;
+    if (batch.assignments_count == 0)
+    {
+        return false;
+    }
+
+    packet->hardware_id = 0; // to all rovers; each picks out its own assignment
+    packet->serial_number = 0;
+    packet->payload.rover_configuration_batch = batch;
+    packet->which_payload = LoRaPacket_rover_configuration_batch_tag;
+
+    return true;
 }
 
 void Base::HandleSlot(tdma::Slot slot)
 {
+    // A frame may only be read out after the next (micro-)slot has begun (see HandlePacket()), so look for missing
+    // ones a transition late
+    if (previous_slot_.number != -1 && previous_slot_.type == tdma::SlotType::kRoverData)
+    {
+        CountSlotMisses(previous_slot_);
+    }
+
+    previous_slot_ = current_slot_;
+    current_slot_ = slot;
+
+    // Discoveries that overlapped in the same sub-slot usually arrive as a single frame with a bad CRC
+    if (is_discovery_slot_)
+    {
+        for (unsigned long i = discovery_rx_bad_count_; i < radio_->GetRxBadCount(); i++)
+        {
+            contention_.HandleCollision();
+        }
+    }
+
+    // The cycle that just ended is accounted for before the new cycle's first discovery slot opens
+    if (slot.number == 0)
+    {
+        contention_.HandleCycleEnd();
+    }
+
+    is_discovery_slot_ = slot.type == tdma::SlotType::kRoverDiscovery;
+    discovery_rx_bad_count_ = radio_->GetRxBadCount();
+    if (is_discovery_slot_)
+    {
+        contention_.HandleDiscoverySlot();
+    }
+
     if (slot.type == tdma::SlotType::kRoverData)
     {
-        radio_->Configure(config::kLoraRoverDataConfig);
+        hw::radio::Config rx_config = config::kLoraRoverDataConfig;
+        rx_config.channel = GetReceiveChannel(slot);
+        rx_config.implicit_length = tdma::kRoverDataImplicitLength;
+        radio_->Configure(rx_config);
     }
     else
     {
@@ -95,56 +296,387 @@ void Base::HandleSlot(tdma::Slot slot)
 
     if (slot.type == tdma::SlotType::kRoverConfiguration)
     {
-        if (reset_sent_count_ < 5)
+        if (reset_sent_count_ < kResetBroadcastCount)
         {
             // Send a bunch of RoverReset packets at the beginning
-            RoverReset rover_reset;
-            rover_reset.dummy_field = 0;
-
-            LoRaPacket reset_packet;
-            reset_packet.hardware_id = 0;   // to all rovers
-            reset_packet.serial_number = 0; // don't care
-            reset_packet.which_payload = LoRaPacket_rover_reset_tag;
-            reset_packet.payload.rover_reset = rover_reset;
-
             debugln("Sending reset packet to all");
-            radio_->Send(reset_packet);
+            SendReset(0); // to all rovers
 
             reset_sent_count_++;
         }
+        else if (pending_reset_count_ > 0)
+        {
+            pending_reset_count_--;
+
+            debug("Sending reset packet to rover ");
+            debugln2(pending_resets_[pending_reset_count_], 16);
+            SendReset(pending_resets_[pending_reset_count_]);
+        }
         else
         {
-            LoRaPacket config_packet;
+            LoRaPacket config_packet = LoRaPacket_init_zero;
             if (TryPopConfigPacket(&config_packet))
             {
                 radio_->Send(config_packet);
             }
+            else
+            {
+                SendBeacon();
+            }
+        }
+    }
+}
+
+void Base::SendReset(unsigned int hardware_id)
+{
+    RoverReset rover_reset;
+    rover_reset.dummy_field = 0;
+
+    LoRaPacket reset_packet = LoRaPacket_init_zero;
+    reset_packet.hardware_id = hardware_id;
+    reset_packet.serial_number = 0; // don't care
+    reset_packet.which_payload = LoRaPacket_rover_reset_tag;
+    reset_packet.payload.rover_reset = rover_reset;
+
+    radio_->Send(reset_packet);
+}
+
+void Base::SendBeacon()
+{
+    BaseBeacon beacon = BaseBeacon_init_zero;
+    beacon.contention_window = contention_.GetWindow();
+    AddBackfillRequests(&beacon);
+
+    LoRaPacket beacon_packet = LoRaPacket_init_zero;
+    beacon_packet.hardware_id = 0; // to all rovers
+    beacon_packet.serial_number = 0;
+    beacon_packet.which_payload = LoRaPacket_base_beacon_tag;
+    beacon_packet.payload.base_beacon = beacon;
+
+    trace(kBeacon, current_slot_.cycle, beacon.backfill_requests_count);
+    radio_->Send(beacon_packet);
+}
+
+void Base::AddBackfillRequests(BaseBeacon *beacon)
+{
+    static const unsigned int kMaxRequests = sizeof(BaseBeacon::backfill_requests) / sizeof(BackfillRequest);
+
+    // Take turns, as with configuration batches
+    unsigned int rover_count = roster_.Count();
+    for (unsigned int n = 0; n < rover_count && beacon->backfill_requests_count < kMaxRequests; n++)
+    {
+        unsigned int i = (next_backfill_index_ + n) % rover_count;
+        LinkStats &link = roster_.links_[i];
+
+        // Only once the link is back; a rover we aren't hearing wouldn't hear us either
+        unsigned int first;
+        uint32_t missing;
+        if (!roster_.is_configured_[i] || !link.is_heard || !TryGetMissingFrames<tdma::kSequenceModulus>(link, &first, &missing))
+        {
+            continue;
+        }
+
+        // It hasn't got them (e.g. it rebooted), or no spare slot came up in time
+        if (link.backfill_requests >= kBackfillPatience)
+        {
+            debug("Giving up on missing frames from rover ");
+            debugln2(roster_.hardware_ids_[i], 16);
+            ForgetMissingFrames(&link);
+            link.backfill_requests = 0;
+            continue;
+        }
+
+        BackfillRequest &request = beacon->backfill_requests[beacon->backfill_requests_count++];
+        request.address = GetAddress(i);
+        request.sequence = first;
+        request.missing = missing;
+
+        int lent = LendSlotSet(i);
+        if (lent >= 0)
+        {
+            request.slot_set = lent / tdma::kMicroSlotCount + 1;
+            request.micro_slot = lent % tdma::kMicroSlotCount;
+        }
+
+        link.backfill_requests++;
+        next_backfill_index_ = i + 1;
+    }
+}
+
+int Base::LendSlotSet(unsigned int rover_index)
+{
+    static const unsigned int kLendableCount = sizeof(lent_slot_sets_) / sizeof(lent_slot_sets_[0]);
+
+    if (lent_cycle_ != current_slot_.cycle)
+    {
+        ClearLentSlotSets();
+        lent_cycle_ = current_slot_.cycle;
+    }
+
+    unsigned int superframe_cycle = current_slot_.cycle % tdma::kSuperframeCycleCount;
+    int free_index = -1;
+
+    for (unsigned int i = 0; i < kLendableCount; i++)
+    {
+        // Again, in case it missed the beacon we lent it in
+        if (lent_slot_sets_[i] == rover_index)
+        {
+            return i;
+        }
+
+        unsigned int slot_set = i / tdma::kMicroSlotCount;
+        unsigned int micro_slot = i % tdma::kMicroSlotCount;
+
+        // It needs a slot left in this cycle, and it mustn't be anyone's on any channel, so that we listen on the
+        // channel a rover with channel 0 would use (see GetReceiveChannel)
+        bool is_free = lent_slot_sets_[i] == Roster::kNotFound && free_index < 0 &&
+                       (int)(slot_set * tdma::kSlotCountPerTransmit + (tdma::kRoverSlotCount - 1) * tdma::kRoverSlotInterval) > current_slot_.number;
+        for (unsigned int channel = 0; is_free && channel < tdma::kAssignableChannelCount; channel++)
+        {
+            is_free = slot_sets_.IsFree(GetSlotSetGroup(channel, slot_set, micro_slot) * tdma::kSuperframeGroupBits + superframe_cycle);
+        }
+
+        if (is_free)
+        {
+            free_index = i;
+        }
+    }
+
+    if (free_index >= 0)
+    {
+        lent_slot_sets_[free_index] = rover_index;
+    }
+
+    return free_index;
+}
+
+void Base::ClearLentSlotSets()
+{
+    for (unsigned int i = 0; i < sizeof(lent_slot_sets_) / sizeof(lent_slot_sets_[0]); i++)
+    {
+        lent_slot_sets_[i] = Roster::kNotFound;
+    }
+}
+
+bool Base::IsLentSlot(unsigned int rover_index, tdma::Slot slot)
+{
+    unsigned int slot_set = slot.number % tdma::kRoverSlotInterval / tdma::kSlotCountPerTransmit;
+
+    return slot.number >= 0 && slot.type == tdma::SlotType::kRoverData && slot.cycle == lent_cycle_ &&
+           slot.number % tdma::kSlotCountPerTransmit == 0 && lent_slot_sets_[slot_set * tdma::kMicroSlotCount + slot.micro_slot] == rover_index;
+}
+
+void Base::QueueReset(unsigned int hardware_id)
+{
+    for (unsigned int i = 0; i < pending_reset_count_; i++)
+    {
+        if (pending_resets_[i] == hardware_id)
+        {
+            return;
         }
     }
+
+    if (pending_reset_count_ < kMaxPendingResets)
+    {
+        pending_resets_[pending_reset_count_++] = hardware_id;
+    }
 }
 
 void Base::HandlePacket(LoRaPacket packet, int rssi)
 {
-    int rover_index = FindRoverIndex(packet.hardware_id);
-    if (rover_index != -1 && !rovers_[rover_index]->is_configured_ && packet.which_payload == LoRaPacket_rover_data_tag)
+    int snr = radio_->GetLastSnr();
+
+    // Backfill only ever carries the network address
+    if (packet.which_payload == LoRaPacket_rover_backfill_tag)
     {
-        debugln("Got data; rover was successfully configured");
-        rovers_[rover_index]->is_configured_ = true;
+        HandleBackfill(packet.payload.rover_backfill, GetRoverIndex(packet.address), rssi, snr);
+        return;
+    }
+
+    // Most data frames only carry the rover's network address
+    bool is_address_only = packet.which_payload == LoRaPacket_rover_data_tag && packet.hardware_id == 0;
+    unsigned int rover_index = is_address_only ? GetRoverIndex(packet.address) : roster_.Find(packet.hardware_id);
+
+    if (is_address_only && rover_index == Roster::kNotFound)
+    {
+        // Without a hardware ID we can't even send it a reset; it'll identify itself in a later frame
+        debug("Data from unknown address ");
+        debugln(packet.address);
+        return;
+    }
+
+    if (packet.which_payload == LoRaPacket_rover_data_tag && current_slot_.number != -1)
+    {
+        trace(kRoverData, packet.address, packet.payload.rover_data.sequence);
+
+        if (rover_index == Roster::kNotFound)
+        {
+            // A rover resumed a configuration that isn't in our roster (e.g. we lost it), so its slots may
+            // collide with someone else's; send it back to discovery
+            debug("Data from unknown rover; resetting ");
+            debugln2(packet.hardware_id, 16);
+            QueueReset(packet.hardware_id);
+        }
+        else if (is_address_only && !IsRoverSlot(rover_index, current_slot_) && !IsRoverSlot(rover_index, previous_slot_))
+        {
+            // Not from the rover holding this address (e.g. one still using an address from an older roster), and
+            // without a hardware ID we can't tell whose it is; the holder did nothing wrong, so leave it configured
+            debug("Data from address ");
+            debug(packet.address);
+            debugln(" in the wrong slot; ignoring");
+            return;
+        }
+        else if (!IsRoverSlot(rover_index, current_slot_) && !IsRoverSlot(rover_index, previous_slot_))
+        {
+            // (The previous slot counts too: a frame that fills its micro-slot may only be read out after the next
+            // micro-slot has begun)
+            debug("Data from rover in the wrong slot; reconfiguring ");
+            debugln2(roster_.hardware_ids_[rover_index], 16);
+            roster_.is_configured_[rover_index] = false;
+        }
+        else if (packet.address != GetAddress(rover_index))
+        {
+            debug("Data from rover with the wrong address; reconfiguring ");
+            debugln2(roster_.hardware_ids_[rover_index], 16);
+            roster_.is_configured_[rover_index] = false;
+        }
+        else if (!roster_.is_configured_[rover_index] && radio_->GetLastCodingRate() != roster_.coding_rates_[rover_index])
+        {
+            // Still at the coding rate it had before (see UpdateLink()), so it hasn't got its new assignment yet; it
+            // stays queued for the next configuration slot
+            debug("Data at coding rate 4/");
+            debug(radio_->GetLastCodingRate());
+            debugln(" rather than the assigned one; resending");
+        }
+        else if (!roster_.is_configured_[rover_index])
+        {
+            debugln("Got data; rover was successfully configured");
+            roster_.is_configured_[rover_index] = true;
+        }
+
+        // E.g. the rover's serial number was set after its discovery
+        if (rover_index != Roster::kNotFound && !is_address_only && packet.serial_number != roster_.serial_numbers_[rover_index])
+        {
+            roster_.serial_numbers_[rover_index] = packet.serial_number;
+            SaveRoster();
+        }
+
+        if (rover_index != Roster::kNotFound)
+        {
+            UpdateLink(rover_index, packet.payload.rover_data.sequence, rssi, snr);
+        }
     }
 
     if (packet.which_payload == LoRaPacket_rover_discovery_tag)
     {
-        DiscoverRover(packet);
+        contention_.HandleDiscovery();
+        DiscoverRover(packet, rssi);
     }
     else if (packet.which_payload == LoRaPacket_rover_data_tag)
     {
+        if (is_address_only)
+        {
+            packet.hardware_id = roster_.hardware_ids_[rover_index];
+            packet.serial_number = roster_.serial_numbers_[rover_index];
+        }
+
         PrintRoverData(packet, rssi);
+
+        // Nobody is listening, so keep it until someone is
+        if (!IsHostConnected())
+        {
+            LogRoverData(packet, rssi, snr);
+        }
+
+        if (rover_index != Roster::kNotFound && roster_.links_[rover_index].received % kLinkReportInterval == 0)
+        {
+            PrintLink(rover_index);
+        }
+    }
+}
+
+void Base::HandleBackfill(const RoverBackfill &backfill, unsigned int rover_index, int rssi, int snr)
+{
+    static const unsigned long kSlotsPerDay = (unsigned long)tdma::kCyclesPerDay * tdma::kSlotCount;
+
+    if (rover_index == Roster::kNotFound || current_slot_.number == -1)
+    {
+        return;
+    }
+
+    // (The previous slot counts too, as for data)
+    bool is_rover_slot = IsRoverSlot(rover_index, current_slot_) || IsRoverSlot(rover_index, previous_slot_);
+    if (!is_rover_slot && !IsLentSlot(rover_index, current_slot_) && !IsLentSlot(rover_index, previous_slot_))
+    {
+        debug("Backfill from rover in the wrong slot; ignoring ");
+        debugln2(roster_.hardware_ids_[rover_index], 16);
+        return;
+    }
+
+    trace(kBackfill, GetAddress(rover_index), backfill.deltas_count + 1);
+
+    // One of its slots skipped while stationary, which it put to use
+    LinkStats &link = roster_.links_[rover_index];
+    if (is_rover_slot)
+    {
+        link.is_heard = true;
+    }
+
+    // Deltas accumulate in the rover's fixed point, so the coordinates come out exactly as it sent them
+    int32_t latitude = backfill.latitude;
+    int32_t longitude = backfill.longitude;
+    unsigned long slot_of_day = (backfill.cycle * tdma::kSlotCount + backfill.slot) % kSlotsPerDay;
+
+    LoggedRover record = {};
+    record.hardware_id = roster_.hardware_ids_[rover_index];
+    record.heading = backfill.heading;
+    record.heel = backfill.heel;
+    record.sog = backfill.sog;
+    record.cog = backfill.cog;
+    record.sequence = backfill.sequence % tdma::kSequenceModulus;
+    record.snr = snr;
+    record.rssi = rssi;
+    record.flags = kLoggedBackfill;
+
+    for (unsigned int i = 0;; i++)
+    {
+        record.latitude = latitude / 1e7;
+        record.longitude = longitude / 1e7;
+        record.cycle = slot_of_day / tdma::kSlotCount;
+        record.slot = slot_of_day % tdma::kSlotCount;
+
+        // Repeats of ones that already arrived are dropped
+        if (RecordBackfillFrame<tdma::kSequenceModulus>(&link, record.sequence))
+        {
+            PrintLoggedRover(record, false);
+
+            if (!IsHostConnected())
+            {
+                backlog_.Push(record);
+            }
+        }
+
+        if (i == backfill.deltas_count)
+        {
+            break;
+        }
+
+        const BackfillDelta &delta = backfill.deltas[i];
+        latitude += delta.latitude;
+        longitude += delta.longitude;
+        slot_of_day = (slot_of_day + delta.slots) % kSlotsPerDay;
+        record.sequence = (record.sequence + delta.sequence + 1) % tdma::kSequenceModulus;
+        record.heading += delta.heading;
+        record.heel += delta.heel;
+        record.sog += delta.sog;
+        record.cog += delta.cog;
     }
 }
 
-void Base::PrintRoverData(LoRaPacket packet, int rssi)
+void Base::PrintRoverData(LoRaPacket packet, int rssi, const LoggedRover *record, bool is_drained)
 {
-    if (config::kEnableBell)
+    // No bell for old news
+    if (config::kEnableBell && record == nullptr)
     {
         Serial.print('\a');
     }
@@ -166,26 +698,323 @@ void Base::PrintRoverData(LoRaPacket packet, int rssi)
     Serial.print(packet.payload.rover_data.cog);
     Serial.print(" bat:");
     Serial.print(packet.payload.rover_data.battery);
+    Serial.print(" seq:");
+    Serial.print(packet.payload.rover_data.sequence);
     Serial.print(" serial:");
-    Serial.println(packet.serial_number);
+    Serial.print(packet.serial_number);
+
+    // When it was heard, or for backfill first sent, since it's printed long after
+    if (record != nullptr)
+    {
+        Serial.print(" cycle:");
+        Serial.print(record->cycle);
+        Serial.print(" slot:");
+        Serial.print(record->slot);
+
+        if (is_drained)
+        {
+            Serial.print(" logged:1");
+        }
+
+        if (record->flags & kLoggedBackfill)
+        {
+            Serial.print(" backfill:1");
+        }
+    }
+    Serial.println();
+}
+
+void Base::PrintLoggedRover(const LoggedRover &logged, bool is_drained)
+{
+    LoRaPacket packet = LoRaPacket_init_zero;
+    packet.hardware_id = logged.hardware_id;
+    packet.which_payload = LoRaPacket_rover_data_tag;
+    packet.payload.rover_data.latitude = logged.latitude;
+    packet.payload.rover_data.longitude = logged.longitude;
+    packet.payload.rover_data.heading = logged.heading;
+    packet.payload.rover_data.heel = logged.heel;
+    packet.payload.rover_data.sog = logged.sog;
+    packet.payload.rover_data.cog = logged.cog;
+    packet.payload.rover_data.battery = logged.battery;
+    packet.payload.rover_data.sequence = logged.sequence;
+
+    // Serial numbers aren't logged; the roster has it unless the base rebooted since
+    unsigned int rover_index = roster_.Find(logged.hardware_id);
+    packet.serial_number = rover_index == Roster::kNotFound ? 0 : roster_.serial_numbers_[rover_index];
+
+    PrintRoverData(packet, logged.rssi, &logged, is_drained);
+}
+
+void Base::LogRoverData(LoRaPacket packet, int rssi, int snr)
+{
+    const RoverData &data = packet.payload.rover_data;
+
+    LoggedRover logged = {};
+    logged.hardware_id = packet.hardware_id;
+    logged.latitude = data.latitude;
+    logged.longitude = data.longitude;
+    logged.heading = data.heading;
+    logged.heel = data.heel;
+    logged.sog = data.sog;
+    logged.cog = data.cog;
+    logged.cycle = current_slot_.number == -1 ? 0 : current_slot_.cycle;
+    logged.slot = current_slot_.number == -1 ? 0 : current_slot_.number;
+    logged.battery = data.battery;
+    logged.sequence = data.sequence;
+    logged.snr = snr;
+    logged.rssi = rssi;
+
+    backlog_.Push(logged);
+}
+
+void Base::PrintLink(unsigned int rover_index)
+{
+    const LinkStats &link = roster_.links_[rover_index];
+
+    Serial.print("LINK hwid:");
+    Serial.print(roster_.hardware_ids_[rover_index], 16);
+    Serial.print(" rx:");
+    Serial.print(link.received);
+    Serial.print(" missed:");
+    Serial.print(link.missed);
+    Serial.print(" dup:");
+    Serial.print(link.duplicates);
+    Serial.print(" slotmiss:");
+    Serial.print(link.slot_misses);
+    Serial.print(" rssi:");
+    Serial.print(link.rssi);
+    Serial.print(" rssimin:");
+    Serial.print(link.rssi_min);
+    Serial.print(" rssimax:");
+    Serial.print(link.rssi_max);
+    Serial.print(" snr:");
+    Serial.print(link.snr);
+    Serial.print(" cycle:");
+    Serial.println(link.last_heard_cycle);
+}
+
+void Base::UpdateLink(unsigned int rover_index, unsigned int sequence, int rssi, int snr)
+{
+    RecordLinkFrame<tdma::kSequenceModulus>(&roster_.links_[rover_index], sequence, rssi, snr, current_slot_.cycle);
+    const LinkStats &link = roster_.links_[rover_index];
+
+    // Only reassign a configured rover; anything else gets a new assignment anyway
+    unsigned int coding_rate = SelectCodingRate(link.rssi, roster_.coding_rates_[rover_index]);
+    if (coding_rate != roster_.coding_rates_[rover_index] && roster_.is_configured_[rover_index])
+    {
+        debug("Link changed; reconfiguring with coding rate 4/");
+        debugln(coding_rate);
+        roster_.coding_rates_[rover_index] = coding_rate;
+        roster_.is_configured_[rover_index] = false;
+    }
+}
+
+unsigned int Base::SelectCodingRate(int rssi, unsigned int current)
+{
+    int margin = rssi - hw::airtime::GetSensitivity(config::kLoraRoverDataConfig.sbw, config::kLoraRoverDataConfig.sf);
+    unsigned int target = GetCodingRateForMargin(margin);
+
+    // Only move once the margin is kCodingRateHysteresis past a threshold, so a link hovering around one doesn't
+    // keep getting reconfigured
+    if (target > current)
+    {
+        unsigned int confirmed = GetCodingRateForMargin(margin + kCodingRateHysteresis);
+        target = confirmed > current ? confirmed : current;
+    }
+    else if (target < current)
+    {
+        unsigned int confirmed = GetCodingRateForMargin(margin - kCodingRateHysteresis);
+        target = confirmed < current ? confirmed : current;
+    }
+
+    return target;
+}
+
+unsigned int Base::GetCodingRateForMargin(int margin)
+{
+    // dB above sensitivity
+    unsigned int coding_rate = margin >= 15 ? 5 : margin >= 10 ? 6 : margin >= 5 ? 7 : 8;
+
+    if (coding_rate < config::kLoraRoverDataConfig.coding_rate)
+    {
+        return config::kLoraRoverDataConfig.coding_rate;
+    }
+
+    return coding_rate > tdma::kMaxRoverDataCodingRate ? tdma::kMaxRoverDataCodingRate : coding_rate;
+}
+
+unsigned int Base::GetAddress(unsigned int rover_index)
+{
+    // Roster indexes are stable until the roster is cleared, and survive a reboot: SaveRoster() keeps every entry in
+    // order, and TryLoadRoster() rejects a roster that wouldn't load back at the same indexes
+    return rover_index + 1;
+}
+
+unsigned int Base::GetRoverIndex(unsigned int address)
+{
+    return address >= 1 && address <= roster_.Count() ? address - 1 : Roster::kNotFound;
+}
+
+unsigned int Base::GetRoverCount()
+{
+    return roster_.Count();
+}
+
+const Roster &Base::GetRoster()
+{
+    return roster_;
+}
+
+const Backlog &Base::GetBacklog()
+{
+    return backlog_;
+}
+
+bool Base::IsHostConnected()
+{
+    // DTR rather than Serial's bool operator, which costs a 10 ms delay on every call
+    return Serial.dtr();
 }
 
-int Base::FindRoverIndex(unsigned int hardware_id)
+void Base::CountSlotMisses(tdma::Slot slot)
 {
-    for (unsigned int i = 0; i < rover_count_; i++)
+    // Only the rovers holding this slot set in this cycle, one per channel, rather than the whole roster
+    unsigned int slot_set = (slot.number % tdma::kRoverSlotInterval) / tdma::kSlotCountPerTransmit;
+    unsigned int superframe_cycle = slot.cycle % tdma::kSuperframeCycleCount;
+    unsigned int rx_channel = GetReceiveChannel(slot);
+
+    for (unsigned int channel = 0; channel < tdma::kAssignableChannelCount; channel++)
     {
-        if (rovers_[i]->hardware_id_ == hardware_id)
+        unsigned int i = slot_set_owners_[GetSlotSetGroup(channel, slot_set, slot.micro_slot) * tdma::kSuperframeCycleCount + superframe_cycle];
+        if (i == Roster::kNotFound || !roster_.is_configured_[i] || !IsRoverSlot(i, slot))
         {
-            return i;
+            continue;
+        }
+
+        // Not a miss if we were listening on another channel
+        if (tdma::GetTransmitChannel(tdma::kChannelPlan, tdma::kChannelCount, slot.number / tdma::kRoverSlotInterval, roster_.channels_[i]) != rx_channel)
+        {
+            continue;
+        }
+
+        if (!roster_.links_[i].is_heard)
+        {
+            roster_.links_[i].slot_misses++;
+        }
+
+        roster_.links_[i].is_heard = false;
+    }
+}
+
+bool Base::IsRoverSlot(unsigned int rover_index, tdma::Slot slot)
+{
+    int offset = slot.number - roster_.base_slots_[rover_index];
+
+    return offset >= 0 && offset % tdma::kRoverSlotInterval == 0 && offset / tdma::kRoverSlotInterval < tdma::kRoverSlotCount &&
+           slot.micro_slot == roster_.micro_slots_[rover_index] &&
+           tdma::IsActiveCycle(slot.cycle, roster_.periods_[rover_index], roster_.phases_[rover_index]);
+}
+
+unsigned int Base::GetReceiveChannel(tdma::Slot slot)
+{
+    unsigned int transmission_index = slot.number / tdma::kRoverSlotInterval;
+
+    if (tdma::kChannelPlan != tdma::ChannelPlan::kRotating)
+    {
+        return tdma::GetTransmitChannel(tdma::kChannelPlan, tdma::kChannelCount, transmission_index, 0);
+    }
+
+    // Take turns among the rovers sharing this slot set in this cycle of the superframe
+    unsigned int slot_set = (slot.number % tdma::kRoverSlotInterval) / tdma::kSlotCountPerTransmit;
+    unsigned int superframe_cycle = slot.cycle % tdma::kSuperframeCycleCount;
+    uint32_t occupied_channels = 0;
+
+    for (unsigned int channel = 0; channel < tdma::kAssignableChannelCount; channel++)
+    {
+        unsigned int group = GetSlotSetGroup(channel, slot_set, slot.micro_slot);
+        if (!slot_sets_.IsFree(group * tdma::kSuperframeGroupBits + superframe_cycle))
+        {
+            occupied_channels |= 1UL << channel;
+        }
+    }
+
+    return tdma::SelectReceiveChannel(occupied_channels, transmission_index);
+}
+
+void Base::SaveRoster()
+{
+    PersistedRoster roster = {};
+    roster.rover_count = roster_.Count();
+
+    for (unsigned int i = 0; i < roster.rover_count; i++)
+    {
+        roster.rovers[i].hardware_id = roster_.hardware_ids_[i];
+        roster.rovers[i].serial_number = roster_.serial_numbers_[i];
+        roster.rovers[i].base_slot = roster_.base_slots_[i];
+        roster.rovers[i].channel_sf = roster_.channels_[i] << 4 | roster_.sfs_[i];
+        roster.rovers[i].period_phase = roster_.periods_[i] << 4 | roster_.phases_[i];
+        roster.rovers[i].micro_sbw = roster_.micro_slots_[i] << 4 | roster_.sbws_[i] / 125;
+    }
+
+    eeprom_->Write(hw::eeprom::Key::kRoster, &roster, sizeof(roster), kRosterVersion);
+}
+
+bool Base::TryLoadRoster()
+{
+    static_assert(sizeof(PersistedRoster) <= hw::eeprom::kRecordCapacities[(int)hw::eeprom::Key::kRoster], "PersistedRoster outgrew its record");
+    static_assert(tdma::kChannelCount <= 16 && tdma::kSuperframeCycleCount <= 16 && tdma::kMicroSlotCount <= 16, "PersistedRover packs channels, phases and micro-slots into nibbles");
+
+    PersistedRoster roster;
+
+    if (!eeprom_->Read(hw::eeprom::Key::kRoster, &roster, sizeof(roster), kRosterVersion) ||
+        roster.rover_count > sizeof(PersistedRoster::rovers) / sizeof(PersistedRover))
+    {
+        return false;
+    }
+
+    roster_.Clear();
+    ClearSlotSets();
+
+    for (unsigned int i = 0; i < roster.rover_count; i++)
+    {
+        const PersistedRover &persisted = roster.rovers[i];
+        unsigned int rover_index = roster_.Insert(persisted.hardware_id);
+
+        // Rovers keep their addresses (see GetAddress()) only if every one lands at its old index
+        if (rover_index != i)
+        {
+            roster_.Clear();
+            ClearSlotSets();
+            return false;
         }
+
+        roster_.serial_numbers_[rover_index] = persisted.serial_number;
+        roster_.base_slots_[rover_index] = persisted.base_slot;
+        roster_.channels_[rover_index] = persisted.channel_sf >> 4;
+        roster_.sfs_[rover_index] = persisted.channel_sf & 0x0F;
+        roster_.periods_[rover_index] = persisted.period_phase >> 4;
+        roster_.phases_[rover_index] = persisted.period_phase & 0x0F;
+        roster_.micro_slots_[rover_index] = persisted.micro_sbw >> 4;
+        roster_.sbws_[rover_index] = (persisted.micro_sbw & 0x0F) * 125;
+        roster_.coding_rates_[rover_index] = config::kLoraRoverDataConfig.coding_rate; // Until the link is measured again
+        ReserveSlotSet(rover_index);
+
+        // Assume the rover resumed this configuration; data in the wrong slot triggers a reconfiguration
+        roster_.is_configured_[rover_index] = true;
     }
 
-    return -1;
+    return true;
 }
 
 void Base::ResetConfiguration()
 {
     reset_sent_count_ = 0;
-    rover_count_ = 0;
-    next_base_slot_ = 0;
+    roster_.Clear();
+    ClearSlotSets();
+    ClearLentSlotSets();
+    next_config_index_ = 0;
+    next_backfill_index_ = 0;
+    pending_reset_count_ = 0;
+
+    eeprom_->Erase(hw::eeprom::Key::kRoster);
 }
\ No newline at end of file
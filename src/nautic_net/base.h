@@ -5,32 +5,147 @@
 
 #include "config.h"
 #include "lora_packet.pb.h"
-#include "nautic_net/base/rover_info.h"
+#include "nautic_net/base/backlog.h"
+#include "nautic_net/base/roster_table.h"
+#include "nautic_net/hw/eeprom.h"
 #include "nautic_net/hw/radio.h"
 #include "nautic_net/tdma.h"
+#include "nautic_net/tdma/discovery.h"
+#include "nautic_net/tdma/slot_bitmap.h"
 
 namespace nautic_net::base
 {
+    // The roster, persisted so that a rebooted base can carry on without resetting every rover. Entries are packed
+    // so that a useful number fit in the record; serial numbers are kept too, since only every
+    // kIdentityInterval-th RoverData carries one (see rover.h).
+    typedef struct
+    {
+        uint32_t hardware_id;
+        uint32_t serial_number;
+        uint8_t base_slot;    // First TX slot; the rest follow every tdma::kRoverSlotInterval slots
+        uint8_t channel_sf;   // Channel in the high nibble, spreading factor in the low nibble
+        uint8_t period_phase; // Period in the high nibble, phase in the low nibble
+        uint8_t micro_sbw;    // Micro-slot in the high nibble, bandwidth in units of 125kHz in the low nibble
+    } PersistedRover;
+
+    // The record holds the whole roster, i.e. as many rovers as the schedule carries, so none are forgotten when the
+    // base reboots
+    static const unsigned int kMaxPersistedRovers = (hw::eeprom::kRecordCapacities[(int)hw::eeprom::Key::kRoster] - 4) / sizeof(PersistedRover);
+    static const unsigned int kRosterSize = tdma::kRosterCapacity < kMaxPersistedRovers ? tdma::kRosterCapacity : kMaxPersistedRovers;
+    static_assert(kRosterSize == tdma::kRosterCapacity, "Grow kRecordCapacities[Key::kRoster] to persist every rover the schedule carries");
+
+    typedef struct
+    {
+        uint8_t rover_count;
+        uint8_t reserved[3];
+        PersistedRover rovers[kRosterSize];
+    } PersistedRoster;
+
+    typedef RosterTable<kRosterSize> Roster;
+
     class Base
     {
     public:
-        Base(nautic_net::hw::radio::Radio *radio);
+        Base(nautic_net::hw::radio::Radio *radio, nautic_net::hw::eeprom::EEPROM *eeprom);
+        void Setup();
+        void Loop();
+        void HandleRadioReady(); // Once the radio is set up, before TDMA may have started
         void HandlePacket(LoRaPacket packet, int rssi);
         void HandleSlot(tdma::Slot slot);
         void ResetConfiguration();
 
+        unsigned int GetRoverCount();
+        const Roster &GetRoster();
+        const Backlog &GetBacklog();
+
+        // Whether anything is reading the serial output; while nothing is, rover data goes to the backlog
+        static bool IsHostConnected();
+
+        // Network addresses (LoRaPacket.address) of roster entries; 0 is never assigned
+        static unsigned int GetAddress(unsigned int rover_index);
+        unsigned int GetRoverIndex(unsigned int address); // Roster::kNotFound if unassigned
+
     private:
+        static const unsigned int kResetBroadcastCount = 5; // RoverReset broadcasts after booting without a roster
+        static const unsigned int kMaxPendingResets = 4;    // Targeted RoverResets waiting for a configuration slot
+        static const uint8_t kRosterVersion = 5;
+        static const int kCodingRateHysteresis = 3;         // dB
+        static const unsigned int kLinkReportInterval = 10; // A LINK line after every this many data frames from a rover
+        static const unsigned long kBacklogGuard = 2000;    // µs of slack between backlog I2C and the next slot transition
+        static const unsigned int kBackfillPatience = 5;    // Beacons asking a rover for the same missing frames before giving up
+
+        // Assignments per RoverConfigurationBatch, as many as fit in one configuration slot. An assignment encodes to
+        // at most: hardware_id (fixed32) 5, sbw 3, address 3, the other nine fields 2 each (values below 128), plus
+        // its own tag and length. The batch adds 5 bytes of its own (tag, length and contention_window).
+        static const unsigned int kAssignmentSize = 5 + 3 + 3 + 9 * 2 + 2;
+        static const unsigned int kMaxBatchFrameSize = tdma::GetMaxFrameSize(config::kLoraDefaultConfig, tdma::kSlotDuration - tdma::kMicroSlotGuard);
+        static const unsigned int kMaxAssignmentsPerBatch = (kMaxBatchFrameSize - RH_RF95_HEADER_LEN - 5) / kAssignmentSize < sizeof(RoverConfigurationBatch::assignments) / sizeof(RoverAssignment)
+                                                                ? (kMaxBatchFrameSize - RH_RF95_HEADER_LEN - 5) / kAssignmentSize
+                                                                : sizeof(RoverConfigurationBatch::assignments) / sizeof(RoverAssignment);
+        static_assert(kMaxAssignmentsPerBatch > 0, "Not even one RoverAssignment fits in a configuration slot");
+
+        // A beacon is the payload's tag and (two-byte) length, and the beacon itself; hardware ID 0 isn't encoded
+        static_assert(RH_RF95_HEADER_LEN + 3 + BaseBeacon_size <= kMaxBatchFrameSize, "A full BaseBeacon doesn't fit in a configuration slot");
+
         nautic_net::hw::radio::Radio *radio_;
-        unsigned int next_base_slot_ = 0;   // the next rover base slot to hand out upon discovery
-        unsigned int rover_count_ = 0;      // number of discovered rovers
-        unsigned int reset_sent_count_ = 0; // number of RoverReset packets that have been broadcast
+        nautic_net::hw::eeprom::EEPROM *eeprom_;
+        unsigned int reset_sent_count_ = 0;  // number of RoverReset packets that have been broadcast
+        tdma::Slot current_slot_ = {-1, tdma::SlotType::kRoverDiscovery, 0, 0, 0};  // number is -1 until the first slot transition
+        tdma::Slot previous_slot_ = {-1, tdma::SlotType::kRoverDiscovery, 0, 0, 0}; // Including micro-slots
+        unsigned int next_config_index_ = 0; // roster index to start the next RoverConfigurationBatch from
+        unsigned int next_backfill_index_ = 0; // roster index to start the next beacon's BackfillRequests from
+
+        // Slot sets lent out for backfill in lent_cycle_, by slot set and micro-slot: roster indexes, or
+        // Roster::kNotFound. Only ones nobody transmits in for the rest of the cycle (see LendSlotSet).
+        uint16_t lent_slot_sets_[tdma::kSlotSetCount * tdma::kMicroSlotCount];
+        unsigned long lent_cycle_ = 0;
+
+        unsigned int pending_resets_[kMaxPendingResets]; // hardware IDs
+        unsigned int pending_reset_count_ = 0;
+
+        tdma::ContentionEstimator contention_;
+        bool is_discovery_slot_ = false;
+        unsigned long discovery_rx_bad_count_ = 0; // Radio bad-frame count when the current discovery slot began
 
-        RoverInfo *rovers_[nautic_net::tdma::kMaxRoverCount];
+        Roster roster_;
+        Backlog backlog_;
+        // Free (channel, slot set, micro-slot, superframe cycle) tuples. Each (channel, slot set, micro-slot) is a group
+        // of kSuperframeGroupBits bits, one per cycle (see GetSlotSetGroup), so channel 0 fills up before any slot set
+        // is shared across channels.
+        tdma::SlotBitmap<tdma::kSlotSetCount * tdma::kMicroSlotCount * tdma::kAssignableChannelCount * tdma::kSuperframeGroupBits> slot_sets_;
+        // Who holds each of those tuples, by group and superframe cycle: roster indexes, or Roster::kNotFound
+        uint16_t slot_set_owners_[tdma::kSlotSetCount * tdma::kMicroSlotCount * tdma::kAssignableChannelCount * tdma::kSuperframeCycleCount];
 
-        void DiscoverRover(LoRaPacket packet);
-        void PrintRoverData(LoRaPacket packet, int rssi);
+        void DiscoverRover(LoRaPacket packet, int rssi);
+        void UpdateLink(unsigned int rover_index, unsigned int sequence, int rssi, int snr);
+        void HandleBackfill(const RoverBackfill &backfill, unsigned int rover_index, int rssi, int snr);
+        void CountSlotMisses(tdma::Slot slot);
+        static unsigned int SelectCodingRate(int rssi, unsigned int current);
+        static unsigned int GetCodingRateForMargin(int margin);
+        void PrintRoverData(LoRaPacket packet, int rssi, const LoggedRover *record = nullptr, bool is_drained = false);
+        void PrintLoggedRover(const LoggedRover &logged, bool is_drained);
+        void LogRoverData(LoRaPacket packet, int rssi, int snr);
+        void PrintLink(unsigned int rover_index);
         bool TryPopConfigPacket(LoRaPacket *packet);
-        int FindRoverIndex(unsigned int hardware_id);
+        void ClearSlotSets();
+        int AllocateSlotSet(unsigned int period);
+        void AssignSlotSet(unsigned int rover_index, int slot_set_index, unsigned int period);
+        void ReserveSlotSet(unsigned int rover_index);
+        void ReleaseSlotSet(unsigned int rover_index);
+        unsigned int GetSlotSetIndex(unsigned int rover_index);
+        void SetSlotSetOwner(unsigned int rover_index, unsigned int owner); // Over the rover's phase pattern
+        static unsigned int GetSlotSetGroup(unsigned int channel, unsigned int slot_set, unsigned int micro_slot);
+        bool IsRoverSlot(unsigned int rover_index, tdma::Slot slot);
+        bool IsLentSlot(unsigned int rover_index, tdma::Slot slot);
+        int LendSlotSet(unsigned int rover_index); // Index into lent_slot_sets_, or -1 if none is free
+        void ClearLentSlotSets();
+        unsigned int GetReceiveChannel(tdma::Slot slot);
+        void QueueReset(unsigned int hardware_id);
+        void SendReset(unsigned int hardware_id);
+        void SendBeacon();
+        void AddBackfillRequests(BaseBeacon *beacon);
+        void SaveRoster();
+        bool TryLoadRoster();
     };
 }
 
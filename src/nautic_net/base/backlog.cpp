@@ -0,0 +1,210 @@
+#include <Arduino.h>
+
+#include "backlog.h"
+#include "debug.h"
+#include "nautic_net/crc.h"
+
+using namespace nautic_net::base;
+using nautic_net::hw::eeprom::EEPROM;
+
+static_assert(sizeof(LoggedRover) == 32, "LoggedRover is stored as it is");
+
+Backlog::Backlog(nautic_net::hw::eeprom::EEPROM *eeprom) : eeprom_(eeprom)
+{
+}
+
+void Backlog::Setup()
+{
+    RingHeader header;
+    if (!eeprom_->ReadLog(0, &header, sizeof(header)))
+    {
+        debugln("No EEPROM; backlog disabled");
+        return;
+    }
+
+    is_enabled_ = true;
+
+    // A blank chip, another layout, or a torn header write: start over rather than replay garbage
+    if (header.magic != kMagic || header.crc != GetHeaderCRC(header) || header.head - header.tail > GetCapacity())
+    {
+        debugln("Formatting backlog");
+        head_ = 0;
+        tail_ = 0;
+        drained_to_ = 0;
+        TryWriteHeader();
+        return;
+    }
+
+    head_ = header.head;
+    tail_ = header.tail;
+    drained_to_ = tail_;
+
+    debug("Backlog holds ");
+    debug(head_ - tail_);
+    debugln(" records");
+}
+
+void Backlog::Push(const LoggedRover &record)
+{
+    if (!is_enabled_ || staged_count_ == kStagingCapacity)
+    {
+        dropped_count_++;
+        return;
+    }
+
+    if (staged_count_ == 0)
+    {
+        staged_at_ = millis();
+    }
+
+    staged_[staged_count_] = record;
+    staged_[staged_count_].crc = 0;
+    staged_[staged_count_].crc = GetRecordCRC(staged_[staged_count_]);
+    staged_count_++;
+}
+
+unsigned int Backlog::Step(bool is_host_connected, LoggedRover *drained)
+{
+    // The caller has passed on the batch the last Step() returned, so those records can go now. The header that
+    // records it goes out with whatever else this Step() writes.
+    bool is_header_due = false;
+    if ((int32_t)(drained_to_ - tail_) > 0)
+    {
+        tail_ = drained_to_;
+        is_header_due = true;
+    }
+
+    if (staged_count_ >= kMaxTransferRecords || (staged_count_ > 0 && millis() - staged_at_ >= kMaxStagingAge))
+    {
+        WriteStaged();
+        return 0;
+    }
+
+    if (is_header_due)
+    {
+        TryWriteHeader();
+    }
+
+    if (is_host_connected && head_ != tail_)
+    {
+        return Drain(drained);
+    }
+
+    return 0;
+}
+
+unsigned int Backlog::WriteStaged()
+{
+    unsigned int count = staged_count_ < kMaxTransferRecords ? staged_count_ : kMaxTransferRecords;
+
+    // In at most two pieces, if the batch wraps around the end of the ring
+    unsigned int first_count = GetCapacity() - head_ % GetCapacity();
+    first_count = first_count < count ? first_count : count;
+    eeprom_->WriteLog(GetRecordOffset(head_), staged_, first_count * sizeof(LoggedRover));
+    if (first_count < count)
+    {
+        eeprom_->WriteLog(GetRecordOffset(0), staged_ + first_count, (count - first_count) * sizeof(LoggedRover));
+    }
+
+    head_ += count;
+    if (head_ - tail_ > GetCapacity())
+    {
+        overwritten_count_ += head_ - tail_ - GetCapacity();
+        tail_ = head_ - GetCapacity();
+    }
+
+    // The header goes last, so a brownout mid-batch leaves the records it points at intact
+    TryWriteHeader();
+    written_count_ += count;
+
+    staged_count_ -= count;
+    memmove(staged_, staged_ + count, staged_count_ * sizeof(LoggedRover));
+    staged_at_ = millis();
+
+    return count;
+}
+
+unsigned int Backlog::Drain(LoggedRover *drained)
+{
+    // One read, up to the end of the ring; the rest comes next time
+    unsigned long count = head_ - tail_;
+    unsigned int until_end = GetCapacity() - tail_ % GetCapacity();
+    count = count < kMaxTransferRecords ? count : kMaxTransferRecords;
+    count = count < until_end ? count : until_end;
+
+    if (!eeprom_->ReadLog(GetRecordOffset(tail_), drained, count * sizeof(LoggedRover)))
+    {
+        return 0;
+    }
+
+    // Only dropped from the ring at the next Step(), once the caller has them; a reboot in between sends them again
+    // rather than losing them
+    drained_to_ = tail_ + count;
+
+    unsigned int valid_count = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (GetRecordCRC(drained[i]) != drained[i].crc)
+        {
+            crc_error_count_++;
+            continue;
+        }
+
+        drained[valid_count++] = drained[i];
+    }
+
+    drained_count_ += valid_count;
+    return valid_count;
+}
+
+bool Backlog::TryWriteHeader()
+{
+    RingHeader header = {};
+    header.magic = kMagic;
+    header.head = head_;
+    header.tail = tail_;
+    header.crc = GetHeaderCRC(header);
+
+    return eeprom_->WriteLog(0, &header, sizeof(header));
+}
+
+unsigned long Backlog::GetPendingCount() const
+{
+    return head_ - tail_;
+}
+
+unsigned int Backlog::GetStagedCount() const
+{
+    return staged_count_;
+}
+
+unsigned long Backlog::GetTransferTime()
+{
+    // Records and header, plus device address and two address bytes for each of up to three transactions (a batch
+    // wrapping around the ring, then the header; or the header, then a read). EEPROM::WriteLog() sends each in one
+    // burst, since a batch fits in Wire's buffer.
+    return (kMaxTransferRecords * sizeof(LoggedRover) + sizeof(RingHeader) + 3 * 3) * kI2CByteTime;
+}
+
+unsigned int Backlog::GetCapacity()
+{
+    // Records start after the header, on a record boundary
+    return EEPROM::kLogRegionSize / sizeof(LoggedRover) - 1;
+}
+
+unsigned int Backlog::GetRecordOffset(uint32_t index)
+{
+    return (index % GetCapacity() + 1) * sizeof(LoggedRover);
+}
+
+uint16_t Backlog::GetHeaderCRC(RingHeader header)
+{
+    header.crc = 0;
+    return crc::CRC16(&header, sizeof(header));
+}
+
+uint16_t Backlog::GetRecordCRC(LoggedRover record)
+{
+    record.crc = 0;
+    return crc::CRC16(&record, sizeof(record));
+}
@@ -0,0 +1,102 @@
+#ifndef BACKLOG_H
+#define BACKLOG_H
+
+#include <stdint.h>
+
+#include "nautic_net/hw/eeprom.h"
+
+namespace nautic_net::base
+{
+    static const uint16_t kLoggedBackfill = 1 << 0; // LoggedRover::flags: resent by the rover (RoverBackfill)
+
+    // One rover's RoverData as the base heard it, compact enough that the log region holds a long host dropout
+    typedef struct
+    {
+        uint32_t hardware_id;
+        float latitude;
+        float longitude;
+        uint16_t heading;
+        uint16_t heel;
+        uint16_t sog;
+        uint16_t cog;
+        uint16_t cycle; // Base's cycle of the day and slot when it was heard (sent, for backfill); the time to a slot
+        uint8_t slot;
+        uint8_t battery;
+        uint8_t sequence;
+        int8_t snr;   // dB
+        int16_t rssi; // dBm
+        uint16_t flags; // kLogged*
+        uint16_t crc; // CRC16 of the record with crc = 0
+    } LoggedRover;
+
+    //
+    // Store-and-forward log of rover data for while no host is listening on USB. Records go into a ring in the
+    // EEPROM's log region, oldest overwritten first, and are read back once a host reconnects.
+    //
+    // Push() only stages records in RAM; all I2C traffic happens in Step(), one bounded transaction per call, so the
+    // caller decides when there's time for it. Staged records are written in batches, since every transaction
+    // also rewrites the ring header.
+    //
+    class Backlog
+    {
+    public:
+        static const unsigned int kMaxTransferRecords = 4; // Per Step(), either way
+
+        explicit Backlog(nautic_net::hw::eeprom::EEPROM *eeprom);
+        void Setup();
+
+        void Push(const LoggedRover &record);
+
+        // Does one batch of I2C work, if any is due: writes staged records, or with a host connected, reads back
+        // up to kMaxTransferRecords logged ones into drained (oldest first). Returns the number read back. They stay
+        // in the log until the next call, so pass them on before making it.
+        unsigned int Step(bool is_host_connected, LoggedRover *drained);
+
+        unsigned long GetPendingCount() const; // Logged, not yet drained
+        unsigned int GetStagedCount() const;
+        static unsigned long GetTransferTime();  // µs; the longest a Step() can spend on I2C
+        static unsigned int GetCapacity();       // Records
+
+        unsigned long written_count_ = 0;
+        unsigned long drained_count_ = 0;
+        unsigned long overwritten_count_ = 0; // Oldest records lost to a full ring
+        unsigned long dropped_count_ = 0;     // Lost to a full staging buffer, or because the EEPROM is missing
+        unsigned long crc_error_count_ = 0;   // Read back corrupted, and skipped
+
+    private:
+        static const uint32_t kMagic = 0x4C424E4E; // "NNBL" - NauticNet Backlog
+        static const unsigned int kStagingCapacity = 2 * kMaxTransferRecords;
+        static const unsigned long kMaxStagingAge = 2000; // ms; write a partial batch after this long
+        static const unsigned long kI2CByteTime = 90;    // µs, at the default 100 kHz including ACKs
+
+        // At the start of the log region; head and tail count records written and drained since the ring was
+        // formatted, so head - tail is the number pending
+        typedef struct
+        {
+            uint32_t magic;
+            uint32_t head;
+            uint32_t tail;
+            uint16_t crc;
+            uint16_t reserved;
+        } RingHeader;
+
+        nautic_net::hw::eeprom::EEPROM *eeprom_;
+        bool is_enabled_ = false;
+        uint32_t head_ = 0;
+        uint32_t tail_ = 0;
+        uint32_t drained_to_ = 0; // tail_ once the caller has the batch Drain() read
+
+        LoggedRover staged_[kStagingCapacity];
+        unsigned int staged_count_ = 0;
+        unsigned long staged_at_ = 0; // ms, when the oldest staged record was pushed
+
+        unsigned int WriteStaged();
+        unsigned int Drain(LoggedRover *drained);
+        bool TryWriteHeader();
+        static unsigned int GetRecordOffset(uint32_t index);
+        static uint16_t GetHeaderCRC(RingHeader header);
+        static uint16_t GetRecordCRC(LoggedRover record);
+    };
+}
+
+#endif
@@ -0,0 +1,321 @@
+#ifndef ROSTER_TABLE_H
+#define ROSTER_TABLE_H
+
+#include <stdint.h>
+
+//
+// The base station's roster: every discovered rover, looked up by hardware ID on every received packet.
+// tools/roster_bench measures it on the host.
+//
+// Rovers are stored densely by index (0 through Count() - 1, in discovery order) as a struct of arrays, so that
+// scanning one column (e.g. is_configured_ when building a configuration batch) stays within a few cache lines.
+// A separate open-addressing hash index maps hardware IDs to rover indexes with linear probing; hardware ID 0 is
+// the broadcast address and never a real rover, so it marks an empty bucket.
+//
+namespace nautic_net::base
+{
+    // How well the base hears one rover, from its data frames. Kept small, since there is one per roster entry;
+    // counters wrap, and RSSI bottoms out at -128dBm (below the data profile's sensitivity anyway).
+    typedef struct
+    {
+        uint32_t heard[4];         // Bit per sequence number, up to 128: the frame arrived, live or backfilled
+        uint16_t received;         // Data frames
+        uint16_t missed;           // Skipped sequence numbers
+        uint16_t duplicates;       // Sequence number repeated
+        uint16_t slot_misses;      // Scheduled slots that passed without a frame, including ones skipped while stationary
+        uint16_t last_heard_cycle; // Cycle of the day (see tdma/superframe.h)
+        int8_t rssi;               // dBm, smoothed
+        int8_t rssi_min;           // dBm
+        int8_t rssi_max;           // dBm
+        int8_t snr;                // dB, smoothed
+        uint8_t sequence;          // Last received
+        uint8_t backfill_requests; // Beacons asking for missing frames since the rover last resent any
+        bool is_heard;             // A frame arrived for the rover's latest scheduled slot
+        bool is_started;           // Anything received at all; the fields above are meaningless until then
+    } LinkStats;
+
+    inline bool IsFrameHeard(const LinkStats &link, unsigned int sequence)
+    {
+        return (link.heard[sequence / 32] & (1UL << (sequence % 32))) != 0;
+    }
+
+    inline void SetFrameHeard(LinkStats *link, unsigned int sequence, bool is_heard)
+    {
+        if (is_heard)
+        {
+            link->heard[sequence / 32] |= 1UL << (sequence % 32);
+        }
+        else
+        {
+            link->heard[sequence / 32] &= ~(1UL << (sequence % 32));
+        }
+    }
+
+    // Gives up on every missing frame, e.g. those of a rover that rebooted and no longer has them
+    inline void ForgetMissingFrames(LinkStats *link)
+    {
+        for (unsigned int i = 0; i < sizeof(link->heard) / sizeof(link->heard[0]); i++)
+        {
+            link->heard[i] = 0xFFFFFFFF;
+        }
+    }
+
+    // Folds one data frame into a rover's link stats. Shared with tools/capture, which replays captured traffic
+    // through it.
+    template <unsigned int kSequenceModulus>
+    inline void RecordLinkFrame(LinkStats *link, unsigned int sequence, int rssi, int snr, unsigned int cycle)
+    {
+        static_assert(kSequenceModulus <= sizeof(LinkStats::heard) * 8, "LinkStats::heard has a bit per sequence number");
+
+        sequence %= kSequenceModulus;
+        rssi = rssi < -128 ? -128 : rssi;
+
+        if (!link->is_started)
+        {
+            // Nothing from before we started listening is owed
+            ForgetMissingFrames(link);
+
+            link->rssi = link->rssi_min = link->rssi_max = rssi;
+            link->snr = snr;
+            link->is_started = true;
+        }
+        else
+        {
+            // A rover that rebooted starts counting over, which shows up as one gap
+            unsigned int gap = (sequence + kSequenceModulus - link->sequence) % kSequenceModulus;
+            if (gap == 0)
+            {
+                link->duplicates++;
+            }
+            else
+            {
+                link->missed += gap - 1;
+            }
+
+            for (unsigned int i = 1; i < gap; i++)
+            {
+                SetFrameHeard(link, (sequence + kSequenceModulus - i) % kSequenceModulus, false);
+            }
+
+            link->rssi = (3 * link->rssi + rssi) / 4;
+            link->rssi_min = rssi < link->rssi_min ? rssi : link->rssi_min;
+            link->rssi_max = rssi > link->rssi_max ? rssi : link->rssi_max;
+            link->snr = (3 * link->snr + snr) / 4;
+        }
+
+        link->received++;
+        link->sequence = sequence;
+        link->last_heard_cycle = cycle;
+        link->is_heard = true;
+        SetFrameHeard(link, sequence, true);
+    }
+
+    // A frame the rover resent from its history (RoverBackfill). False if it isn't one we were missing, i.e. a
+    // repeat, or older than the last kSequenceModulus - 1 frames.
+    template <unsigned int kSequenceModulus>
+    inline bool RecordBackfillFrame(LinkStats *link, unsigned int sequence)
+    {
+        sequence %= kSequenceModulus;
+        if (!link->is_started || sequence == link->sequence || IsFrameHeard(*link, sequence))
+        {
+            return false;
+        }
+
+        SetFrameHeard(link, sequence, true);
+        link->backfill_requests = 0;
+        return true;
+    }
+
+    // The oldest missing frame among the kSequenceModulus - 1 before the latest, and in missing, which of it and the
+    // 31 after it are missing (bit n for first + n). False if none are.
+    template <unsigned int kSequenceModulus>
+    inline bool TryGetMissingFrames(const LinkStats &link, unsigned int *first, uint32_t *missing)
+    {
+        bool is_found = false;
+        *missing = 0;
+
+        if (!link.is_started)
+        {
+            return false;
+        }
+
+        for (unsigned int age = kSequenceModulus - 1; age > 0; age--)
+        {
+            unsigned int sequence = (link.sequence + kSequenceModulus - age) % kSequenceModulus;
+            if (IsFrameHeard(link, sequence))
+            {
+                continue;
+            }
+
+            if (!is_found)
+            {
+                *first = sequence;
+                is_found = true;
+            }
+
+            unsigned int offset = (sequence + kSequenceModulus - *first) % kSequenceModulus;
+            if (offset >= 32)
+            {
+                break;
+            }
+
+            *missing |= 1UL << offset;
+        }
+
+        return is_found;
+    }
+
+    template <unsigned int kCapacity>
+    class RosterTable
+    {
+    public:
+        static const unsigned int kNotFound = 0xFFFF;
+
+        RosterTable();
+        void Clear();
+
+        // Returns the rover's index, or kNotFound
+        unsigned int Find(uint32_t hardware_id) const;
+
+        // Returns the index of the new (or existing) rover, or kNotFound if the roster is full. Columns of a new
+        // rover are zeroed.
+        unsigned int Insert(uint32_t hardware_id);
+
+        unsigned int Count() const;
+        bool IsFull() const;
+
+        // Columns, indexed by rover index
+        uint32_t hardware_ids_[kCapacity];
+        uint32_t serial_numbers_[kCapacity];
+        uint16_t base_slots_[kCapacity]; // First TX slot; the rest follow every tdma::kRoverSlotInterval slots
+        uint16_t sbws_[kCapacity];
+        uint8_t sfs_[kCapacity];
+        uint8_t channels_[kCapacity];
+        uint8_t micro_slots_[kCapacity];
+        uint8_t coding_rates_[kCapacity]; // Denominator, 5 through 8
+        uint8_t periods_[kCapacity]; // Transmits in cycles where cycle % period == phase
+        uint8_t phases_[kCapacity];
+        bool is_configured_[kCapacity];
+        LinkStats links_[kCapacity]; // Updated together on every data frame, so not split into columns
+
+    private:
+        static_assert(kCapacity > 0 && kCapacity < kNotFound, "Rover indexes must fit in 16 bits");
+
+        // At least twice the capacity, and a power of two, so the load factor stays under 50% and probing wraps
+        // with a mask
+        static constexpr unsigned int GetBucketCount(unsigned int count)
+        {
+            return count >= 2 * kCapacity ? count : GetBucketCount(count * 2);
+        }
+        static const unsigned int kBucketCount = GetBucketCount(1);
+
+        unsigned int count_;
+        uint32_t keys_[kBucketCount];    // Hardware IDs; 0 = empty
+        uint16_t indexes_[kBucketCount]; // Rover index of each occupied bucket
+
+        static unsigned int GetHomeBucket(uint32_t hardware_id);
+    };
+
+    template <unsigned int kCapacity>
+    RosterTable<kCapacity>::RosterTable()
+    {
+        Clear();
+    }
+
+    template <unsigned int kCapacity>
+    void RosterTable<kCapacity>::Clear()
+    {
+        count_ = 0;
+
+        for (unsigned int i = 0; i < kBucketCount; i++)
+        {
+            keys_[i] = 0;
+        }
+    }
+
+    template <unsigned int kCapacity>
+    unsigned int RosterTable<kCapacity>::GetHomeBucket(uint32_t hardware_id)
+    {
+        // Fibonacci hashing; hardware IDs are derived from chip serial numbers and aren't uniformly distributed
+        return ((uint32_t)(hardware_id * 2654435769u) >> 16) & (kBucketCount - 1);
+    }
+
+    template <unsigned int kCapacity>
+    unsigned int RosterTable<kCapacity>::Find(uint32_t hardware_id) const
+    {
+        if (hardware_id == 0)
+        {
+            return kNotFound;
+        }
+
+        for (unsigned int bucket = GetHomeBucket(hardware_id);; bucket = (bucket + 1) & (kBucketCount - 1))
+        {
+            if (keys_[bucket] == hardware_id)
+            {
+                return indexes_[bucket];
+            }
+
+            // The load factor is below 50%, so there is always an empty bucket to end the probe
+            if (keys_[bucket] == 0)
+            {
+                return kNotFound;
+            }
+        }
+    }
+
+    template <unsigned int kCapacity>
+    unsigned int RosterTable<kCapacity>::Insert(uint32_t hardware_id)
+    {
+        if (hardware_id == 0)
+        {
+            return kNotFound;
+        }
+
+        unsigned int bucket = GetHomeBucket(hardware_id);
+        for (; keys_[bucket] != 0; bucket = (bucket + 1) & (kBucketCount - 1))
+        {
+            if (keys_[bucket] == hardware_id)
+            {
+                return indexes_[bucket];
+            }
+        }
+
+        if (count_ >= kCapacity)
+        {
+            return kNotFound;
+        }
+
+        unsigned int index = count_++;
+        keys_[bucket] = hardware_id;
+        indexes_[bucket] = index;
+
+        hardware_ids_[index] = hardware_id;
+        serial_numbers_[index] = 0;
+        base_slots_[index] = 0;
+        sbws_[index] = 0;
+        sfs_[index] = 0;
+        channels_[index] = 0;
+        micro_slots_[index] = 0;
+        coding_rates_[index] = 0;
+        links_[index] = {};
+        periods_[index] = 1;
+        phases_[index] = 0;
+        is_configured_[index] = false;
+
+        return index;
+    }
+
+    template <unsigned int kCapacity>
+    unsigned int RosterTable<kCapacity>::Count() const
+    {
+        return count_;
+    }
+
+    template <unsigned int kCapacity>
+    bool RosterTable<kCapacity>::IsFull() const
+    {
+        return count_ >= kCapacity;
+    }
+}
+
+#endif
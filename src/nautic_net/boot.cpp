@@ -0,0 +1,262 @@
+#include "debug.h"
+#include "nautic_net/boot.h"
+
+using namespace nautic_net::boot;
+
+Boot::Boot(nautic_net::hw::eeprom::EEPROM *eeprom, nautic_net::hw::radio::Radio *radio, nautic_net::hw::imu::IMU *imu,
+           nautic_net::hw::gps::GPS *gps, nautic_net::rover::Rover *rover, nautic_net::base::Base *base)
+    : eeprom_(eeprom), radio_(radio), imu_(imu), gps_(gps), rover_(rover), base_(base)
+{
+}
+
+void Boot::Setup(bool is_base)
+{
+    is_base_ = is_base;
+    started_at_ = millis();
+
+    for (int i = 0; i < (int)Subsystem::kCount; i++)
+    {
+        statuses_[i] = {};
+    }
+
+    // In the base station, the IMU board may be omitted
+    if (is_base_)
+    {
+        SetState(Subsystem::kIMU, State::kSkipped);
+    }
+
+    // Status LED stays on until the GPS has a fix
+    digitalWrite(LED_BUILTIN, HIGH);
+
+    // Start acquiring right away; everything else comes up in Loop() in the meantime
+    gps_->Setup();
+    SetState(Subsystem::kGPS, State::kPending);
+}
+
+void Boot::Loop()
+{
+    StepGPS();
+    StepEEPROM();
+    StepRadio();
+    StepIMU();
+}
+
+void Boot::StepGPS()
+{
+    // GPS::Read() is called from loop(), so all we do here is notice the fix
+    if (statuses_[(int)Subsystem::kGPS].state == State::kPending && gps_->gps_.fix)
+    {
+        digitalWrite(LED_BUILTIN, LOW);
+        SetState(Subsystem::kGPS, State::kReady);
+    }
+}
+
+void Boot::StepEEPROM()
+{
+    if (!IsDue(Subsystem::kEEPROM))
+    {
+        return;
+    }
+
+    statuses_[(int)Subsystem::kEEPROM].attempts++;
+
+    if (eeprom_->Setup())
+    {
+        SetState(Subsystem::kEEPROM, State::kReady);
+    }
+    else
+    {
+        HandleFailure(Subsystem::kEEPROM, true);
+    }
+
+    // Everything that reads the EEPROM runs once it has settled, with defaults if the EEPROM never showed up
+    if (IsSettled(Subsystem::kEEPROM))
+    {
+        gps_->LoadHint();
+
+        if (is_base_)
+        {
+            base_->Setup();
+        }
+        else
+        {
+            rover_->Setup();
+        }
+    }
+}
+
+void Boot::StepRadio()
+{
+    if (!IsDue(Subsystem::kRadio))
+    {
+        return;
+    }
+
+    Status &status = statuses_[(int)Subsystem::kRadio];
+    if (status.state == State::kWaiting)
+    {
+        status.attempts++;
+        SetState(Subsystem::kRadio, State::kPending);
+    }
+
+    switch (radio_->Setup())
+    {
+    case nautic_net::hw::radio::SetupStatus::kPending:
+        break;
+
+    case nautic_net::hw::radio::SetupStatus::kReady:
+        SetState(Subsystem::kRadio, State::kReady);
+        if (is_base_)
+        {
+            base_->HandleRadioReady();
+        }
+        break;
+
+    case nautic_net::hw::radio::SetupStatus::kFailed:
+        // Nothing works without the radio, so never give up on it
+        HandleFailure(Subsystem::kRadio, false);
+        break;
+    }
+}
+
+void Boot::StepIMU()
+{
+    // Needs the compass calibration from the EEPROM
+    if (!IsSettled(Subsystem::kEEPROM) || !IsDue(Subsystem::kIMU))
+    {
+        return;
+    }
+
+    statuses_[(int)Subsystem::kIMU].attempts++;
+
+    if (imu_->Setup())
+    {
+        SetState(Subsystem::kIMU, State::kReady);
+    }
+    else
+    {
+        HandleFailure(Subsystem::kIMU, true);
+    }
+}
+
+bool Boot::IsDue(Subsystem subsystem)
+{
+    const Status &status = statuses_[(int)subsystem];
+
+    switch (status.state)
+    {
+    case State::kWaiting:
+        return (long)(millis() - status.retry_at) >= 0;
+    case State::kPending:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Boot::HandleFailure(Subsystem subsystem, bool is_optional)
+{
+    Status &status = statuses_[(int)subsystem];
+
+    if (is_optional && status.attempts >= kMaxOptionalAttempts)
+    {
+        SetState(subsystem, State::kFailed);
+        return;
+    }
+
+    // 100 ms, 200 ms, 400 ms, ... up to kMaxBackoff
+    unsigned long backoff = kInitialBackoff << min(status.attempts - 1, 7U);
+    if (backoff > kMaxBackoff)
+    {
+        backoff = kMaxBackoff;
+    }
+    status.retry_at = millis() + backoff;
+
+    debug("Boot: retrying ");
+    debug(GetName(subsystem));
+    debug(" in ");
+    debug(backoff);
+    debugln(" ms");
+
+    SetState(subsystem, State::kWaiting);
+}
+
+void Boot::SetState(Subsystem subsystem, State state)
+{
+    Status &status = statuses_[(int)subsystem];
+    if (status.state == state)
+    {
+        return;
+    }
+    status.state = state;
+
+    if (state == State::kReady)
+    {
+        status.ready_ms = millis() - started_at_;
+    }
+
+    // The boot command reports these on request; the serial stream only carries them in the debug build
+    if (state == State::kReady || state == State::kFailed)
+    {
+        debug("Boot: ");
+        debug(GetName(subsystem));
+        debug(" ");
+        debug(GetStateName(state));
+        debug(" after ");
+        debug(millis() - started_at_);
+        debug(" ms, attempts: ");
+        debugln(status.attempts);
+    }
+}
+
+bool Boot::IsReady(Subsystem subsystem)
+{
+    return statuses_[(int)subsystem].state == State::kReady;
+}
+
+bool Boot::IsSettled(Subsystem subsystem)
+{
+    State state = statuses_[(int)subsystem].state;
+    return state == State::kReady || state == State::kFailed || state == State::kSkipped;
+}
+
+const Status &Boot::GetStatus(Subsystem subsystem)
+{
+    return statuses_[(int)subsystem];
+}
+
+const char *Boot::GetName(Subsystem subsystem)
+{
+    switch (subsystem)
+    {
+    case Subsystem::kGPS:
+        return "GPS";
+    case Subsystem::kEEPROM:
+        return "EEPROM";
+    case Subsystem::kRadio:
+        return "Radio";
+    case Subsystem::kIMU:
+        return "IMU";
+    default:
+        return "Unknown";
+    }
+}
+
+const char *Boot::GetStateName(State state)
+{
+    switch (state)
+    {
+    case State::kWaiting:
+        return "waiting";
+    case State::kPending:
+        return "pending";
+    case State::kReady:
+        return "ready";
+    case State::kFailed:
+        return "failed";
+    case State::kSkipped:
+        return "skipped";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+#include "nautic_net/base.h"
+#include "nautic_net/hw/eeprom.h"
+#include "nautic_net/hw/gps.h"
+#include "nautic_net/hw/imu.h"
+#include "nautic_net/hw/radio.h"
+#include "nautic_net/rover.h"
+
+namespace nautic_net::boot
+{
+    enum class Subsystem
+    {
+        kGPS,
+        kEEPROM,
+        kRadio,
+        kIMU,
+        kCount // Not a subsystem; the number of subsystems
+    };
+
+    enum class State
+    {
+        kWaiting, // Not started yet, or waiting for a dependency or a retry
+        kPending, // Started, not ready yet
+        kReady,
+        kFailed, // Gave up after too many attempts
+        kSkipped // Not used in this mode
+    };
+
+    typedef struct
+    {
+        State state;
+        unsigned int attempts;
+        unsigned long retry_at; // ms
+        unsigned long ready_ms; // Time to ready, since Boot::Setup()
+    } Status;
+
+    //
+    // Brings the hardware up without blocking loop(). GPS acquisition starts first, since it takes by far the longest;
+    // the EEPROM, radio and IMU come up while it acquires. Failed subsystems are retried with exponential backoff
+    // instead of hanging.
+    //
+    class Boot
+    {
+    public:
+        Boot(nautic_net::hw::eeprom::EEPROM *eeprom, nautic_net::hw::radio::Radio *radio, nautic_net::hw::imu::IMU *imu,
+             nautic_net::hw::gps::GPS *gps, nautic_net::rover::Rover *rover, nautic_net::base::Base *base);
+        void Setup(bool is_base);
+        void Loop();
+
+        bool IsReady(Subsystem subsystem);
+        bool IsSettled(Subsystem subsystem); // Ready, failed or skipped
+        const Status &GetStatus(Subsystem subsystem);
+        static const char *GetName(Subsystem subsystem);
+        static const char *GetStateName(State state);
+
+    private:
+        static const unsigned long kInitialBackoff = 100;   // ms
+        static const unsigned long kMaxBackoff = 10000;     // ms
+        static const unsigned int kMaxOptionalAttempts = 5; // For subsystems we can run without
+
+        nautic_net::hw::eeprom::EEPROM *eeprom_;
+        nautic_net::hw::radio::Radio *radio_;
+        nautic_net::hw::imu::IMU *imu_;
+        nautic_net::hw::gps::GPS *gps_;
+        nautic_net::rover::Rover *rover_;
+        nautic_net::base::Base *base_;
+
+        bool is_base_ = false;
+        unsigned long started_at_ = 0;
+        Status statuses_[(int)Subsystem::kCount];
+
+        void StepGPS();
+        void StepEEPROM();
+        void StepRadio();
+        void StepIMU();
+
+        bool IsDue(Subsystem subsystem);
+        void SetState(Subsystem subsystem, State state);
+        void HandleFailure(Subsystem subsystem, bool is_optional);
+    };
+}
+
+#endif
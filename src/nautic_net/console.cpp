@@ -0,0 +1,494 @@
+#include <ctype.h>
+
+#include "debug.h"
+#include "nautic_net/console.h"
+
+using namespace nautic_net::console;
+
+//
+// Args
+//
+
+unsigned int Args::Count() const
+{
+    return count_;
+}
+
+bool Args::Has(unsigned int index) const
+{
+    return index < count_;
+}
+
+int32_t Args::GetInt(unsigned int index) const
+{
+    return Has(index) ? values_[index].i : 0;
+}
+
+uint32_t Args::GetUInt(unsigned int index) const
+{
+    return Has(index) ? values_[index].u : 0;
+}
+
+const char *Args::GetString(unsigned int index) const
+{
+    return Has(index) ? strings_[index] : "";
+}
+
+//
+// Response
+//
+
+Response::Response(Print *out, bool is_framed, const char *command) : out_(out), is_framed_(is_framed), command_(command)
+{
+}
+
+bool Response::IsFramed() const
+{
+    return is_framed_;
+}
+
+size_t Response::write(uint8_t c)
+{
+    checksum_ ^= c;
+    return out_->write(c);
+}
+
+void Response::Start()
+{
+    if (is_started_)
+    {
+        return;
+    }
+    is_started_ = true;
+
+    if (is_framed_)
+    {
+        // The leading '$' is not part of the checksum, just like NMEA
+        out_->write('$');
+        checksum_ = 0;
+        WriteEscaped(command_); // Unknown commands are echoed as typed
+        print(is_error_ ? ",ERR" : ",OK");
+    }
+}
+
+void Response::BeginField(const char *label)
+{
+    Start();
+
+    if (is_framed_)
+    {
+        write(',');
+        for (const char *c = label; *c != 0; c++)
+        {
+            write(*c == ' ' ? '_' : tolower(*c));
+        }
+        write('=');
+    }
+    else
+    {
+        print(label);
+        print(": ");
+    }
+}
+
+void Response::EndField()
+{
+    if (!is_framed_)
+    {
+        println();
+    }
+}
+
+void Response::Field(const char *label, const char *value)
+{
+    BeginField(label);
+    if (is_framed_)
+    {
+        WriteEscaped(value);
+    }
+    else
+    {
+        print(value);
+    }
+    EndField();
+}
+
+// NMEA's own convention for reserved characters: ^ and two hex digits. Covers the framing characters, the escape
+// itself, and anything unprintable, so a value can never end the line or upset the checksum.
+void Response::WriteEscaped(const char *text)
+{
+    static const char kHex[] = "0123456789ABCDEF";
+
+    for (const char *c = text; *c != 0; c++)
+    {
+        uint8_t byte = *c;
+        if (byte < 0x20 || byte >= 0x7F || byte == '$' || byte == '*' || byte == ',' || byte == '^' || byte == '!' ||
+            byte == '\\' || byte == '~')
+        {
+            write('^');
+            write(kHex[byte >> 4]);
+            write(kHex[byte & 0x0F]);
+        }
+        else
+        {
+            write(byte);
+        }
+    }
+}
+
+void Response::Field(const char *label, int value)
+{
+    Field(label, (long)value);
+}
+
+void Response::Field(const char *label, unsigned int value, int base)
+{
+    Field(label, (unsigned long)value, base);
+}
+
+void Response::Field(const char *label, long value)
+{
+    BeginField(label);
+    print(value);
+    EndField();
+}
+
+void Response::Field(const char *label, unsigned long value, int base)
+{
+    BeginField(label);
+    print(value, base);
+    EndField();
+}
+
+void Response::Field(const char *label, double value, int digits)
+{
+    BeginField(label);
+    print(value, digits);
+    EndField();
+}
+
+void Response::Error(const char *message)
+{
+    // Must be called before any fields for the status to be reported as ERR in framed mode
+    is_error_ = true;
+
+    if (is_framed_)
+    {
+        Field("Message", message);
+    }
+    else
+    {
+        Field("Error", message);
+    }
+}
+
+void Response::Text(const char *text)
+{
+    if (!is_framed_)
+    {
+        println(text);
+    }
+}
+
+void Response::End()
+{
+    if (is_ended_)
+    {
+        return;
+    }
+    is_ended_ = true;
+
+    if (is_framed_)
+    {
+        Start();
+
+        uint8_t checksum = checksum_;
+        out_->write('*');
+        if (checksum < 16)
+        {
+            out_->write('0');
+        }
+        out_->print(checksum, HEX);
+        out_->println();
+    }
+}
+
+//
+// Console
+//
+
+Console::Console(Stream *stream) : stream_(stream)
+{
+}
+
+bool Console::Register(const Command &command)
+{
+    if (command_count_ >= kMaxCommandCount)
+    {
+        debugln("Console command table is full");
+        return false;
+    }
+
+    commands_[command_count_++] = command;
+    return true;
+}
+
+void Console::SetFramed(bool is_framed)
+{
+    is_framed_ = is_framed;
+}
+
+bool Console::IsFramed()
+{
+    return is_framed_;
+}
+
+void Console::Loop()
+{
+    // Drain everything that has arrived since the last pass, so bulk host commands aren't rate-limited by the
+    // main loop
+    while (stream_->available() > 0)
+    {
+        int byte = stream_->read();
+        if (byte < 0)
+        {
+            break;
+        }
+
+        // Use line feed (LF) as the line separator
+        if (byte == '\n')
+        {
+            line_[line_length_] = 0;
+            line_count_++;
+
+            if (is_overflowed_)
+            {
+                overflow_count_++;
+                error_count_++;
+
+                Response response(stream_, is_framed_, "console");
+                response.Error("line too long");
+                response.End();
+            }
+            else
+            {
+                HandleLine(line_);
+            }
+
+            line_length_ = 0;
+            is_overflowed_ = false;
+        }
+        else if (line_length_ < kLineBufferSize - 1)
+        {
+            line_[line_length_++] = (char)byte;
+        }
+        else
+        {
+            // Discard the rest of the line instead of wrapping around and corrupting the buffer
+            is_overflowed_ = true;
+        }
+    }
+}
+
+void Console::HandleLine(char *line)
+{
+    // If a CRLF ("\r\n") was used as the line terminator, drop the \r, too
+    size_t length = strlen(line);
+    if (length >= 1 && line[length - 1] == '\r')
+    {
+        line[length - 1] = 0;
+    }
+
+    // Split into whitespace-delimited tokens, in place; one extra token so we can detect too many arguments
+    char *tokens[kMaxArgCount + 2];
+    unsigned int token_count = 0;
+    char *c = line;
+
+    while (*c != 0 && token_count < kMaxArgCount + 2)
+    {
+        while (*c == ' ' || *c == '\t')
+        {
+            *c++ = 0;
+        }
+
+        if (*c == 0)
+        {
+            break;
+        }
+
+        tokens[token_count++] = c;
+
+        while (*c != 0 && *c != ' ' && *c != '\t')
+        {
+            c++;
+        }
+    }
+
+    if (token_count == 0)
+    {
+        return;
+    }
+
+    const Command *command = FindCommand(tokens[0]);
+    char **arg_tokens = tokens + 1;
+    unsigned int arg_token_count = token_count - 1;
+
+    if (command == nullptr)
+    {
+        // Legacy single-character form, where the first argument is glued to the alias, e.g. "s12345"
+        command = FindAlias(tokens[0][0]);
+
+        if (command != nullptr && tokens[0][1] != 0)
+        {
+            tokens[0]++;
+            arg_tokens = tokens;
+            arg_token_count = token_count;
+        }
+    }
+
+    if (command == nullptr)
+    {
+        error_count_++;
+
+        Response response(stream_, is_framed_, tokens[0]);
+        response.Error("unknown command");
+        response.End();
+        return;
+    }
+
+    Args args;
+    Response response(stream_, is_framed_, command->name);
+
+    if (ParseArgs(command->arg_spec, arg_tokens, arg_token_count, &args))
+    {
+        command->handler(args, &response);
+    }
+    else
+    {
+        error_count_++;
+        response.Error("bad arguments");
+    }
+
+    response.End();
+}
+
+const Command *Console::FindCommand(const char *name)
+{
+    for (unsigned int i = 0; i < command_count_; i++)
+    {
+        if (strcmp(commands_[i].name, name) == 0)
+        {
+            return &commands_[i];
+        }
+    }
+
+    return nullptr;
+}
+
+const Command *Console::FindAlias(char alias)
+{
+    for (unsigned int i = 0; i < command_count_; i++)
+    {
+        if (commands_[i].alias != 0 && commands_[i].alias == alias)
+        {
+            return &commands_[i];
+        }
+    }
+
+    return nullptr;
+}
+
+bool Console::ParseArgs(const char *arg_spec, char *tokens[], unsigned int token_count, Args *args)
+{
+    bool is_optional = false;
+    unsigned int index = 0;
+
+    for (const char *spec = arg_spec; *spec != 0; spec++)
+    {
+        if (*spec == '?')
+        {
+            is_optional = true;
+            continue;
+        }
+
+        if (index >= token_count)
+        {
+            return is_optional;
+        }
+
+        if (index >= kMaxArgCount)
+        {
+            return false;
+        }
+
+        const char *token = tokens[index];
+        char *end = nullptr;
+
+        switch (*spec)
+        {
+        case 'i':
+            args->values_[index].i = strtol(token, &end, 10);
+            break;
+
+        case 'u':
+            if (token[0] == '-')
+            {
+                return false;
+            }
+            args->values_[index].u = strtoul(token, &end, 10);
+            break;
+
+        case 'x':
+            args->values_[index].u = strtoul(token, &end, 16);
+            break;
+
+        case 's':
+            args->values_[index].u = 0;
+            break;
+
+        default:
+            return false;
+        }
+
+        // Numeric arguments must be consumed entirely, so "s12abc" is rejected rather than truncated
+        if (end != nullptr && (end == token || *end != 0))
+        {
+            return false;
+        }
+
+        args->strings_[index] = token;
+        index++;
+        args->count_ = index;
+    }
+
+    // Anything left over is an error
+    return index == token_count;
+}
+
+void Console::PrintHelp(Response *response)
+{
+    for (unsigned int i = 0; i < command_count_; i++)
+    {
+        const Command &command = commands_[i];
+
+        if (response->IsFramed())
+        {
+            response->Field(command.name, command.arg_spec);
+        }
+        else
+        {
+            if (command.alias != 0)
+            {
+                response->print(command.alias);
+                response->print(", ");
+            }
+            else
+            {
+                response->print("   ");
+            }
+            response->print(command.name);
+            response->print(" - ");
+            response->println(command.help);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+namespace nautic_net::console
+{
+    static const unsigned int kLineBufferSize = 128; // Longest accepted command line, including terminator
+    static const unsigned int kMaxArgCount = 4;      // Arguments per command, not counting the command name
+    static const unsigned int kMaxCommandCount = 32; // Size of the command table
+
+    //
+    // Argument specs are strings with one character per argument:
+    //
+    //   'i' - signed decimal integer
+    //   'u' - unsigned decimal integer
+    //   'x' - unsigned hexadecimal integer (with or without a "0x" prefix)
+    //   's' - string (a single whitespace-delimited token)
+    //
+    // Arguments after a '?' are optional, e.g. "u?u" takes one or two unsigned integers.
+    //
+    class Args
+    {
+    public:
+        unsigned int Count() const;
+        bool Has(unsigned int index) const;
+        int32_t GetInt(unsigned int index) const;
+        uint32_t GetUInt(unsigned int index) const;
+        const char *GetString(unsigned int index) const;
+
+    private:
+        friend class Console;
+
+        unsigned int count_ = 0;
+        const char *strings_[kMaxArgCount];
+        union
+        {
+            int32_t i;
+            uint32_t u;
+        } values_[kMaxArgCount];
+    };
+
+    //
+    // Every command writes its output through a Response. In human mode, fields are printed as "Label: value"
+    // lines, exactly like the original single-character commands did. In framed mode, the whole response is a
+    // single NMEA-style line that host tools can parse and verify:
+    //
+    //   $<command>,OK,<key>=<value>,<key>=<value>*<XOR checksum in hex>
+    //   $<command>,ERR,message=<text>*<XOR checksum in hex>
+    //
+    // Keys are derived from the labels by lowercasing them and replacing spaces with underscores. In string values
+    // (and the echoed command), the characters NMEA reserves (, * $ ! \ ^ ~) and unprintable ones are sent as ^
+    // and two hex digits, e.g. ^2C for a comma.
+    //
+    class Response : public Print
+    {
+    public:
+        Response(Print *out, bool is_framed, const char *command);
+
+        void Field(const char *label, const char *value);
+        void Field(const char *label, int value);
+        void Field(const char *label, unsigned int value, int base = DEC);
+        void Field(const char *label, long value);
+        void Field(const char *label, unsigned long value, int base = DEC);
+        void Field(const char *label, double value, int digits);
+        void Error(const char *message);
+        void Text(const char *text); // Free-form human output; dropped in framed mode
+        void End();
+
+        bool IsFramed() const;
+
+        size_t write(uint8_t c) override;
+        using Print::write;
+
+    private:
+        Print *out_;
+        bool is_framed_;
+        bool is_started_ = false;
+        bool is_ended_ = false;
+        bool is_error_ = false;
+        const char *command_;
+        uint8_t checksum_ = 0;
+
+        void WriteEscaped(const char *text);
+        void BeginField(const char *label);
+        void EndField();
+        void Start();
+    };
+
+    typedef void (*Handler)(const Args &args, Response *response);
+
+    struct Command
+    {
+        const char *name;     // Full command name, e.g. "serial"
+        char alias;           // Legacy single-character alias, e.g. 's', or 0 for none
+        const char *arg_spec; // See Args
+        const char *help;
+        Handler handler;
+    };
+
+    class Console
+    {
+    public:
+        Console(Stream *stream);
+        bool Register(const Command &command);
+        void Loop();
+
+        void SetFramed(bool is_framed);
+        bool IsFramed();
+        void PrintHelp(Response *response);
+
+        unsigned long line_count_ = 0;     // Lines received
+        unsigned long error_count_ = 0;    // Unknown commands, bad arguments
+        unsigned long overflow_count_ = 0; // Lines discarded for exceeding kLineBufferSize
+
+    private:
+        Stream *stream_;
+        Command commands_[kMaxCommandCount];
+        unsigned int command_count_ = 0;
+        bool is_framed_ = false;
+
+        char line_[kLineBufferSize];
+        unsigned int line_length_ = 0;
+        bool is_overflowed_ = false;
+
+        void HandleLine(char *line);
+        const Command *FindCommand(const char *name);
+        const Command *FindAlias(char alias);
+        bool ParseArgs(const char *arg_spec, char *tokens[], unsigned int token_count, Args *args);
+    };
+}
+
+#endif
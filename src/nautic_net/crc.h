@@ -0,0 +1,29 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace nautic_net::crc
+{
+    static const uint16_t kCRC16Initial = 0xFFFF;
+
+    // CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF); pass the previous result to checksum data in pieces
+    inline uint16_t CRC16(const void *data, size_t length, uint16_t crc = kCRC16Initial)
+    {
+        const uint8_t *bytes = (const uint8_t *)data;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= (uint16_t)bytes[i] << 8;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+
+        return crc;
+    }
+}
+
+#endif
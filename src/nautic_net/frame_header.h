@@ -0,0 +1,130 @@
+#ifndef FRAME_HEADER_H
+#define FRAME_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Reads a LoRaPacket's addressing fields straight from the encoded bytes, without decoding the payload, so a receiver
+// can drop frames that aren't for it before paying for a full pb_decode into a LoRaPacket. Walks the top-level fields
+// only, skipping over the payload message; zero padding (implicit header frames) ends the message, like
+// PB_DECODE_NULLTERMINATED.
+//
+// Tag numbers follow lora_packet.pb.h, which this doesn't include; radio.cpp checks them against it.
+//
+namespace nautic_net::frame
+{
+    static const uint32_t kHardwareIdTag = 1; // LoRaPacket_hardware_id_tag
+    static const uint32_t kAddressTag = 9;    // LoRaPacket_address_tag
+
+    typedef struct
+    {
+        uint32_t hardware_id;
+        uint32_t address;
+        uint32_t payload_tag; // Tag of the payload oneof member (LoRaPacket_*_tag), 0 if none
+    } Header;
+
+    // Reads a varint into *value, advancing *position. False if it runs past length or beyond 64 bits.
+    inline bool TryReadVarint(const uint8_t *buffer, size_t length, size_t *position, uint64_t *value)
+    {
+        *value = 0;
+
+        for (unsigned int shift = 0; shift < 64; shift += 7)
+        {
+            if (*position >= length)
+            {
+                return false;
+            }
+
+            uint8_t byte = buffer[(*position)++];
+            *value |= (uint64_t)(byte & 0x7F) << shift;
+
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // False if the frame is malformed: truncated, or using wire types LoRaPacket never has. Fields are last-wins,
+    // like pb_decode.
+    inline bool TryPeekHeader(const uint8_t *buffer, size_t length, Header *header)
+    {
+        *header = {0, 0, 0};
+        size_t position = 0;
+
+        while (position < length)
+        {
+            uint64_t key;
+            if (!TryReadVarint(buffer, length, &position, &key))
+            {
+                return false;
+            }
+
+            uint32_t tag = (uint32_t)(key >> 3);
+            if (tag == 0)
+            {
+                // Zero padding
+                return true;
+            }
+
+            uint64_t value;
+            switch (key & 0x07)
+            {
+            case 0: // Varint
+                if (!TryReadVarint(buffer, length, &position, &value))
+                {
+                    return false;
+                }
+
+                if (tag == kAddressTag)
+                {
+                    header->address = (uint32_t)value;
+                }
+                break;
+
+            case 2: // Length-delimited; every LoRaPacket message field is a payload oneof member
+                if (!TryReadVarint(buffer, length, &position, &value) || value > length - position)
+                {
+                    return false;
+                }
+
+                header->payload_tag = tag;
+                position += (size_t)value;
+                break;
+
+            case 5: // Fixed32
+                if (length - position < 4)
+                {
+                    return false;
+                }
+
+                if (tag == kHardwareIdTag)
+                {
+                    header->hardware_id = (uint32_t)buffer[position] | (uint32_t)buffer[position + 1] << 8 |
+                                          (uint32_t)buffer[position + 2] << 16 | (uint32_t)buffer[position + 3] << 24;
+                }
+                position += 4;
+                break;
+
+            case 1: // Fixed64
+                if (length - position < 8)
+                {
+                    return false;
+                }
+
+                position += 8;
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef HOST_FRAME_H
+#define HOST_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nautic_net/crc.h"
+
+//
+// Binary framing for the serial stream, for when hex-encoded LORA lines become the bottleneck (they double every
+// frame's size). The base still emits text only; this fixes the format host decoders (tools/serial_decoder) already
+// accept, so the two can be switched over independently. The rover's track log dump (trackdump) and the trace
+// (trace.h) use it already.
+//
+//   0xA5 0x5A | type | length | payload (length bytes) | CRC-16 (crc.h) of type, length and payload, little-endian
+//
+// The sync bytes aren't ASCII, so frames can be interleaved with the existing text lines on the same port.
+//
+namespace nautic_net::host_frame
+{
+    static const uint8_t kSync0 = 0xA5;
+    static const uint8_t kSync1 = 0x5A;
+    static const size_t kHeaderSize = 4;  // Sync, type and length
+    static const size_t kTrailerSize = 2; // CRC
+    static const size_t kMaxPayloadSize = 255;
+    static const size_t kMaxFrameSize = kHeaderSize + kMaxPayloadSize + kTrailerSize;
+
+    enum class Type : uint8_t
+    {
+        // RSSI (int16, dBm), SNR (int8, dB), slot (uint8), cycle of the day (uint16), then the LoRaPacket exactly as
+        // received. Multi-byte fields are little-endian.
+        kLoRa = 1,
+
+        // One track::Page, as stored (track_page.h)
+        kTrackPage = 2,
+
+        // Ends a track log dump: the number of pages in it (uint32)
+        kTrackEnd = 3,
+
+        // Trace entries (trace_events.h): the running index of the first (uint32), then the entries as stored
+        kTraceEntries = 4,
+
+        // Ends a trace dump: entries recorded since boot and entries overwritten before they were sent (uint32 each)
+        kTraceEnd = 5,
+    };
+
+    static const size_t kLoRaPrefixSize = 6;
+
+    constexpr size_t GetFrameSize(size_t payload_length)
+    {
+        return kHeaderSize + payload_length + kTrailerSize;
+    }
+
+    // Over type, length and payload, i.e. a whole frame without its sync bytes and CRC
+    inline uint16_t GetCRC(const uint8_t *frame)
+    {
+        return crc::CRC16(frame + 2, 2 + frame[3]);
+    }
+
+    // Writes a frame to out, which must hold GetFrameSize(length) bytes. Returns the frame size, or 0 if the payload
+    // is too long.
+    inline size_t Encode(Type type, const uint8_t *payload, size_t length, uint8_t *out)
+    {
+        if (length > kMaxPayloadSize)
+        {
+            return 0;
+        }
+
+        out[0] = kSync0;
+        out[1] = kSync1;
+        out[2] = (uint8_t)type;
+        out[3] = (uint8_t)length;
+        for (size_t i = 0; i < length; i++)
+        {
+            out[kHeaderSize + i] = payload[i];
+        }
+
+        uint16_t crc = GetCRC(out);
+        out[kHeaderSize + length] = crc & 0xFF;
+        out[kHeaderSize + length + 1] = crc >> 8;
+
+        return GetFrameSize(length);
+    }
+}
+
+#endif
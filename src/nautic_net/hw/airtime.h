@@ -0,0 +1,61 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+
+//
+// LoRa time on air, from the Semtech SX1276 datasheet (section 4.1.1.7). The payload CRC is always on. Defaults
+// match RadioHead's modem settings: explicit header, coding rate 4/5 and an 8-symbol preamble. Low data rate
+// optimization is assumed on whenever a symbol is longer than 16ms, as the datasheet recommends.
+//
+// Everything is constexpr so that the TDMA schedule can be sized at compile time.
+//
+namespace nautic_net::hw::airtime
+{
+    static const unsigned int kDefaultPreambleSymbolCount = 8;
+    static const unsigned int kMinPreambleSymbolCount = 6; // The SX1276 can't detect anything shorter
+    static const unsigned int kDefaultCodingRate = 5;      // Denominator: 4/5 through 4/8, as in RH_RF95::setCodingRate4()
+
+    // µs
+    constexpr unsigned long GetSymbolDuration(unsigned int sbw_khz, unsigned int sf)
+    {
+        return (1UL << sf) * 1000 / sbw_khz;
+    }
+
+    constexpr bool IsLowDataRateOptimized(unsigned int sbw_khz, unsigned int sf)
+    {
+        return GetSymbolDuration(sbw_khz, sf) > 16000;
+    }
+
+    // Symbols after the preamble, header included. payload_bytes is everything handed to the modem, i.e. including
+    // RadioHead's own header.
+    constexpr unsigned int GetPayloadSymbolCount(unsigned int sbw_khz, unsigned int sf, unsigned int payload_bytes,
+                                                 unsigned int coding_rate = kDefaultCodingRate, bool is_implicit_header = false)
+    {
+        return 8 + ((int)(8 * payload_bytes) - (int)(4 * sf) + 28 + 16 - 20 * is_implicit_header <= 0
+                        ? 0
+                        : ((8 * payload_bytes - 4 * sf + 28 + 16 - 20 * is_implicit_header) + 4 * (sf - 2 * IsLowDataRateOptimized(sbw_khz, sf)) - 1) /
+                              (4 * (sf - 2 * IsLowDataRateOptimized(sbw_khz, sf))) * coding_rate);
+    }
+
+    // µs, from the start of the preamble to the end of the payload CRC
+    constexpr unsigned long GetTimeOnAir(unsigned int sbw_khz, unsigned int sf, unsigned int payload_bytes,
+                                         unsigned int coding_rate = kDefaultCodingRate, unsigned int preamble_symbols = kDefaultPreambleSymbolCount,
+                                         bool is_implicit_header = false)
+    {
+        // The modem adds 4.25 symbols to the programmed preamble length
+        return ((preamble_symbols * 4 + 17) * GetSymbolDuration(sbw_khz, sf)) / 4 +
+               GetPayloadSymbolCount(sbw_khz, sf, payload_bytes, coding_rate, is_implicit_header) * GetSymbolDuration(sbw_khz, sf);
+    }
+
+    // Approximate receiver sensitivity in dBm: thermal noise over the bandwidth, the SX1276's ~6dB noise figure, and
+    // the demodulator's SNR limit (-7.5dB at SF7, 2.5dB lower per SF step)
+    inline int GetSensitivity(unsigned int sbw_khz, unsigned int sf)
+    {
+        int bandwidth_db = sbw_khz >= 500 ? 57 : sbw_khz >= 250 ? 54 : 51; // 10 * log10(Hz)
+
+        return -174 + bandwidth_db + 6 - (15 + 5 * ((int)sf - 7)) / 2;
+    }
+}
+
+#endif
@@ -1,98 +1,320 @@
 #include "eeprom.h"
 #include "debug.h"
+#include "nautic_net/crc.h"
 
 using namespace nautic_net::hw::eeprom;
 
+static_assert(sizeof(CompassCalibration) <= kRecordCapacities[(int)Key::kCompassCalibration], "CompassCalibration outgrew its record");
+
 EEPROM::EEPROM()
 {
+    for (unsigned int i = 0; i < kKeyCount; i++)
+    {
+        cache_entries_[i] = {};
+    }
 }
 
-void EEPROM::Setup()
+bool EEPROM::Setup()
 {
     debugln("Beginning EEPROM setup");
 
     if (eeprom_.begin(kI2CAddress))
     {
         debugln("Connected to EEPROM");
-        // EEPROM is initialized with 0xFF in every address, so let's put in some default values
-        // if it hasn't been initialized yet
-        if (eeprom_.read(kFirstByte) == 0xFF)
+        initialized_ = true;
+
+        uint32_t magic;
+        uint16_t layout_version;
+        eeprom_.read(kAddressHeader, (uint8_t *)&magic, sizeof(magic));
+        eeprom_.read(kAddressHeader + sizeof(magic), (uint8_t *)&layout_version, sizeof(layout_version));
+
+        if (magic != kMagic || layout_version != kLayoutVersion)
         {
-            Reset();
+            // EEPROM is initialized with 0xFF in every address; the original unversioned layout wrote 0 to the
+            // first byte instead, and still holds a serial number and compass calibration worth keeping
+            if (eeprom_.read(kAddressHeader) == 0x00)
+            {
+                Migrate();
+            }
+            else
+            {
+                Format();
+            }
         }
-        initialized_ = true;
+
+        LoadRecords();
         ReadSerialNumber();
+        ReadCompassCalibration();
     }
     else
     {
         debugln("Failed to connect to EEPROM");
     }
     debugln("EEPROM setup complete");
+
+    return initialized_;
 }
 
-uint32_t EEPROM::ReadSerialNumber()
+void EEPROM::Format()
 {
-    if (!initialized_)
+    debugln("Formatting EEPROM");
+
+    uint8_t header[8] = {};
+    uint32_t magic = kMagic;
+    uint16_t layout_version = kLayoutVersion;
+    memcpy(header, &magic, sizeof(magic));
+    memcpy(header + sizeof(magic), &layout_version, sizeof(layout_version));
+    eeprom_.write(kAddressHeader, header, sizeof(header));
+
+    for (unsigned int i = 0; i < kKeyCount; i++)
     {
-        return 0;
+        Erase((Key)i);
     }
+}
+
+void EEPROM::Migrate()
+{
+    debugln("Migrating EEPROM from unversioned layout");
 
-    uint8_t buffer[sizeof(uint32_t)];
-    uint32_t result;
+    uint32_t serial_number;
+    CompassCalibration cal;
+    eeprom_.read(kLegacyAddressSerialNumber, (uint8_t *)&serial_number, sizeof(serial_number));
+    eeprom_.read(kLegacyAddressCompassCalibration, (uint8_t *)&cal, sizeof(cal));
 
-    eeprom_.read(kAddressSerialNumber, buffer, sizeof(uint32_t));
-    memcpy((void *)&result, buffer, sizeof(uint32_t));
+    Format();
+    Write(Key::kSerialNumber, &serial_number, sizeof(serial_number), kSerialNumberVersion);
+    Write(Key::kCompassCalibration, &cal, sizeof(cal), kCompassCalibrationVersion);
+}
 
-    serial_number_ = result;
-    return result;
+void EEPROM::LoadRecords()
+{
+    for (unsigned int i = 0; i < kKeyCount; i++)
+    {
+        Key key = (Key)i;
+        CacheEntry &entry = cache_entries_[i];
+        entry = {};
+
+        for (uint8_t slot = 0; slot < 2; slot++)
+        {
+            RecordHeader header;
+            if (LoadSlot(key, slot, &header) && (!entry.is_valid || header.sequence > entry.sequence))
+            {
+                entry.is_valid = true;
+                entry.slot = slot;
+                entry.version = header.version;
+                entry.length = header.length;
+                entry.sequence = header.sequence;
+            }
+        }
+
+        if (entry.is_valid)
+        {
+            eeprom_.read(GetSlotAddress(key, entry.slot) + sizeof(RecordHeader), cache_ + GetCacheOffset(key), entry.length);
+        }
+    }
 }
 
-void EEPROM::WriteSerialNumber(uint32_t number)
+bool EEPROM::LoadSlot(Key key, uint8_t slot, RecordHeader *header)
 {
+    unsigned int address = GetSlotAddress(key, slot);
+
+    eeprom_.read(address, (uint8_t *)header, sizeof(RecordHeader));
+
+    // An erased slot is all zeroes (or all 0xFF on a blank chip); neither has a matching key and length
+    if (header->key != (uint8_t)key || header->length == 0 || header->length > kRecordCapacities[(int)key])
+    {
+        return false;
+    }
+
+    // The payload a piece at a time, rather than into a buffer as large as the largest record
+    RecordHeader unsigned_header = *header;
+    unsigned_header.crc = 0;
+    uint16_t crc = crc::CRC16(&unsigned_header, sizeof(RecordHeader));
+
+    uint8_t chunk[32];
+    for (unsigned int offset = 0; offset < header->length; offset += sizeof(chunk))
+    {
+        uint16_t length = header->length - offset < sizeof(chunk) ? header->length - offset : sizeof(chunk);
+        eeprom_.read(address + sizeof(RecordHeader) + offset, chunk, length);
+        crc = crc::CRC16(chunk, length, crc);
+    }
+
+    if (crc != header->crc)
+    {
+        debug("EEPROM record CRC mismatch, key ");
+        debugln((int)key);
+        crc_error_count_++;
+        return false;
+    }
+
+    return true;
+}
+
+bool EEPROM::Read(Key key, void *data, uint16_t length, uint8_t version)
+{
+    const CacheEntry &entry = cache_entries_[(int)key];
+
+    if (!entry.is_valid || entry.version != version || entry.length != length)
+    {
+        return false;
+    }
+
+    memcpy(data, cache_ + GetCacheOffset(key), length);
+    return true;
+}
+
+bool EEPROM::Write(Key key, const void *data, uint16_t length, uint8_t version)
+{
+    if (!initialized_ || length == 0 || length > kRecordCapacities[(int)key])
+    {
+        return false;
+    }
+
+    CacheEntry &entry = cache_entries_[(int)key];
+    uint8_t *cached = cache_ + GetCacheOffset(key);
+
+    // Unchanged records cost nothing
+    if (entry.is_valid && entry.version == version && entry.length == length && memcmp(cached, data, length) == 0)
+    {
+        return true;
+    }
+
+    RecordHeader header = {};
+    header.key = (uint8_t)key;
+    header.version = version;
+    header.length = length;
+    header.sequence = entry.is_valid ? entry.sequence + 1 : 1;
+    header.crc = GetRecordCRC(header, (const uint8_t *)data);
+
+    // To the slot that doesn't hold the current copy; the header goes last, so until it lands the slot still fails
+    // its key or CRC check
+    uint8_t slot = entry.is_valid ? 1 - entry.slot : 0;
+    eeprom_.write(GetSlotAddress(key, slot) + sizeof(RecordHeader), (uint8_t *)data, length);
+    eeprom_.write(GetSlotAddress(key, slot), (uint8_t *)&header, sizeof(RecordHeader));
+    write_count_++;
+
+    entry.is_valid = true;
+    entry.slot = slot;
+    entry.version = version;
+    entry.length = length;
+    entry.sequence = header.sequence;
+    memcpy(cached, data, length);
+
+    return true;
+}
+
+void EEPROM::Erase(Key key)
+{
+    cache_entries_[(int)key] = {};
+
     if (!initialized_)
     {
         return;
     }
 
-    uint8_t buffer[sizeof(uint32_t)];
+    uint8_t empty[sizeof(RecordHeader)] = {};
+    eeprom_.write(GetSlotAddress(key, 0), empty, sizeof(empty));
+    eeprom_.write(GetSlotAddress(key, 1), empty, sizeof(empty));
+}
 
-    memcpy(buffer, (void *)&number, sizeof(uint32_t));
-    eeprom_.write(kAddressSerialNumber, buffer, sizeof(uint32_t));
+uint16_t EEPROM::GetRecordCRC(const RecordHeader &header, const uint8_t *payload)
+{
+    RecordHeader unsigned_header = header;
+    unsigned_header.crc = 0;
+
+    uint16_t crc = crc::CRC16(&unsigned_header, sizeof(RecordHeader));
+    return crc::CRC16(payload, header.length, crc);
 }
 
-CompassCalibration EEPROM::ReadCompassCalibration()
+bool EEPROM::ReadLog(unsigned int offset, void *data, uint16_t length)
 {
-    if (!initialized_)
+    if (!initialized_ || offset + length > kLogRegionSize)
     {
-        return {};
+        return false;
     }
 
-    uint8_t buffer[sizeof(CompassCalibration)];
-    CompassCalibration result;
+    return eeprom_.read(kConfigRegionSize + offset, (uint8_t *)data, length);
+}
 
-    eeprom_.read(kAddressCompassCalibration, buffer, sizeof(CompassCalibration));
-    memcpy((void *)&result, buffer, sizeof(CompassCalibration));
+bool EEPROM::WriteLog(unsigned int offset, const void *data, uint16_t length)
+{
+    if (!initialized_ || offset + length > kLogRegionSize)
+    {
+        return false;
+    }
 
-    compass_calibration_ = result;
+    return eeprom_.write(kConfigRegionSize + offset, (uint8_t *)data, length);
+}
+
+unsigned int EEPROM::GetSlotAddress(Key key, uint8_t slot)
+{
+    static_assert(kAddressRecords + 2 * (kKeyCount * sizeof(RecordHeader) + SumRecordCapacities(kKeyCount)) <= kConfigRegionSize,
+                  "Configuration records don't fit in kConfigRegionSize");
+
+    unsigned int address = kAddressRecords;
+
+    for (int i = 0; i < (int)key; i++)
+    {
+        address += 2 * (sizeof(RecordHeader) + kRecordCapacities[i]);
+    }
+
+    return address + slot * (sizeof(RecordHeader) + kRecordCapacities[(int)key]);
+}
+
+unsigned int EEPROM::GetCacheOffset(Key key)
+{
+    unsigned int offset = 0;
+
+    for (int i = 0; i < (int)key; i++)
+    {
+        offset += kRecordCapacities[i];
+    }
+
+    return offset;
+}
+
+uint32_t EEPROM::ReadSerialNumber()
+{
+    uint32_t result = 0;
+    Read(Key::kSerialNumber, &result, sizeof(result), kSerialNumberVersion);
+
+    serial_number_ = result;
     return result;
 }
 
-void EEPROM::WriteCompassCalibration(CompassCalibration cal)
+void EEPROM::WriteSerialNumber(uint32_t number)
 {
-    if (!initialized_)
+    if (Write(Key::kSerialNumber, &number, sizeof(number), kSerialNumberVersion))
     {
-        return;
+        serial_number_ = number;
     }
+}
 
-    uint8_t buffer[sizeof(CompassCalibration)];
+CompassCalibration EEPROM::ReadCompassCalibration()
+{
+    CompassCalibration result = {};
+    Read(Key::kCompassCalibration, &result, sizeof(result), kCompassCalibrationVersion);
 
-    memcpy(buffer, (void *)&cal, sizeof(CompassCalibration));
-    eeprom_.write(kAddressCompassCalibration, buffer, sizeof(CompassCalibration));
+    compass_calibration_ = result;
+    return result;
+}
+
+void EEPROM::WriteCompassCalibration(CompassCalibration cal)
+{
+    if (Write(Key::kCompassCalibration, &cal, sizeof(cal), kCompassCalibrationVersion))
+    {
+        compass_calibration_ = cal;
+    }
 }
 
 void EEPROM::Reset()
 {
-    eeprom_.write(kFirstByte, 0);
-    WriteSerialNumber(0);
-    WriteCompassCalibration({});
-}
\ No newline at end of file
+    if (!initialized_)
+    {
+        return;
+    }
+
+    Format();
+    ReadSerialNumber();
+    ReadCompassCalibration();
+}
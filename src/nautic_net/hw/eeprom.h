@@ -1,6 +1,6 @@
 #ifndef EEPROM_H
 #define EEPROM_H
-#include <Adafruit_EEPROM_I2C.h>
+#include <Adafruit_FRAM_I2C.h>
 
 namespace nautic_net::hw::eeprom
 {
@@ -12,13 +12,71 @@ namespace nautic_net::hw::eeprom
         float z;
     } CompassCalibration;
 
+    //
+    // Configuration records. Every record is stored twice (slots A and B) with a header containing its key,
+    // payload version, length, a sequence number and a CRC. Writes always go to the slot NOT holding the latest
+    // copy, so a brownout mid-write leaves the previous copy intact. At boot, the valid slot with the highest
+    // sequence number wins and is cached in RAM; reads never touch I2C after that.
+    //
+    // The chip is FRAM (MB85RC256V), driven through Adafruit_FRAM_I2C: writes go out in as few I2C transactions as
+    // Wire's buffer allows, with no write cycle to wait for, so about 90 µs per byte at Wire's default 100 kHz.
+    // (Adafruit_EEPROM_I2C would write one byte per transaction and poll each for completion.) The RAM cache takes
+    // the sum of kRecordCapacities, about 1.4 KB; slots are checked and written in place, without a copy in RAM.
+    //
+    // Keys are persisted; never renumber them. Append new keys before kCount and give them a capacity below.
+    //
+    enum class Key : uint8_t
+    {
+        kSerialNumber,
+        kCompassCalibration,
+        kTDMAAssignment, // Rover: last configuration from the base
+        kRoster,         // Base: discovered rovers and their slots
+        kGPSHint,        // Last known position and time, for aiding the GPS at boot
+        kLinkStats,      // Reserved for persisted link statistics
+        kRoverPeriod,    // Rover: requested rate class (transmit every Nth cycle)
+        kCount
+    };
+
+    // Maximum payload size of each record, indexed by Key. Leave headroom for records that may grow.
+    static constexpr uint16_t kRecordCapacities[] = {
+        4,   // kSerialNumber
+        32,  // kCompassCalibration
+        64,  // kTDMAAssignment
+        1156, // kRoster: a PersistedRover (12 bytes) for each of tdma::kRosterCapacity (96) and a count; base.h checks
+        32,  // kGPSHint
+        128, // kLinkStats
+        4,   // kRoverPeriod
+    };
+    static_assert(sizeof(kRecordCapacities) / sizeof(kRecordCapacities[0]) == (unsigned int)Key::kCount, "Every record key needs a capacity");
+
+    constexpr unsigned int SumRecordCapacities(unsigned int count)
+    {
+        return count == 0 ? 0 : kRecordCapacities[count - 1] + SumRecordCapacities(count - 1);
+    }
+
+    typedef struct
+    {
+        uint8_t key;
+        uint8_t version;   // Payload format version, chosen by the owner of the record
+        uint16_t length;   // Payload length
+        uint32_t sequence; // Incremented on every write; the highest valid one is current
+        uint16_t crc;      // CRC16 of this header (with crc = 0) and the payload
+        uint16_t reserved;
+    } RecordHeader;
+
     class EEPROM
     {
     public:
         EEPROM();
-        void Setup();
+        bool Setup();
         void Reset();
 
+        // Generic record access. Reads come from the RAM cache, and fail if the stored record has a different
+        // version or length, so a layout change of a record simply falls back to defaults.
+        bool Read(Key key, void *data, uint16_t length, uint8_t version);
+        bool Write(Key key, const void *data, uint16_t length, uint8_t version);
+        void Erase(Key key);
+
         void WriteSerialNumber(uint32_t number);
         uint32_t ReadSerialNumber();
 
@@ -28,16 +86,58 @@ namespace nautic_net::hw::eeprom
         uint32_t serial_number_;
         CompassCalibration compass_calibration_;
 
+        // Raw access to the log region, everything past the configuration records. Offsets count from its start;
+        // no caching, and the caller keeps transfers short enough not to hold up slot handling.
+        bool ReadLog(unsigned int offset, void *data, uint16_t length);
+        bool WriteLog(unsigned int offset, const void *data, uint16_t length);
+
+        unsigned long write_count_ = 0;     // Record writes that actually went to I2C
+        unsigned long crc_error_count_ = 0; // Slots rejected at boot
+
+        // Everything from here to the end of the chip is free for other uses (e.g. logs)
+        static const unsigned int kConfigRegionSize = 4096;
+        static const unsigned int kChipSize = 32768; // MB85RC256V
+        static const unsigned int kLogRegionSize = kChipSize - kConfigRegionSize;
+
     private:
         static const uint8_t kI2CAddress = 0x50;
-        static const unsigned int kFirstByte = 0x00;
-        static const unsigned int kAddressSerialNumber = 0x01;
-        static const unsigned int kAddressCompassCalibration = kAddressSerialNumber + 4;
-        // NOTE: When adding the next address, leave some EXTRA bytes after kAddressCompassCalibration, in case it grows
+        static const uint32_t kMagic = 0x53434E4E; // "NNCS" - NauticNet Configuration Store
+        static const uint16_t kLayoutVersion = 1;
+        static const unsigned int kAddressHeader = 0x00;
+        static const unsigned int kAddressRecords = 0x10;
+        static const unsigned int kKeyCount = (unsigned int)Key::kCount;
+
+        // Pre-versioned layout, only used for migration
+        static const unsigned int kLegacyAddressSerialNumber = 0x01;
+        static const unsigned int kLegacyAddressCompassCalibration = kLegacyAddressSerialNumber + 4;
+
+        static const uint8_t kSerialNumberVersion = 1;
+        static const uint8_t kCompassCalibrationVersion = 1;
+
+        typedef struct
+        {
+            bool is_valid;
+            uint8_t slot; // Slot holding the cached copy (0 = A, 1 = B)
+            uint8_t version;
+            uint16_t length;
+            uint32_t sequence;
+        } CacheEntry;
 
         bool initialized_;
-        Adafruit_EEPROM_I2C eeprom_;
+        Adafruit_FRAM_I2C eeprom_;
+
+        CacheEntry cache_entries_[kKeyCount];
+        uint8_t cache_[SumRecordCapacities(kKeyCount)];
+
+        void Format();
+        void Migrate();
+        void LoadRecords();
+        bool LoadSlot(Key key, uint8_t slot, RecordHeader *header);
+        uint16_t GetRecordCRC(const RecordHeader &header, const uint8_t *payload);
+
+        static unsigned int GetSlotAddress(Key key, uint8_t slot);
+        static unsigned int GetCacheOffset(Key key);
     };
 }
 
-#endif
\ No newline at end of file
+#endif
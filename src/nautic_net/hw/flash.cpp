@@ -0,0 +1,112 @@
+#include "debug.h"
+#include "flash.h"
+
+using namespace nautic_net::hw::flash;
+
+// From the linker script: the end of the code, followed in flash by the initial values of .data
+extern uint32_t __etext;
+extern uint32_t __data_start__;
+extern uint32_t __data_end__;
+
+// The core's SysTick handler body: counts one millis() tick
+extern "C" void SysTick_DefaultHandler(void);
+
+Flash::Flash(uint32_t start, uint32_t size) : start_(start), size_(size)
+{
+}
+
+bool Flash::Setup()
+{
+    uintptr_t image_end = (uintptr_t)&__etext + ((uintptr_t)&__data_end__ - (uintptr_t)&__data_start__);
+
+    if (start_ % kRowSize != 0 || size_ % kRowSize != 0 || start_ < image_end || start_ + size_ > FLASH_SIZE)
+    {
+        debugln("Flash region overlaps the firmware; disabled");
+        return false;
+    }
+
+    is_enabled_ = true;
+    return true;
+}
+
+const void *Flash::GetPage(unsigned int page)
+{
+    return (const void *)(uintptr_t)(start_ + page * kPageSize);
+}
+
+unsigned int Flash::GetPageCount()
+{
+    return is_enabled_ ? size_ / kPageSize : 0;
+}
+
+void Flash::EraseRow(unsigned int row)
+{
+    if (!is_enabled_ || (row + 1) * kRowSize > size_)
+    {
+        return;
+    }
+
+    // ADDR takes 16-bit word addresses
+    NVMCTRL->ADDR.reg = (start_ + row * kRowSize) / 2;
+    RunCommand(NVMCTRL_CTRLA_CMD_ER);
+    erase_count_++;
+}
+
+void Flash::WritePage(unsigned int page, const void *data)
+{
+    if (!is_enabled_ || (page + 1) * kPageSize > size_)
+    {
+        return;
+    }
+
+    // Fill the page buffer a word at a time, then commit it in one go rather than whenever the last word lands
+    NVMCTRL->CTRLB.bit.MANW = 1;
+    RunCommand(NVMCTRL_CTRLA_CMD_PBC);
+
+    volatile uint32_t *destination = (volatile uint32_t *)(uintptr_t)(start_ + page * kPageSize);
+    const uint8_t *source = (const uint8_t *)data;
+    for (unsigned int i = 0; i < kPageSize / 4; i++)
+    {
+        uint32_t word;
+        memcpy(&word, source + 4 * i, sizeof(word));
+        destination[i] = word;
+    }
+
+    RunCommand(NVMCTRL_CTRLA_CMD_WP);
+    write_count_++;
+}
+
+void Flash::RunCommand(uint16_t command)
+{
+    // With interrupts off, nothing fetches from flash while the command runs; the SysTick interrupt that's pending
+    // afterwards (if any) counts one of the wraps itself
+    noInterrupts();
+    bool was_pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    unsigned int wraps = RunCommandFromRam(command);
+    bool is_pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+
+    // However many wraps it missed, the SysTick interrupt runs once at most; make up the rest here
+    for (unsigned int i = wraps + was_pending - is_pending; i > 0; i--)
+    {
+        SysTick_DefaultHandler();
+    }
+    stalled_ticks_ += wraps;
+    interrupts();
+}
+
+__attribute__((section(".ramfunc"), noinline)) unsigned int Flash::RunCommandFromRam(uint16_t command)
+{
+    // Reading CTRL clears COUNTFLAG, so each read that finds it set is one SysTick wrap (one ms) since the last. Both
+    // registers are off the flash bus, so this keeps counting while the NVM is busy.
+    unsigned int wraps = 0;
+    (void)SysTick->CTRL;
+
+    NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | command;
+    while (NVMCTRL->INTFLAG.bit.READY == 0)
+    {
+        wraps += (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0;
+    }
+    wraps += (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0;
+
+    return wraps;
+}
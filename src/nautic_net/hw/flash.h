@@ -0,0 +1,45 @@
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <Arduino.h>
+
+namespace nautic_net::hw::flash
+{
+    // SAMD21 NVM geometry: written a page at a time, erased a row at a time
+    static const unsigned int kPageSize = 64;
+    static const unsigned int kRowSize = 4 * kPageSize;
+
+    //
+    // A region of the microcontroller's internal flash, for logs too big for the EEPROM. Reads are plain memory
+    // reads. Erasing a row or writing a page stalls the CPU, interrupts included, for up to about 6 ms and 2.5 ms
+    // respectively, so the caller picks a moment when nothing is due. The command runs from RAM, counting the
+    // SysTick wraps it spans, so millis() and micros() catch up on the ticks they'd otherwise lose.
+    //
+    // Uploading firmware erases the whole application area, this region included.
+    //
+    class Flash
+    {
+    public:
+        Flash(uint32_t start, uint32_t size); // Row-aligned
+        bool Setup();                         // False if the region overlaps the firmware image
+
+        const void *GetPage(unsigned int page);
+        unsigned int GetPageCount();
+        void EraseRow(unsigned int row); // The row holding pages 4 * row through 4 * row + 3
+        void WritePage(unsigned int page, const void *data); // To an erased page
+
+        unsigned long erase_count_ = 0;
+        unsigned long write_count_ = 0;
+        unsigned long stalled_ticks_ = 0; // ms spent waiting for NVM commands, made up to millis() afterwards
+
+    private:
+        uint32_t start_;
+        uint32_t size_;
+        bool is_enabled_ = false;
+
+        void RunCommand(uint16_t command);
+        static unsigned int RunCommandFromRam(uint16_t command); // Returns the SysTick wraps it waited through
+    };
+}
+
+#endif
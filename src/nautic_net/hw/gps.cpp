@@ -3,7 +3,10 @@
 
 using namespace nautic_net::hw::gps;
 
-GPS::GPS(Uart *serial, int pps_pin) : gps_(Adafruit_GPS(serial)), pps_pin_(pps_pin)
+// Restart using all data in the receiver's battery-backed RAM (ephemeris, almanac, time, position)
+static const char *kPMTKHotStart = "$PMTK101*32";
+
+GPS::GPS(Uart *serial, int pps_pin, nautic_net::hw::eeprom::EEPROM *eeprom) : gps_(Adafruit_GPS(serial)), eeprom_(eeprom), pps_pin_(pps_pin)
 {
 }
 
@@ -12,52 +15,171 @@ void GPS::Setup()
     // PPS input
     pinMode(pps_pin_, INPUT);
 
+    setup_at_ = millis();
+
     gps_.begin(9600);
     gps_.sendCommand(PMTK_SET_NMEA_OUTPUT_RMCGGA);
     gps_.sendCommand(PMTK_SET_NMEA_UPDATE_1HZ);
 }
 
-void GPS::WaitForFix()
+void GPS::LoadHint()
 {
-    debugln("Waiting for GPS fix...");
-    digitalWrite(LED_BUILTIN, HIGH);
+    // The receiver shares our supply, so unless we came up from power-on (or a brown-out), it kept running through
+    // our reset and is already tracking or acquiring; a restart and aiding would only set it back
+    if (PM->RCAUSE.bit.POR == 0 && PM->RCAUSE.bit.BOD12 == 0 && PM->RCAUSE.bit.BOD33 == 0)
+    {
+        debugln("GPS kept running through the reset; no hint");
+        start_type_ = StartType::kRunning;
+        return;
+    }
 
-    while (!gps_.fix)
+    has_hint_ = eeprom_->Read(nautic_net::hw::eeprom::Key::kGPSHint, &hint_, sizeof(hint_), kHintVersion);
+    if (has_hint_)
     {
-        Read();
+        // Position/time aiding follows once the receiver reports its RTC time; see Read()
+        debugln("GPS hot start");
+        gps_.sendCommand(kPMTKHotStart);
+        start_type_ = StartType::kHot;
     }
+}
 
-    debugln("Got GPS fix");
-    digitalWrite(LED_BUILTIN, LOW);
+const char *GPS::GetStartTypeName(StartType start_type)
+{
+    switch (start_type)
+    {
+    case StartType::kHot:
+        return "hot";
+    case StartType::kRunning:
+        return "running";
+    default:
+        return "cold";
+    }
 }
 
 void GPS::Read()
 {
-    gps_.read();
+    if (gps_.read() != 0)
+    {
+        received_at_ = millis();
+    }
+
     if (gps_.newNMEAreceived())
     {
         if (gps_.parse(gps_.lastNMEA()))
         {
             if (gps_.fix)
             {
-                gps_seconds_ = gps_.seconds;
+                gps_second_of_day_ = gps_.hour * 3600L + gps_.minute * 60L + gps_.seconds;
+
+                if (ttff_ms_ == 0)
+                {
+                    HandleFirstFix();
+                }
+                else if (millis() - hint_saved_at_ > kHintSaveInterval)
+                {
+                    SaveHint();
+                }
+            }
+            else if (has_hint_ && !is_aided_)
+            {
+                SendAiding();
             }
         }
     }
 }
 
-int GPS::GetSyncedSecond()
+bool GPS::IsQuiet()
+{
+    unsigned long silent_for = millis() - received_at_;
+
+    return (silent_for >= kBurstGap && silent_for < kQuietWindow) || silent_for >= kSilence;
+}
+
+void GPS::HandleFirstFix()
+{
+    ttff_ms_ = max(millis() - setup_at_, 1UL);
+
+    // The status command reports the same to host tools; the serial stream itself only carries rover data
+    debug("GPS fix ttff_ms:");
+    debug(ttff_ms_);
+    debug(" start:");
+    debug(GetStartTypeName(start_type_));
+    debug(" aided:");
+    debugln(is_aided_ ? 1 : 0);
+
+    SaveHint();
+}
+
+void GPS::SendAiding()
+{
+    // The Feather M0 has no RTC, so the time has to come from the receiver's own battery-backed RTC. Without a
+    // backup battery it reports its default date (2080) until it has a fix, and aiding with a stale stored time
+    // would only slow the search down, so skip it.
+    if (gps_.year < hint_.year || gps_.year >= 80 || gps_.month == 0 || gps_.day == 0)
+    {
+        return;
+    }
+
+    // $PMTK741,Lat,Long,Alt,YYYY,MM,DD,hh,mm,ss - position from the hint, time from the receiver. Newlib-nano can't
+    // printf floats, so format the coordinates as fixed-point.
+    long lat = lround(hint_.latitude * 1000000);
+    long lon = lround(hint_.longitude * 1000000);
+    char body[80];
+    snprintf(body, sizeof(body), "PMTK741,%s%ld.%06ld,%s%ld.%06ld,%ld,%d,%02d,%02d,%02d,%02d,%02d",
+             lat < 0 ? "-" : "", labs(lat) / 1000000, labs(lat) % 1000000,
+             lon < 0 ? "-" : "", labs(lon) / 1000000, labs(lon) % 1000000,
+             lround(hint_.altitude),
+             2000 + gps_.year, gps_.month, gps_.day, gps_.hour, gps_.minute, gps_.seconds);
+
+    debugln("GPS position/time aiding");
+    SendCommandWithChecksum(body);
+    is_aided_ = true;
+}
+
+void GPS::SaveHint()
+{
+    Hint hint;
+    hint.latitude = gps_.latitudeDegrees;
+    hint.longitude = gps_.longitudeDegrees;
+    hint.altitude = gps_.altitude;
+    hint.year = gps_.year;
+    hint.month = gps_.month;
+    hint.day = gps_.day;
+    hint.hour = gps_.hour;
+    hint.minute = gps_.minute;
+    hint.second = gps_.seconds;
+    hint.fix_quality = gps_.fixquality;
+    hint.satellites = gps_.satellites;
+
+    eeprom_->Write(nautic_net::hw::eeprom::Key::kGPSHint, &hint, sizeof(hint), kHintVersion);
+    hint_saved_at_ = millis();
+}
+
+void GPS::SendCommandWithChecksum(const char *body)
+{
+    uint8_t checksum = 0;
+    for (const char *c = body; *c != 0; c++)
+    {
+        checksum ^= *c;
+    }
+
+    char sentence[96];
+    snprintf(sentence, sizeof(sentence), "$%s*%02X", body, checksum);
+    gps_.sendCommand(sentence);
+}
+
+long GPS::GetSyncedSecondOfDay()
 {
     int pps = digitalRead(pps_pin_);
     if (prev_pps_ != pps)
     {
         prev_pps_ = pps;
 
-        if (pps == HIGH && gps_seconds_ != -1)
+        if (pps == HIGH && gps_second_of_day_ != -1)
         {
-            return (gps_seconds_ + 1) % 60;
+            return (gps_second_of_day_ + 1) % 86400L;
         }
     }
 
     return -1;
-}
\ No newline at end of file
+}
@@ -1,27 +1,80 @@
 #include <Adafruit_GPS.h>
 #include <Arduino.h>
 
+#include "eeprom.h"
+
 #ifndef GPS_H
 #define GPS_H
 
 namespace nautic_net::hw::gps
 {
+    // Last known fix, persisted to aid the receiver at the next boot
+    typedef struct
+    {
+        float latitude;  // degrees
+        float longitude; // degrees
+        float altitude;  // m
+        uint8_t year;    // 2-digit, as reported by the receiver
+        uint8_t month;
+        uint8_t day;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
+        uint8_t fix_quality;
+        uint8_t satellites;
+    } Hint;
+
+    enum class StartType
+    {
+        kCold,   // No stored hint
+        kHot,    // Hot start commanded; the receiver keeps ephemeris in its battery-backed RAM
+        kRunning // Not a power-on reset, so the receiver was left alone (see LoadHint())
+    };
+
     class GPS
     {
     public:
-        GPS(Uart *serial, int pps_pin);
+        GPS(Uart *serial, int pps_pin, nautic_net::hw::eeprom::EEPROM *eeprom);
 
         Adafruit_GPS gps_;
 
         void Read();
         void Setup();
-        void WaitForFix();
-        int GetSyncedSecond();
+        void LoadHint(); // Only acts after a power-on reset
+        static const char *GetStartTypeName(StartType start_type);
+        long GetSyncedSecondOfDay(); // At the PPS edge, the second of the (UTC) day that just began; otherwise -1
+
+        // Between the receiver's once-a-second bursts of sentences, or it's silent altogether: a CPU stall (e.g.
+        // a flash write) now won't overrun the UART and cost a sentence
+        bool IsQuiet();
+
+        StartType start_type_ = StartType::kCold;
+        bool is_aided_ = false;     // Position/time aiding was sent
+        unsigned long ttff_ms_ = 0; // Time to first fix, since Setup(); 0 until the first fix
 
     private:
+        static const uint8_t kHintVersion = 1;
+        static const unsigned long kHintSaveInterval = 10 * 60 * 1000UL; // ms
+
+        nautic_net::hw::eeprom::EEPROM *eeprom_;
         int pps_pin_;
-        int gps_seconds_ = -1;
+        long gps_second_of_day_ = -1;
         int prev_pps_ = LOW;
+        unsigned long received_at_ = 0; // millis() of the last character from the receiver
+
+        static const unsigned long kBurstGap = 50;     // ms of silence that ends a burst
+        static const unsigned long kQuietWindow = 500; // ms after a burst's end that the next one can't start yet
+        static const unsigned long kSilence = 2000;    // ms of silence after which the receiver counts as silent
+
+        bool has_hint_ = false;
+        Hint hint_;
+        unsigned long setup_at_ = 0;
+        unsigned long hint_saved_at_ = 0;
+
+        void HandleFirstFix();
+        void SendAiding();
+        void SaveHint();
+        void SendCommandWithChecksum(const char *body);
     };
 }
-#endif
\ No newline at end of file
+#endif
@@ -8,7 +8,7 @@ IMU::IMU(nautic_net::hw::eeprom::EEPROM *eeprom) : eeprom_(eeprom)
 {
 }
 
-void IMU::Setup()
+bool IMU::Setup()
 {
     debug("Beginning IMU setup");
     // In the base station, the IMU board may be omitted
@@ -16,7 +16,7 @@ void IMU::Setup()
     if (!successful_init_)
     {
         debugln("Failed to initialize IMU");
-        return;
+        return false;
     }
 
     nautic_net::hw::eeprom::CompassCalibration cal = eeprom_->ReadCompassCalibration();
@@ -51,6 +51,7 @@ void IMU::Setup()
                             true);              // enabled!
 
     debugln("IMU setup complete");
+    return true;
 }
 
 void IMU::Loop()
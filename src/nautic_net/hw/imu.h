@@ -18,7 +18,7 @@ namespace nautic_net::hw::imu
     {
     public:
         IMU(nautic_net::hw::eeprom::EEPROM *eeprom);
-        void Setup();
+        bool Setup();
         void Loop();
         void BeginCompassCalibration();
         void FinishCompassCalibration();
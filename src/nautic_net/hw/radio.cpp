@@ -3,38 +3,77 @@
 
 using namespace nautic_net::hw::radio;
 
+static_assert(nautic_net::frame::kHardwareIdTag == LoRaPacket_hardware_id_tag && nautic_net::frame::kAddressTag == LoRaPacket_address_tag,
+              "frame_header.h is out of date with lora_packet.pb.h");
+
 RH_RF95 kRF95(RFM95_CS, RFM95_INT);
 
-Radio::Radio()
+Radio::Radio(nautic_net::profiler::Profiler *profiler) : profiler_(profiler)
 {
 }
 
-void Radio::Setup()
+//
+// Non-blocking; call repeatedly until it returns kReady. The manual reset sequence waits between phases by returning
+// kPending instead of calling delay().
+//
+SetupStatus Radio::Setup()
 {
-    debugln("Beginning radio setup");
-    pinMode(RFM95_RST, OUTPUT);
+    unsigned long elapsed = millis() - setup_phase_at_;
+
+    switch (setup_phase_)
+    {
+    case SetupPhase::kStart:
+        debugln("Beginning radio setup");
+        pinMode(RFM95_RST, OUTPUT);
+
+        // Manually reset radio
+        digitalWrite(RFM95_RST, HIGH);
+        SetSetupPhase(SetupPhase::kResetAsserted);
+        return SetupStatus::kPending;
 
-    // Manually reset radio
-    digitalWrite(RFM95_RST, HIGH);
-    delay(100);
-    digitalWrite(RFM95_RST, LOW);
-    delay(10);
-    digitalWrite(RFM95_RST, HIGH);
-    delay(10);
+    case SetupPhase::kResetAsserted:
+        if (elapsed < 100)
+        {
+            return SetupStatus::kPending;
+        }
+        digitalWrite(RFM95_RST, LOW);
+        SetSetupPhase(SetupPhase::kResetReleased);
+        return SetupStatus::kPending;
+
+    case SetupPhase::kResetReleased:
+        if (elapsed < 10)
+        {
+            return SetupStatus::kPending;
+        }
+        digitalWrite(RFM95_RST, HIGH);
+        SetSetupPhase(SetupPhase::kResetSettled);
+        return SetupStatus::kPending;
+
+    case SetupPhase::kResetSettled:
+        if (elapsed < 10)
+        {
+            return SetupStatus::kPending;
+        }
+        break;
+
+    case SetupPhase::kDone:
+        return SetupStatus::kReady;
+    }
 
-    while (!kRF95.init())
+    // Start over on failure, so the next attempt resets the radio again
+    SetSetupPhase(SetupPhase::kStart);
+
+    if (!kRF95.init())
     {
         debugln("LoRa radio init failed");
-        while (1)
-            ;
+        return SetupStatus::kFailed;
     }
     debugln("LoRa radio init OK!");
 
     if (!kRF95.setFrequency(RF95_FREQ))
     {
         debugln("setFrequency failed");
-        while (1)
-            ;
+        return SetupStatus::kFailed;
     }
 
     debug("Set Freq to: ");
@@ -42,57 +81,214 @@ void Radio::Setup()
 
     kRF95.setTxPower(config::kLoraPower, false);
 
+    // The radio was just reset to its defaults, whatever we configured before
+    is_image_valid_ = false;
+    staged_length_ = 0;
     Configure(config::kLoraDefaultConfig);
 
     debugln("Radio setup complete");
+    SetSetupPhase(SetupPhase::kDone);
+    return SetupStatus::kReady;
+}
+
+void Radio::SetSetupPhase(SetupPhase phase)
+{
+    setup_phase_ = phase;
+    setup_phase_at_ = millis();
 }
 
 void Radio::Configure(Config config)
 {
-    if (config.sbw != current_config_.sbw)
+    unsigned long started_at = micros();
+    RegisterImage image = GetRegisterImage(config);
+    current_config_ = config;
+
+    if (is_image_valid_ && memcmp(&image, &current_image_, sizeof(image)) == 0)
+    {
+        return;
+    }
+
+    // The modem only picks up new settings reliably in standby. RX resumes from the next TryReceive(); a staged
+    // frame stays in the FIFO.
+    kRF95.setModeIdle();
+
+    if (!is_image_valid_ || memcmp(image.frf, current_image_.frf, sizeof(image.frf)) != 0)
     {
-        kRF95.setSignalBandwidth(config.sbw * 1000);
+        kRF95.spiBurstWrite(RH_RF95_REG_06_FRF_MSB, image.frf, sizeof(image.frf));
     }
 
-    if (config.sf != current_config_.sf)
+    if (!is_image_valid_ || memcmp(image.modem, current_image_.modem, sizeof(image.modem)) != 0)
     {
-        kRF95.setSpreadingFactor(config.sf);
+        kRF95.spiBurstWrite(RH_RF95_REG_1D_MODEM_CONFIG1, image.modem, sizeof(image.modem));
     }
 
-    current_config_ = config;
+    // The length to expect when receiving with an implicit header
+    if (config.is_implicit_header && (!is_image_valid_ || image.payload_length != current_image_.payload_length))
+    {
+        kRF95.spiWrite(RH_RF95_REG_22_PAYLOAD_LENGTH, image.payload_length);
+    }
+
+    if (!is_image_valid_ || image.modem_config3 != current_image_.modem_config3)
+    {
+        kRF95.spiWrite(RH_RF95_REG_26_MODEM_CONFIG3, image.modem_config3);
+    }
+
+    current_image_ = image;
+    is_image_valid_ = true;
+    trace(kConfigure, config.sf, config.channel);
+    profiler_->Record(nautic_net::profiler::Section::kRadioConfigure, started_at);
+}
+
+void Radio::SetFilter(FrameFilter filter)
+{
+    filter_ = filter;
+}
+
+Config Radio::GetConfig()
+{
+    return current_config_;
+}
+
+float Radio::GetFrequency(unsigned int channel)
+{
+    return RF95_FREQ + channel * RF95_CHANNEL_SPACING;
+}
+
+unsigned long Radio::GetRxBadCount()
+{
+    return kRF95.rxBad();
+}
+
+int Radio::GetLastSnr()
+{
+    return kRF95.lastSNR();
+}
+
+unsigned int Radio::GetLastCodingRate()
+{
+    return last_coding_rate_;
+}
+
+size_t Radio::Encode(const LoRaPacket &packet, uint8_t *buffer)
+{
+    pb_ostream_t stream = pb_ostream_from_buffer(buffer, RH_RF95_MAX_MESSAGE_LEN);
+    pb_encode(&stream, LoRaPacket_fields, &packet);
+
+    // Implicit header frames are all the same length. Zero padding decodes as the end of the message (see
+    // TryReceive()).
+    size_t length = stream.bytes_written;
+    if (current_config_.is_implicit_header)
+    {
+        if (length > current_config_.implicit_length)
+        {
+            debugln("TX   -> packet too long for implicit header; dropped");
+            oversize_count_++;
+            return 0;
+        }
+
+        memset(buffer + length, 0, current_config_.implicit_length - length);
+        length = current_config_.implicit_length;
+    }
+
+    return length;
 }
 
 size_t Radio::Send(LoRaPacket packet)
 {
+    unsigned long started_at = micros();
+
     uint8_t buffer[RH_RF95_MAX_MESSAGE_LEN];
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-    pb_encode(&stream, LoRaPacket_fields, &packet);
+    size_t length = Encode(packet, buffer);
+    if (length == 0)
+    {
+        return 0;
+    }
 
-#ifdef SERIAL_DEBUG
-    unsigned long started_at = millis();
-#endif
+    // send() reloads the FIFO
+    staged_length_ = 0;
 
     digitalWrite(LED_BUILTIN, HIGH);
-    kRF95.send((uint8_t *)buffer, stream.bytes_written);
+    kRF95.send((uint8_t *)buffer, length);
+    profiler_->Record(nautic_net::profiler::Section::kTxStart, started_at);
+    trace(kTx, length, packet.which_payload);
+
     kRF95.waitPacketSent();
     digitalWrite(LED_BUILTIN, LOW);
+    tx_count_++;
+    trace(kTxDone, length, micros() - started_at);
+
+    return length;
+}
+
+bool Radio::Stage(LoRaPacket packet)
+{
+    uint8_t buffer[RH_RF95_HEADER_LEN + RH_RF95_MAX_MESSAGE_LEN];
+    size_t length = Encode(packet, buffer + RH_RF95_HEADER_LEN);
+    if (length == 0)
+    {
+        return false;
+    }
+
+    // RadioHead's header, as send() would write it: broadcast to and from, no ID or flags. Nothing here ever
+    // changes them.
+    buffer[0] = RH_BROADCAST_ADDRESS;
+    buffer[1] = RH_BROADCAST_ADDRESS;
+    buffer[2] = 0;
+    buffer[3] = 0;
+
+    // RadioHead transmits from FIFO address 0 (RH_RF95_REG_0E_FIFO_TX_BASE_ADDR)
+    kRF95.setModeIdle();
+    kRF95.spiWrite(RH_RF95_REG_0D_FIFO_ADDR_PTR, 0);
+    kRF95.spiBurstWrite(RH_RF95_REG_00_FIFO, buffer, RH_RF95_HEADER_LEN + length);
+    kRF95.spiWrite(RH_RF95_REG_22_PAYLOAD_LENGTH, RH_RF95_HEADER_LEN + length);
+    staged_length_ = length;
+    trace(kStage, length, packet.which_payload);
+
+    return true;
+}
+
+size_t Radio::SendStaged(unsigned long at)
+{
+    if (staged_length_ == 0)
+    {
+        return 0;
+    }
+
+    while ((long)(micros() - at) < 0)
+    {
+    }
+
+    unsigned long started_at = micros();
+    kRF95.setModeTx();
+    profiler_->Record(nautic_net::profiler::Section::kTxOffset, at);
+    profiler_->Record(nautic_net::profiler::Section::kTxStart, started_at);
+    digitalWrite(LED_BUILTIN, HIGH);
 
-#ifdef SERIAL_DEBUG
-    long airtime = millis() - started_at;
-#endif
+    size_t length = staged_length_;
+    staged_length_ = 0;
+    trace(kTxStaged, length, started_at - at);
 
-    debug("TX   -> ");
-    debug(stream.bytes_written);
-    debug(" (");
-    debug(airtime);
-    debug("ms): ");
-    DebugPacketType(packet);
+    kRF95.waitPacketSent();
+    digitalWrite(LED_BUILTIN, LOW);
+    tx_count_++;
+    trace(kTxDone, length, micros() - started_at);
 
-    return stream.bytes_written;
+    return length;
+}
+
+void Radio::DiscardStaged()
+{
+    staged_length_ = 0;
 }
 
 bool Radio::TryReceive(LoRaPacket *rx_packet, int *rssi)
 {
+    // available() would put the radio back in RX mode, and a received frame would land on top of the staged one
+    if (staged_length_ != 0)
+    {
+        return false;
+    }
+
     if (kRF95.available())
     {
         // Should be a message for us now
@@ -102,8 +298,35 @@ bool Radio::TryReceive(LoRaPacket *rx_packet, int *rssi)
 
         if (kRF95.recv(buffer, &length))
         {
+            rx_count_++;
+            trace(kRx, length, kRF95.lastRssi());
+
+            // RxCodingRate, from the frame's header; RadioHead has put the modem in standby, so it still holds
+            last_coding_rate_ = current_config_.is_implicit_header ? current_config_.coding_rate : (kRF95.spiRead(RH_RF95_REG_18_MODEM_STAT) >> 5) + 4;
+
+            // Drop what we don't care about before decoding into a full LoRaPacket
+            nautic_net::frame::Header header;
+            if (!nautic_net::frame::TryPeekHeader(buffer, length, &header))
+            {
+                trace(kRxMalformed, length, 0);
+                rx_malformed_count_++;
+                return false;
+            }
+
+            if (filter_ != nullptr && !filter_(header))
+            {
+                rx_filtered_count_++;
+                return false;
+            }
+
             pb_istream_t stream = pb_istream_from_buffer(buffer, length);
-            pb_decode(&stream, LoRaPacket_fields, rx_packet);
+            if (!pb_decode_ex(&stream, LoRaPacket_fields, rx_packet, PB_DECODE_NULLTERMINATED))
+            {
+                trace(kRxMalformed, length, 0);
+                rx_malformed_count_++;
+                return false;
+            }
+
             *rssi = kRF95.lastRssi();
 
             // Print packet as hexadecimal, for consumption by nautic_net_device
@@ -121,34 +344,10 @@ bool Radio::TryReceive(LoRaPacket *rx_packet, int *rssi)
             }
             Serial.println();
 
-            debug("RX <-   ");
-            debug(length);
-            debug(" (");
-            debug(*rssi);
-            debug(" dBm): ");
-            DebugPacketType(*rx_packet);
+            trace(kRxPacket, rx_packet->which_payload, rx_packet->address);
             return true;
         }
     }
 
     return false;
 }
-
-void Radio::DebugPacketType(LoRaPacket packet)
-{
-    switch (packet.which_payload)
-    {
-    case LoRaPacket_rover_discovery_tag:
-        debugln("RoverDiscovery");
-        break;
-    case LoRaPacket_rover_data_tag:
-        debugln("RoverData");
-        break;
-    case LoRaPacket_rover_configuration_tag:
-        debugln("RoverConfiguration");
-        break;
-    default:
-        debugln("Unknown");
-        break;
-    }
-}
@@ -12,33 +12,147 @@
 #include <Wire.h>
 
 #include "lora_packet.pb.h"
+#include "nautic_net/frame_header.h"
+#include "nautic_net/hw/airtime.h"
+#include "nautic_net/profiler.h"
 
 #define RFM95_CS 8
 #define RFM95_RST 4
 #define RFM95_INT 3
-#define RF95_FREQ 915.0
+#define RF95_FREQ 915.0           // MHz, channel 0
+#define RF95_CHANNEL_SPACING 1.0 // MHz; enough for 500kHz channels
 
 namespace nautic_net::hw::radio
 {
+    //
+    // A PHY profile. The payload CRC is always on. In implicit header mode the receiver has to know the coding rate
+    // and length up front, so every frame is zero-padded to implicit_length (see Send()).
+    //
     typedef struct
     {
         unsigned int sbw;
         unsigned int sf;
+        unsigned int channel;
+        unsigned int coding_rate;     // Denominator: 5 through 8 for 4/5 through 4/8
+        unsigned int preamble;        // Symbols, 6 or more
+        bool is_implicit_header;
+        unsigned int implicit_length; // Bytes after RadioHead's header, in implicit header mode
     } Config;
 
+    //
+    // The modem registers a Config maps to. Configure() writes them in a few SPI bursts, and only the groups that
+    // differ from what the radio already holds, instead of going through RadioHead's setters (a read-modify-write
+    // transaction per setting).
+    //
+    typedef struct
+    {
+        uint8_t frf[3];         // RH_RF95_REG_06_FRF_MSB through RH_RF95_REG_08_FRF_LSB
+        uint8_t modem[5];       // RH_RF95_REG_1D_MODEM_CONFIG1 through RH_RF95_REG_21_PREAMBLE_LSB
+        uint8_t payload_length; // RH_RF95_REG_22_PAYLOAD_LENGTH; 0 in explicit header mode, where send() sets it
+        uint8_t modem_config3;  // RH_RF95_REG_26_MODEM_CONFIG3
+    } RegisterImage;
+
+    constexpr uint32_t GetFrequencyRegister(unsigned int channel)
+    {
+        return (uint32_t)((RF95_FREQ + channel * RF95_CHANNEL_SPACING) * 1000000.0 / RH_RF95_FSTEP);
+    }
+
+    // GetFrequencyRegister() is double arithmetic, which the M0 only has in software, so Configure() looks channels
+    // up here instead; tdma.h checks that config::kChannelCount fits
+    static const unsigned int kMaxChannelCount = 8;
+    static constexpr uint32_t kFrequencyRegisters[kMaxChannelCount] = {
+        GetFrequencyRegister(0), GetFrequencyRegister(1), GetFrequencyRegister(2), GetFrequencyRegister(3),
+        GetFrequencyRegister(4), GetFrequencyRegister(5), GetFrequencyRegister(6), GetFrequencyRegister(7)};
+
+    constexpr uint32_t GetChannelFrequencyRegister(unsigned int channel)
+    {
+        return channel < kMaxChannelCount ? kFrequencyRegisters[channel] : GetFrequencyRegister(channel);
+    }
+
+    // Same mapping as RH_RF95::setSignalBandwidth()
+    constexpr uint8_t GetBandwidthCode(unsigned int sbw_khz)
+    {
+        return sbw_khz <= 7 ? 0 : sbw_khz <= 10 ? 1 : sbw_khz <= 15 ? 2 : sbw_khz <= 20 ? 3 : sbw_khz <= 31 ? 4 : sbw_khz <= 41 ? 5 : sbw_khz <= 62 ? 6 : sbw_khz <= 125 ? 7 : sbw_khz <= 250 ? 8 : 9;
+    }
+
+    constexpr RegisterImage GetRegisterImage(Config config)
+    {
+        return RegisterImage{
+            {(uint8_t)(GetChannelFrequencyRegister(config.channel) >> 16), (uint8_t)(GetChannelFrequencyRegister(config.channel) >> 8), (uint8_t)GetChannelFrequencyRegister(config.channel)},
+            {(uint8_t)(GetBandwidthCode(config.sbw) << 4 | (config.coding_rate - 4) << 1 | (config.is_implicit_header ? RH_RF95_IMPLICIT_HEADER_MODE_ON : 0)),
+             (uint8_t)(config.sf << 4 | RH_RF95_PAYLOAD_CRC_ON),
+             0x64, // Symbol timeout; the SX1276's reset value, which RadioHead never changes
+             (uint8_t)(config.preamble >> 8),
+             (uint8_t)config.preamble},
+            (uint8_t)(config.is_implicit_header ? RH_RF95_HEADER_LEN + config.implicit_length : 0),
+            (uint8_t)(RH_RF95_AGC_AUTO_ON | (airtime::IsLowDataRateOptimized(config.sbw, config.sf) ? RH_RF95_LOW_DATA_RATE_OPTIMIZE : 0))};
+    }
+
+    // Returns true to keep a received frame, judging by its header alone (see frame_header.h)
+    typedef bool (*FrameFilter)(const nautic_net::frame::Header &header);
+
+    enum class SetupStatus
+    {
+        kPending,
+        kReady,
+        kFailed // Call Setup() again to retry from the beginning
+    };
+
     class Radio
     {
     public:
-        Radio();
-        void Setup();
+        Radio(nautic_net::profiler::Profiler *profiler);
+        SetupStatus Setup();
         size_t Send(LoRaPacket packet);
+
+        // Encodes a frame and loads it into the FIFO ahead of its slot, so that SendStaged() only has to key the
+        // transmitter. Uses the current Config, so Configure() for the TX slot first. The radio idles until the frame
+        // is sent or discarded; TryReceive() can't re-enter RX, since received frames would overwrite it.
+        bool Stage(LoRaPacket packet);
+
+        // Keys the transmitter at micros() == at, spinning until then if it's still ahead, and records how late that
+        // actually happened (profiler::Section::kTxOffset). Blocks until the frame is sent.
+        size_t SendStaged(unsigned long at);
+        void DiscardStaged();
+
         bool TryReceive(LoRaPacket *rx_packet, int *rssi);
+        void SetFilter(FrameFilter filter); // nullptr keeps every frame
         void Configure(Config config);
+        Config GetConfig();
+        unsigned long GetRxBadCount(); // Frames dropped for a bad CRC, e.g. collisions
+        int GetLastSnr();              // dB, of the last frame TryReceive() returned
+        unsigned int GetLastCodingRate(); // Denominator the same frame was sent with
+
+        static float GetFrequency(unsigned int channel); // MHz
+
+        unsigned long tx_count_ = 0;       // Packets sent
+        unsigned long rx_count_ = 0;           // Packets received, including ones dropped below
+        unsigned long rx_malformed_count_ = 0; // Packets with a good CRC that didn't decode
+        unsigned long rx_filtered_count_ = 0;  // Packets dropped by the FrameFilter without decoding
+        unsigned long oversize_count_ = 0;     // Packets not sent because they didn't fit the implicit length
 
     private:
+        enum class SetupPhase
+        {
+            kStart,
+            kResetAsserted,
+            kResetReleased,
+            kResetSettled,
+            kDone
+        };
+
+        nautic_net::profiler::Profiler *profiler_;
+        FrameFilter filter_ = nullptr;
         Config current_config_;
+        RegisterImage current_image_;
+        bool is_image_valid_ = false; // current_image_ matches the radio; false after a reset
+        size_t staged_length_ = 0;    // Bytes in the FIFO waiting for SendStaged(), RadioHead's header excluded
+        unsigned int last_coding_rate_ = 0;
+        SetupPhase setup_phase_ = SetupPhase::kStart;
+        unsigned long setup_phase_at_ = 0;
 
-        static void DebugPacketType(LoRaPacket packet);
+        void SetSetupPhase(SetupPhase phase);
+        size_t Encode(const LoRaPacket &packet, uint8_t *buffer);
     };
 }
 
@@ -0,0 +1,29 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <stdint.h>
+
+//
+// How the SAMD21's flash and RAM are shared out. The mem command (memory_stats.h) checks the running firmware
+// against this, and tools/size_report checks a build's linker map, so a regression fails on the host rather than as
+// a stack/heap collision at a regatta.
+//
+// RAM, from the bottom: .data and .bss (static), then the heap growing up, and the stack growing down from the top.
+// Nothing stops the two meeting, so both get a reserve, and static RAM gets what's left.
+//
+namespace nautic_net::memory
+{
+    // Flash: the bootloader, then the image (.text, .rodata and .data's initial values), then the track log
+    // (rover/track_log.h) at the top
+    static const uint32_t kFlashSize = 256 * 1024UL;
+    static const uint32_t kBootloaderSize = 8 * 1024UL;
+    static const uint32_t kTrackLogFlashSize = 128 * 1024UL;
+    static const uint32_t kImageBudget = kFlashSize - kBootloaderSize - kTrackLogFlashSize;
+
+    static const uint32_t kRamSize = 32 * 1024UL;
+    static const uint32_t kStackReserve = 4 * 1024UL; // Deepest stack expected; compare with mem's high-water mark
+    static const uint32_t kHeapReserve = 2 * 1024UL;  // Static constructors (std::set, String) and later allocations
+    static const uint32_t kStaticRamBudget = kRamSize - kStackReserve - kHeapReserve; // .data and .bss
+}
+
+#endif
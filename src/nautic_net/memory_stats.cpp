@@ -0,0 +1,74 @@
+#include <malloc.h>
+
+#include "nautic_net/memory_stats.h"
+
+using namespace nautic_net::memory;
+
+extern "C" char *sbrk(int increment);
+
+// From the linker script
+extern uint32_t __data_start__;
+extern uint32_t __data_end__;
+extern uint32_t __bss_start__;
+extern uint32_t __bss_end__;
+extern uint32_t __StackTop;
+
+static const uint32_t kPaint = 0xC5C5C5C5;
+static const uintptr_t kPaintMargin = 256; // Bytes below our own frame left alone, for the calls painting makes
+
+static uint32_t *GetHeapTop()
+{
+    return (uint32_t *)(((uintptr_t)sbrk(0) + 3) & ~(uintptr_t)3);
+}
+
+void Memory::PaintStack()
+{
+    uint8_t here;
+
+    painted_from_ = GetHeapTop();
+    painted_to_ = (uint32_t *)(((uintptr_t)&here - kPaintMargin) & ~(uintptr_t)3);
+    for (volatile uint32_t *word = painted_from_; word < painted_to_; word++)
+    {
+        *word = kPaint;
+    }
+}
+
+Stats Memory::GetStats()
+{
+    uint8_t here;
+    struct mallinfo heap = mallinfo();
+    uint32_t *heap_top = GetHeapTop();
+
+    Stats stats = {};
+    stats.static_data = (uintptr_t)&__data_end__ - (uintptr_t)&__data_start__;
+    stats.static_bss = (uintptr_t)&__bss_end__ - (uintptr_t)&__bss_start__;
+    stats.heap_arena = heap.arena;
+    stats.heap_used = heap.uordblks;
+    stats.heap_free = heap.fordblks;
+    stats.heap_free_chunks = heap.ordblks;
+    stats.stack_used = (uintptr_t)&__StackTop - (uintptr_t)&here;
+    stats.gap = (uintptr_t)&here - (uintptr_t)heap_top;
+
+    if (painted_to_ == nullptr)
+    {
+        return stats;
+    }
+
+    // The heap may have grown into the painted area since; what it holds doesn't count
+    const volatile uint32_t *deepest = painted_from_ > heap_top ? painted_from_ : heap_top;
+    while (deepest < painted_to_ && *deepest == kPaint)
+    {
+        deepest++;
+    }
+
+    stats.stack_max = (uintptr_t)&__StackTop - (uintptr_t)deepest;
+    stats.min_gap = (uintptr_t)deepest - (uintptr_t)heap_top;
+
+    return stats;
+}
+
+bool Memory::IsWithinBudget(const Stats &stats)
+{
+    return stats.static_data + stats.static_bss <= kStaticRamBudget && stats.heap_arena <= kHeapReserve &&
+           stats.stack_max <= kStackReserve;
+}
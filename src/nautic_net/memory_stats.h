@@ -0,0 +1,41 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <Arduino.h>
+
+#include "nautic_net/memory_budget.h"
+
+namespace nautic_net::memory
+{
+    typedef struct
+    {
+        uint32_t static_data;   // .data, bytes
+        uint32_t static_bss;    // .bss
+        uint32_t heap_arena;    // Taken from the heap/stack gap so far; the heap never gives it back
+        uint32_t heap_used;     // Allocated
+        uint32_t heap_free;     // Freed but held by the arena; the fragmentation
+        uint32_t heap_free_chunks;
+        uint32_t stack_used;    // Now
+        uint32_t stack_max;     // Deepest since PaintStack(); 0 if it wasn't painted
+        uint32_t gap;           // Between the heap's top and the stack, now
+        uint32_t min_gap;       // Between the heap's top and the deepest stack since PaintStack()
+    } Stats;
+
+    //
+    // Stack and heap usage on the running firmware. PaintStack() fills the gap between the heap and the stack with
+    // a pattern at boot; the deepest the stack has been is where the pattern starts, searching up from the heap.
+    //
+    class Memory
+    {
+    public:
+        void PaintStack(); // As early in setup() as possible
+        Stats GetStats();
+        bool IsWithinBudget(const Stats &stats); // memory_budget.h
+
+    private:
+        uint32_t *painted_from_ = nullptr;
+        uint32_t *painted_to_ = nullptr;
+    };
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include "nautic_net/profiler.h"
+
+using namespace nautic_net::profiler;
+
+Profiler::Profiler()
+{
+    Reset();
+}
+
+void Profiler::Record(Section section, unsigned long started_at)
+{
+    unsigned long elapsed = micros() - started_at;
+    Stats &stats = stats_[(int)section];
+
+    stats.count++;
+    stats.total_us += elapsed;
+    stats.min_us = stats.count == 1 ? elapsed : min(stats.min_us, elapsed);
+    stats.max_us = max(stats.max_us, elapsed);
+}
+
+void Profiler::Reset()
+{
+    for (int i = 0; i < (int)Section::kCount; i++)
+    {
+        stats_[i] = {};
+    }
+}
+
+const Stats &Profiler::GetStats(Section section)
+{
+    return stats_[(int)section];
+}
+
+const char *Profiler::GetName(Section section)
+{
+    switch (section)
+    {
+    case Section::kLoop:
+        return "Loop";
+    case Section::kSlot:
+        return "Slot";
+    case Section::kReceive:
+        return "Receive";
+    case Section::kConsole:
+        return "Console";
+    case Section::kRadioConfigure:
+        return "Configure";
+    case Section::kTxStart:
+        return "TX start";
+    case Section::kTxOffset:
+        return "TX offset";
+    default:
+        return "Unknown";
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+namespace nautic_net::profiler
+{
+    enum class Section
+    {
+        kLoop,           // One full pass through loop()
+        kSlot,           // Slot transition handling (radio reconfiguration + TX)
+        kReceive,        // Receiving, decoding and handling a packet
+        kConsole,        // Serial console processing
+        kRadioConfigure, // Switching radio profiles (Radio::Configure() calls that change anything)
+        kTxStart,        // From Radio::Send()/SendStaged() until the transmitter is keyed
+        kTxOffset,       // From the TX slot boundary until the transmitter is keyed; max - min is the TX jitter
+        kCount           // Not a section; the number of sections
+    };
+
+    typedef struct
+    {
+        unsigned long count;
+        unsigned long total_us;
+        unsigned long min_us;
+        unsigned long max_us;
+    } Stats;
+
+    class Profiler
+    {
+    public:
+        Profiler();
+        void Record(Section section, unsigned long started_at);
+        void Reset();
+
+        const Stats &GetStats(Section section);
+        static const char *GetName(Section section);
+
+    private:
+        Stats stats_[(int)Section::kCount];
+    };
+}
+
+#endif
@@ -7,13 +7,27 @@
 using namespace nautic_net::rover;
 
 Rover::Rover(nautic_net::hw::radio::Radio *radio, nautic_net::hw::gps::GPS *gps, nautic_net::hw::imu::IMU *imu, nautic_net::hw::eeprom::EEPROM *eeprom)
-    : radio_(radio), gps_(gps), imu_(imu), eeprom_(eeprom)
+    : track_log_(gps, imu), radio_(radio), gps_(gps), imu_(imu), eeprom_(eeprom)
 {
 }
 
 void Rover::Setup()
 {
     cal_switch_state_ = HIGH;
+
+    uint8_t requested_period;
+    if (eeprom_->Read(nautic_net::hw::eeprom::Key::kRoverPeriod, &requested_period, sizeof(requested_period), kRoverPeriodVersion))
+    {
+        requested_period_ = tdma::GetValidPeriod(requested_period, tdma::kSuperframeCycleCount);
+    }
+
+    ClearConfiguration();
+    if (TryResumeConfiguration())
+    {
+        debugln("Resumed persisted TDMA configuration");
+    }
+
+    track_log_.Setup();
 }
 
 void Rover::Loop()
@@ -41,39 +55,173 @@ void Rover::Loop()
     }
 
     last_cal_reading_ = cal_reading;
+
+    // Without a fix we can't tell, so keep transmitting at the full rate
+    if (!gps_->gps_.fix || gps_->gps_.speed >= kStationarySpeed)
+    {
+        moving_at_ = millis();
+    }
+
+    // Send a scheduled discovery once its sub-slot begins
+    if (is_discovery_scheduled_ && (long)(micros() - discovery_at_) >= 0)
+    {
+        is_discovery_scheduled_ = false;
+        SendDiscovery();
+    }
+
+    // Build and stage our next data frame shortly before its slot, then key the transmitter right on the boundary,
+    // rather than whenever loop() notices the transition
+    if (tx_state_ == TxState::kScheduled && (long)(micros() - (tx_slot_.started_at - kStageLead)) >= 0)
+    {
+        // Only once; HandleSlot() tries again at the boundary
+        tx_state_ = Stage(tx_slot_, is_backfill_scheduled_) ? TxState::kStaged : TxState::kIdle;
+    }
+
+    if (tx_state_ == TxState::kStaged && (long)(micros() - (tx_slot_.started_at - kSpinLead)) >= 0)
+    {
+        SendStaged(tx_slot_);
+        tx_state_ = TxState::kSent;
+    }
+
+    // Flash writes stall everything, so keep them clear of our transmissions and the GPS's sentences
+    track_log_.Loop(IsIdleFor(TrackLog::kMaxStall) && gps_->IsQuiet());
+}
+
+bool Rover::IsIdleFor(unsigned long duration)
+{
+    unsigned long now = micros();
+
+    if (is_discovery_scheduled_ && (long)(discovery_at_ - now) < (long)duration)
+    {
+        return false;
+    }
+
+    if (tx_state_ == TxState::kScheduled && (long)(tx_slot_.started_at - kStageLead - now) < (long)duration)
+    {
+        return false;
+    }
+
+    if (tx_state_ == TxState::kStaged && (long)(tx_slot_.started_at - kSpinLead - now) < (long)duration)
+    {
+        return false;
+    }
+
+    return true;
 }
 
 void Rover::HandleSlot(tdma::Slot slot)
 {
+    cycle_ = slot.cycle;
+
+    // A frame scheduled for this slot has settled what it carries; otherwise it's up to the slot
+    bool is_backfill = tx_state_ == TxState::kIdle ? IsBackfillSlot(slot) : is_backfill_scheduled_;
+
     // Change radio parameters depending on the slot type
-    if (IsMyTransmitSlot(slot))
+    if (IsMyTransmitSlot(slot) || is_backfill)
     {
-        radio_->Configure(radio_config_);
+        radio_->Configure(GetTransmitConfig(slot));
     }
     else
     {
+        // Only ever scheduled for the very next slot
+        radio_->DiscardStaged();
+        tx_state_ = TxState::kIdle;
         radio_->Configure(config::kLoraDefaultConfig);
     }
 
+    // A resumed configuration is confirmed once a full cycle has passed since the first frame we sent with it, i.e.
+    // the base has had all of that cycle's configuration slots to reset or reconfigure us
+    if (state_ == RoverState::kResumed && slot.number == 0 && has_sent_since_resume_ &&
+        (slot.cycle + tdma::kCyclesPerDay - resumed_sent_cycle_) % tdma::kCyclesPerDay >= 2)
+    {
+        debugln("Resumed configuration confirmed");
+        state_ = RoverState::kConfigured;
+    }
+
     if (state_ == RoverState::kUnconfigured && slot.type == tdma::SlotType::kRoverDiscovery)
     {
-        // Add 80ms random delay to avoid collisions if many devices are trying to be discovered at once
-        // (discovery message duration is ~12ms at 500kHz/SF7)
-        delay(random(80));
-        SendDiscovery();
+        // Slotted ALOHA with exponential backoff (see tdma/discovery.h); the frame goes out from Loop() once its
+        // sub-slot begins, instead of blocking here. Sub-slots count from the slot boundary, not from whenever the
+        // transition was noticed, so they line up with the base's
+        unsigned int sub_slot;
+        if (backoff_.HandleDiscoverySlot(random(0x7FFFFFFF), &sub_slot))
+        {
+            discovery_at_ = slot.started_at + sub_slot * (tdma::kSlotDuration / tdma::kDiscoverySubSlotCount);
+            is_discovery_scheduled_ = true;
+        }
+    }
+    else if (IsSendSlot(slot) && tx_state_ != TxState::kSent)
+    {
+        // Loop() didn't get to it before the boundary, or nothing was scheduled because the previous slot was a
+        // reserved one; either way, send now
+        if (tx_state_ == TxState::kStaged || Stage(slot, false))
+        {
+            SendStaged(slot);
+        }
     }
-    else if (state_ == RoverState::kConfigured && IsMyTransmitSlot(slot))
+    else if (is_backfill && tx_state_ != TxState::kSent)
     {
-        SendData();
+        // Likewise, e.g. for a lent slot right after a configuration slot
+        if (tx_state_ == TxState::kStaged || Stage(slot, true))
+        {
+            SendStaged(slot);
+        }
     }
+
+    tx_state_ = TxState::kIdle;
+    is_backfill_scheduled_ = false;
+
+    // Nobody listens to a rover during data slots, so the radio can switch to our TX profile ahead of time, and
+    // Loop() can stage the frame without missing anything
+    tdma::Slot next_slot = tdma::TDMA::GetNextSlot(slot);
+    if (slot.type == tdma::SlotType::kRoverData && (IsSendSlot(next_slot) || IsBackfillSlot(next_slot)))
+    {
+        radio_->Configure(GetTransmitConfig(next_slot));
+        tx_slot_ = next_slot;
+        tx_state_ = TxState::kScheduled;
+        is_backfill_scheduled_ = !IsSendSlot(next_slot);
+        trace(kRoverSlot, next_slot.number, is_backfill_scheduled_);
+    }
+}
+
+bool Rover::IsSendSlot(tdma::Slot slot)
+{
+    if (state_ == RoverState::kUnconfigured || !IsMyTransmitSlot(slot))
+    {
+        return false;
+    }
+
+    return !IsStationary() || (slot.cycle / period_) % kStationaryDivisor == 0;
+}
+
+bool Rover::IsBackfillSlot(tdma::Slot slot)
+{
+    // Backfill only carries our network address
+    if (state_ == RoverState::kUnconfigured || address_ == 0 || !backfill_.HasPending() || IsSendSlot(slot))
+    {
+        return false;
+    }
+
+    return IsMyTransmitSlot(slot) || backfill_.IsLentSlot(slot);
+}
+
+nautic_net::hw::radio::Config Rover::GetTransmitConfig(tdma::Slot slot)
+{
+    // The base only lends slot sets that are free on every channel, where it listens as it would for channel 0
+    unsigned int assigned_channel = IsMyTransmitSlot(slot) ? radio_config_.channel : 0;
+
+    nautic_net::hw::radio::Config tx_config = radio_config_;
+    tx_config.channel = tdma::GetTransmitChannel(tdma::kChannelPlan, tdma::kChannelCount, slot.number / tdma::kRoverSlotInterval, assigned_channel);
+    tx_config.implicit_length = tdma::kRoverDataImplicitLength;
+    return tx_config;
 }
 
 void Rover::SendDiscovery()
 {
     RoverDiscovery discovery;
-    discovery.dummy_field = 0;
+    discovery.period = requested_period_;
 
-    LoRaPacket packet;
+    LoRaPacket packet = LoRaPacket_init_zero;
     packet.hardware_id = util::get_hardware_id();
     packet.serial_number = eeprom_->serial_number_;
     packet.payload.rover_discovery = discovery;
@@ -82,7 +230,57 @@ void Rover::SendDiscovery()
     radio_->Send(packet);
 }
 
-void Rover::SendData()
+bool Rover::Stage(tdma::Slot slot, bool is_backfill)
+{
+    // No backfill pending leaves nothing to send, rather than an empty RoverBackfill
+    LoRaPacket packet;
+    if (is_backfill && !GetBackfill(slot, &packet))
+    {
+        return false;
+    }
+
+    if (!is_backfill)
+    {
+        packet = GetData();
+    }
+
+    if (!radio_->Stage(packet))
+    {
+        return false;
+    }
+
+    is_staged_backfill_ = is_backfill;
+    staged_data_ = packet.payload.rover_data;
+    return true;
+}
+
+void Rover::SendStaged(tdma::Slot slot)
+{
+    if (radio_->SendStaged(slot.started_at) == 0)
+    {
+        return;
+    }
+
+    // A frame only counts once it's on the air: a data frame discarded from the FIFO goes out again under the same
+    // sequence number, and backfill stays pending
+    if (is_staged_backfill_)
+    {
+        backfill_.HandleSent();
+    }
+    else
+    {
+        backfill_.Record(staged_data_, slot);
+        send_counter_++;
+
+        if (!has_sent_since_resume_)
+        {
+            has_sent_since_resume_ = true;
+            resumed_sent_cycle_ = slot.cycle;
+        }
+    }
+}
+
+LoRaPacket Rover::GetData()
 {
     // Negative integers are not efficient to encode in protobuf, so let's avoid -90° through 0° by normalizing
     // the heel angle such that 0° is full counter-clockwise deflection (laying flat to the left), and 180°
@@ -93,7 +291,7 @@ void Rover::SendData()
 
     // These values are fixed-point integers with 0.1 precision
     uint32_t encoded_cog = (uint32_t)(gps_->gps_.angle * 10);
-    uint32_t encoded_sog = (uint32_t)(gps_->gps_.speed * 10);
+    uint32_t encoded_sog = min((uint32_t)(gps_->gps_.speed * 10), 16383U); // Two varint bytes (tdma::kRoverDataPayloadSize)
     uint32_t encoded_heading = (uint32_t)(imu_->compass_angle_deg_ * 10);
 
     RoverData data;
@@ -103,10 +301,12 @@ void Rover::SendData()
     data.longitude = gps_->gps_.longitudeDegrees;
     data.cog = encoded_cog;
     data.sog = encoded_sog;
+    data.sequence = send_counter_ % tdma::kSequenceModulus;
 
-    // Occasionally include battery voltage (a value of 0 takes up no extra bytes)
-    send_counter_++;
-    if ((send_counter_ % 10) == 0)
+    // Occasionally include battery voltage (a value of 0 takes up no extra bytes). Counting this frame, which
+    // send_counter_ doesn't until it's sent.
+    unsigned int count = send_counter_ + 1;
+    if ((count % 10) == 0)
     {
         data.battery = util::ReadBatteryPercentage();
     }
@@ -115,13 +315,58 @@ void Rover::SendData()
         data.battery = 0;
     }
 
-    LoRaPacket packet;
-    packet.hardware_id = util::get_hardware_id();
-    packet.serial_number = eeprom_->serial_number_;
+    // Identify ourselves in full until the base has confirmed our address, and then occasionally (offset from the
+    // battery reading, so both don't land in the same frame)
+    bool is_identified = address_ == 0 || state_ == RoverState::kResumed || (count % kIdentityInterval) == kIdentityInterval / 2;
+
+    LoRaPacket packet = LoRaPacket_init_zero;
+    packet.hardware_id = is_identified ? util::get_hardware_id() : 0;
+    packet.serial_number = is_identified ? eeprom_->serial_number_ : 0;
+    packet.address = address_;
     packet.payload.rover_data = data;
     packet.which_payload = LoRaPacket_rover_data_tag;
 
-    radio_->Send(packet);
+    return packet;
+}
+
+bool Rover::GetBackfill(tdma::Slot slot, LoRaPacket *packet)
+{
+    // As much as fits in the micro-slot at our coding rate, or in an implicit header frame. The table assumes the
+    // data profile the base assigns; anything else (a legacy RoverConfiguration) only gets a data frame's worth.
+    nautic_net::hw::radio::Config tx_config = GetTransmitConfig(slot);
+    bool is_data_profile = tx_config.sbw == config::kLoraRoverDataConfig.sbw && tx_config.sf == config::kLoraRoverDataConfig.sf &&
+                           tx_config.preamble == config::kLoraRoverDataConfig.preamble && tx_config.coding_rate >= 5 && tx_config.coding_rate <= 8;
+    size_t max_length = is_data_profile ? tdma::kMaxMicroSlotFrameSize[tx_config.coding_rate - 5] - RH_RF95_HEADER_LEN : tdma::kRoverDataImplicitLength;
+
+    if (tx_config.is_implicit_header && tx_config.implicit_length < max_length)
+    {
+        max_length = tx_config.implicit_length;
+    }
+
+    *packet = LoRaPacket_init_zero;
+    packet->address = address_;
+
+    return backfill_.TryFill(packet, max_length);
+}
+
+bool Rover::IsForMe(const nautic_net::frame::Header &header)
+{
+    switch (header.payload_tag)
+    {
+    case LoRaPacket_rover_configuration_tag:
+        return header.hardware_id == util::get_hardware_id();
+
+    case LoRaPacket_rover_reset_tag:
+        // 0 resets every rover
+        return header.hardware_id == 0 || header.hardware_id == util::get_hardware_id();
+
+    case LoRaPacket_rover_configuration_batch_tag: // Each rover looks for its own assignment in it
+    case LoRaPacket_base_beacon_tag:
+        return true;
+
+    default:
+        return false;
+    }
 }
 
 void Rover::HandlePacket(LoRaPacket packet, int rssi)
@@ -132,19 +377,38 @@ void Rover::HandlePacket(LoRaPacket packet, int rssi)
         Configure(packet);
     }
 
+    if (packet.which_payload == LoRaPacket_rover_configuration_batch_tag)
+    {
+        ConfigureFromBatch(packet.payload.rover_configuration_batch);
+    }
+
     // Allow the base station to reset us (hardware_id 0 is destined for ALL rovers)
     if (packet.which_payload == LoRaPacket_rover_reset_tag && (packet.hardware_id == 0 || packet.hardware_id == util::get_hardware_id()))
     {
         debugln("Got reset packet");
         ResetConfiguration();
     }
+
+    if (packet.which_payload == LoRaPacket_base_beacon_tag)
+    {
+        const BaseBeacon &beacon = packet.payload.base_beacon;
+        backoff_.SetAdvertisedWindow(beacon.contention_window);
+
+        for (unsigned int i = 0; i < beacon.backfill_requests_count; i++)
+        {
+            if (address_ != 0 && beacon.backfill_requests[i].address == address_)
+            {
+                backfill_.HandleRequest(beacon.backfill_requests[i], cycle_);
+            }
+        }
+    }
 }
 
 void Rover::Configure(LoRaPacket packet)
 {
     RoverConfiguration configPayload = packet.payload.rover_configuration;
 
-    ResetConfiguration();
+    ClearConfiguration();
 
     debugln("Got rover configuration: ");
     debug(" - SBW: ");
@@ -160,13 +424,89 @@ void Rover::Configure(LoRaPacket packet)
         tx_slots_[configPayload.slots[i]] = true;
     }
 
+    radio_config_ = config::kLoraRoverDataConfig;
     radio_config_.sbw = configPayload.sbw;
     radio_config_.sf = configPayload.sf;
+    radio_config_.channel = 0;
 
     state_ = RoverState::kConfigured;
+    SaveConfiguration();
+}
+
+void Rover::ConfigureFromBatch(const RoverConfigurationBatch &batch)
+{
+    if (batch.contention_window != 0)
+    {
+        backoff_.SetAdvertisedWindow(batch.contention_window);
+    }
+
+    for (unsigned int i = 0; i < batch.assignments_count; i++)
+    {
+        const RoverAssignment &assignment = batch.assignments[i];
+        if (assignment.hardware_id != util::get_hardware_id())
+        {
+            continue;
+        }
+
+        ClearConfiguration();
+
+        debugln("Got rover assignment: ");
+        debug(" - SBW: ");
+        debugln(assignment.sbw);
+        debug(" - SF: ");
+        debugln(assignment.sf);
+        debug(" - Channel: ");
+        debugln(assignment.channel);
+        debug(" - Period: ");
+        debugln(assignment.period);
+        debug(" - Phase: ");
+        debugln(assignment.phase);
+        debug(" - Micro-slot: ");
+        debugln(assignment.micro_slot);
+        debug(" - Address: ");
+        debugln(assignment.address);
+        debug(" - Coding rate: 4/");
+        debugln(GetCodingRate(assignment.coding_rate));
+
+        for (unsigned int j = 0; j < assignment.count; j++)
+        {
+            unsigned int slot = assignment.offset + j * assignment.interval;
+            if (slot >= tdma::kSlotCount)
+            {
+                break;
+            }
+
+            debug(" - TX slot: ");
+            debugln(slot);
+
+            tx_slots_[slot] = true;
+        }
+
+        radio_config_ = config::kLoraRoverDataConfig;
+        radio_config_.sbw = assignment.sbw;
+        radio_config_.sf = assignment.sf;
+        radio_config_.channel = assignment.channel;
+        radio_config_.coding_rate = GetCodingRate(assignment.coding_rate);
+        period_ = tdma::GetValidPeriod(assignment.period, tdma::kSuperframeCycleCount);
+        phase_ = assignment.phase % period_;
+        micro_slot_ = assignment.micro_slot < tdma::kMicroSlotCount ? assignment.micro_slot : 0;
+        address_ = assignment.address;
+
+        state_ = RoverState::kConfigured;
+        SaveConfiguration();
+        return;
+    }
 }
 
 void Rover::ResetConfiguration()
+{
+    ClearConfiguration();
+
+    // Don't resume a configuration the base has asked us to drop
+    eeprom_->Erase(nautic_net::hw::eeprom::Key::kTDMAAssignment);
+}
+
+void Rover::ClearConfiguration()
 {
     for (unsigned int i = 0; i < tdma::kSlotCount; i++)
     {
@@ -174,11 +514,119 @@ void Rover::ResetConfiguration()
     }
 
     radio_config_ = config::kLoraDefaultConfig;
+    radio_->DiscardStaged();
+    tx_state_ = TxState::kIdle;
+    period_ = 1;
+    phase_ = 0;
+    micro_slot_ = 0;
+    address_ = 0;
+
+    // Start discovery over from the smallest window
+    backoff_.Reset();
+    is_discovery_scheduled_ = false;
 
     state_ = RoverState::kUnconfigured;
 }
 
+void Rover::SaveConfiguration()
+{
+    TDMAAssignment assignment = {};
+
+    for (unsigned int i = 0; i < tdma::kSlotCount; i++)
+    {
+        if (tx_slots_[i])
+        {
+            assignment.tx_slots[i / 8] |= 1 << (i % 8);
+        }
+    }
+
+    assignment.sbw = radio_config_.sbw;
+    assignment.sf = radio_config_.sf;
+    assignment.channel = radio_config_.channel;
+    assignment.period = period_;
+    assignment.phase = phase_;
+    assignment.micro_slot = micro_slot_;
+    assignment.address = address_;
+    assignment.coding_rate = radio_config_.coding_rate;
+
+    eeprom_->Write(nautic_net::hw::eeprom::Key::kTDMAAssignment, &assignment, sizeof(assignment), kTDMAAssignmentVersion);
+}
+
+unsigned int Rover::GetCodingRate(unsigned int assigned)
+{
+    // 0 (or anything out of range) means the data profile's own
+    return assigned >= 5 && assigned <= 8 ? assigned : config::kLoraRoverDataConfig.coding_rate;
+}
+
+bool Rover::TryResumeConfiguration()
+{
+    TDMAAssignment assignment;
+
+    if (!eeprom_->Read(nautic_net::hw::eeprom::Key::kTDMAAssignment, &assignment, sizeof(assignment), kTDMAAssignmentVersion))
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < tdma::kSlotCount; i++)
+    {
+        tx_slots_[i] = (assignment.tx_slots[i / 8] & (1 << (i % 8))) != 0;
+    }
+
+    radio_config_ = config::kLoraRoverDataConfig;
+    radio_config_.sbw = assignment.sbw;
+    radio_config_.sf = assignment.sf;
+    radio_config_.channel = assignment.channel;
+    radio_config_.coding_rate = GetCodingRate(assignment.coding_rate);
+    period_ = tdma::GetValidPeriod(assignment.period, tdma::kSuperframeCycleCount);
+    phase_ = assignment.phase % period_;
+    micro_slot_ = assignment.micro_slot < tdma::kMicroSlotCount ? assignment.micro_slot : 0;
+    address_ = assignment.address;
+
+    // Start transmitting right away; the base resets or reconfigures us if this assignment conflicts with its roster
+    state_ = RoverState::kResumed;
+    has_sent_since_resume_ = false;
+
+    return true;
+}
+
+bool Rover::IsConfigured()
+{
+    return state_ != RoverState::kUnconfigured;
+}
+
+bool Rover::IsStationary()
+{
+    return millis() - moving_at_ > kStationaryDelay;
+}
+
+void Rover::SetRequestedPeriod(unsigned int period)
+{
+    requested_period_ = tdma::GetValidPeriod(period, tdma::kSuperframeCycleCount);
+
+    uint8_t persisted = requested_period_;
+    eeprom_->Write(nautic_net::hw::eeprom::Key::kRoverPeriod, &persisted, sizeof(persisted), kRoverPeriodVersion);
+
+    // The base only hands out rate classes at discovery
+    ResetConfiguration();
+}
+
+unsigned int Rover::GetRequestedPeriod()
+{
+    return requested_period_;
+}
+
+unsigned int Rover::GetPeriod()
+{
+    return period_;
+}
+
+unsigned int Rover::GetPhase()
+{
+    return phase_;
+}
+
 bool Rover::IsMyTransmitSlot(tdma::Slot slot)
 {
-    return (slot.type == tdma::SlotType::kRoverData && tx_slots_[slot.number]);
+    return (slot.type == tdma::SlotType::kRoverData && tx_slots_[slot.number] && slot.micro_slot == micro_slot_ &&
+            tdma::IsActiveCycle(slot.cycle, period_, phase_));
 }
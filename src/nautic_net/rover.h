@@ -3,19 +3,47 @@
 
 #include "lora_packet.pb.h"
 #include "config.h"
+#include "nautic_net/hw/eeprom.h"
 #include "nautic_net/hw/gps.h"
 #include "nautic_net/hw/imu.h"
 #include "nautic_net/hw/radio.h"
+#include "nautic_net/rover/backfill.h"
+#include "nautic_net/rover/track_log.h"
 #include "nautic_net/tdma.h"
+#include "nautic_net/tdma/discovery.h"
 
 namespace nautic_net::rover
 {
     enum class RoverState
     {
         kUnconfigured,
+        kResumed, // Transmitting with the configuration persisted before a reboot, until the base objects
         kConfigured
     };
 
+    // Our next data frame, prepared ahead of its slot
+    enum class TxState
+    {
+        kIdle,
+        kScheduled, // Radio configured for the slot; Loop() stages the frame kStageLead before it
+        kStaged,    // Frame in the radio's FIFO; Loop() keys the transmitter at the boundary
+        kSent
+    };
+
+    // The rover's configuration, persisted so that it can resume transmitting immediately after a reboot
+    typedef struct
+    {
+        uint8_t tx_slots[(tdma::kSlotCount + 7) / 8]; // Bitmap, indexed by slot number
+        uint16_t sbw;
+        uint8_t sf;
+        uint8_t channel;
+        uint8_t period; // Transmits in cycles where cycle % period == phase
+        uint8_t phase;
+        uint8_t micro_slot;
+        uint16_t address;
+        uint8_t coding_rate; // Denominator, 5 through 8
+    } TDMAAssignment;
+
     class Rover
     {
     public:
@@ -25,6 +53,21 @@ namespace nautic_net::rover
         void HandlePacket(LoRaPacket packet, int rssi);
         void HandleSlot(tdma::Slot slot);
         void ResetConfiguration();
+        bool IsConfigured();
+        bool IsStationary();
+
+        // Radio FrameFilter: configuration, resets and beacons for this rover; other rovers' traffic is dropped
+        static bool IsForMe(const nautic_net::frame::Header &header);
+
+        // Rate class to ask for at the next discovery (transmit every Nth cycle); rediscovers to apply it
+        void SetRequestedPeriod(unsigned int period);
+        unsigned int GetRequestedPeriod();
+        unsigned int GetPeriod();
+        unsigned int GetPhase();
+
+        tdma::DiscoveryBackoff backoff_;
+        TrackLog track_log_;
+        Backfill backfill_;
 
     private:
         nautic_net::hw::radio::Radio *radio_;
@@ -38,13 +81,62 @@ namespace nautic_net::rover
         int last_cal_reading_;
         unsigned long last_cal_debounce_time_;
         unsigned int send_counter_;
+        bool has_sent_since_resume_ = false;
+        unsigned long resumed_sent_cycle_ = 0; // Of the first data frame sent after resuming
+
+        // A RoverDiscovery waiting for its sub-slot within the current discovery slot
+        bool is_discovery_scheduled_ = false;
+        unsigned long discovery_at_ = 0; // micros()
+
+        // Staging close to the slot keeps the frame's GPS and IMU values fresh; spinning from kSpinLead covers the
+        // time loop() can spend elsewhere, e.g. reading the GPS and IMU
+        static const unsigned long kStageLead = 10000; // µs
+        static const unsigned long kSpinLead = 2000;   // µs
+        TxState tx_state_ = TxState::kIdle;
+        tdma::Slot tx_slot_;
+        bool is_backfill_scheduled_ = false; // tx_slot_ carries a RoverBackfill rather than RoverData
+        bool is_staged_backfill_ = false;    // Likewise for the frame in the radio's FIFO
+        RoverData staged_data_;              // Recorded for backfill once it's sent
+        unsigned long cycle_ = 0;            // Of the latest slot
+
+        static const uint8_t kTDMAAssignmentVersion = 6;
+        static const uint8_t kRoverPeriodVersion = 1;
+
+        // While stationary, only transmit in every kStationaryDivisor-th of our assigned cycles. The slots stay
+        // ours, so the rover is back at its full rate as soon as it moves.
+        static constexpr float kStationarySpeed = 0.5;             // knots
+        static const unsigned long kStationaryDelay = 60 * 1000UL; // ms below kStationarySpeed
+        static const unsigned int kStationaryDivisor = 6;
+
+        unsigned int requested_period_ = 1;
+        unsigned int period_ = 1;
+        unsigned int phase_ = 0;
+        unsigned int micro_slot_ = 0; // Within each of our TX slots
+        unsigned int address_ = 0;    // Network address from the base; 0 if we don't have one
+
+        // Data frames that carry our hardware ID and serial number, besides the network address: every
+        // kIdentityInterval-th, so the base can check our address and relearn our serial number after a reboot
+        static const unsigned int kIdentityInterval = 10;
+        unsigned long moving_at_ = 0; // millis(); last time we had no fix or were above kStationarySpeed
 
         bool tx_slots_[tdma::kSlotCount]; // Which slots this rover is configured to TX during
         nautic_net::hw::radio::Config radio_config_ = nautic_net::config::kLoraDefaultConfig;
 
         void SendDiscovery();
-        void SendData();
-        void Configure(LoRaPacket packet);
+        bool Stage(tdma::Slot slot, bool is_backfill); // Builds the frame for slot and loads it into the radio
+        void SendStaged(tdma::Slot slot);              // Counts a data frame as sent, once it is
+        LoRaPacket GetData();
+        bool GetBackfill(tdma::Slot slot, LoRaPacket *packet); // False if nothing is pending
+        bool IsSendSlot(tdma::Slot slot); // Our TX slot, and not skipped while stationary
+        bool IsBackfillSlot(tdma::Slot slot); // Spare: our TX slot skipped while stationary, or one lent by the base
+        bool IsIdleFor(unsigned long duration); // µs; no frame is due to be staged or sent within it
+        nautic_net::hw::radio::Config GetTransmitConfig(tdma::Slot slot);
+        void Configure(LoRaPacket packet); // Legacy single-rover RoverConfiguration
+        void ConfigureFromBatch(const RoverConfigurationBatch &batch);
+        void ClearConfiguration();
+        void SaveConfiguration();
+        static unsigned int GetCodingRate(unsigned int assigned);
+        bool TryResumeConfiguration();
         bool IsMyTransmitSlot(tdma::Slot slot);
     };
 }
@@ -0,0 +1,163 @@
+#include <pb_encode.h>
+
+#include "backfill.h"
+
+using namespace nautic_net::rover;
+using namespace nautic_net;
+
+Backfill::Backfill()
+{
+    for (unsigned int i = 0; i < kHistoryLength; i++)
+    {
+        history_[i].state = SampleState::kEmpty;
+    }
+}
+
+void Backfill::Record(const RoverData &data, tdma::Slot slot)
+{
+    unsigned int sequence = data.sequence % kHistoryLength;
+    Sample &sample = history_[sequence];
+
+    // Overwrites the frame from kHistoryLength ago, which the base has given up on by now
+    if (sample.state == SampleState::kPending)
+    {
+        pending_count_--;
+    }
+
+    sample.latitude = (int32_t)(data.latitude * 1e7);
+    sample.longitude = (int32_t)(data.longitude * 1e7);
+    sample.heading = data.heading;
+    sample.heel = data.heel;
+    sample.cog = data.cog;
+    sample.sog = data.sog;
+    sample.cycle = slot.cycle;
+    sample.slot = slot.number;
+    sample.state = SampleState::kSent;
+
+    newest_ = sequence;
+}
+
+void Backfill::HandleRequest(const BackfillRequest &request, unsigned long cycle)
+{
+    for (unsigned int n = 0; n < 32; n++)
+    {
+        Sample &sample = history_[(request.sequence + n) % kHistoryLength];
+        if ((request.missing & (1UL << n)) == 0 || sample.state != SampleState::kSent)
+        {
+            continue;
+        }
+
+        sample.state = SampleState::kPending;
+        pending_count_++;
+        requested_count_++;
+    }
+
+    // Slot sets are numbered from 1, so that 0 (none) takes up no room in the beacon
+    has_lent_slot_set_ = request.slot_set >= 1 && request.slot_set <= tdma::kSlotSetCount && request.micro_slot < tdma::kMicroSlotCount;
+    lent_slot_set_ = request.slot_set - 1;
+    lent_micro_slot_ = request.micro_slot;
+    lent_cycle_ = cycle;
+}
+
+bool Backfill::HasPending()
+{
+    return pending_count_ > 0;
+}
+
+unsigned int Backfill::GetPendingCount()
+{
+    return pending_count_;
+}
+
+bool Backfill::IsLentSlot(tdma::Slot slot)
+{
+    return has_lent_slot_set_ && slot.type == tdma::SlotType::kRoverData && slot.cycle == lent_cycle_ &&
+           slot.number % tdma::kRoverSlotInterval == lent_slot_set_ * tdma::kSlotCountPerTransmit &&
+           slot.micro_slot == lent_micro_slot_;
+}
+
+bool Backfill::TryFill(LoRaPacket *packet, size_t max_length)
+{
+    RoverBackfill &backfill = packet->payload.rover_backfill;
+    backfill = RoverBackfill_init_zero;
+    packet->which_payload = LoRaPacket_rover_backfill_tag;
+
+    filled_count_ = 0;
+
+    // Oldest first, i.e. starting right after the newest
+    for (unsigned int n = 1; n <= kHistoryLength && filled_count_ < 1 + kMaxDeltas; n++)
+    {
+        unsigned int sequence = (newest_ + n) % kHistoryLength;
+        const Sample &sample = history_[sequence];
+        if (sample.state != SampleState::kPending)
+        {
+            continue;
+        }
+
+        if (filled_count_ == 0)
+        {
+            backfill.sequence = sequence;
+            backfill.cycle = sample.cycle;
+            backfill.slot = sample.slot;
+            backfill.latitude = sample.latitude;
+            backfill.longitude = sample.longitude;
+            backfill.heading = sample.heading;
+            backfill.heel = sample.heel;
+            backfill.cog = sample.cog;
+            backfill.sog = sample.sog;
+        }
+        else
+        {
+            unsigned int previous_sequence = filled_[filled_count_ - 1];
+            const Sample &previous = history_[previous_sequence];
+
+            BackfillDelta &delta = backfill.deltas[backfill.deltas_count++];
+            delta.sequence = (sequence + kHistoryLength - previous_sequence) % kHistoryLength - 1;
+            delta.slots = GetSlotsBetween(previous, sample);
+            delta.latitude = sample.latitude - previous.latitude;
+            delta.longitude = sample.longitude - previous.longitude;
+            delta.heading = (int32_t)sample.heading - previous.heading;
+            delta.heel = (int32_t)sample.heel - previous.heel;
+            delta.cog = (int32_t)sample.cog - previous.cog;
+            delta.sog = (int32_t)sample.sog - previous.sog;
+
+            // Without a hardware ID or serial number, the first sample alone is smaller than a data frame
+            // (tdma::kRoverDataFrameSize), so it always fits; the rest only while they do
+            size_t length;
+            if (!pb_get_encoded_size(&length, LoRaPacket_fields, packet) || length > max_length)
+            {
+                backfill.deltas_count--;
+                break;
+            }
+        }
+
+        filled_[filled_count_++] = sequence;
+    }
+
+    return filled_count_ > 0;
+}
+
+void Backfill::HandleSent()
+{
+    for (unsigned int i = 0; i < filled_count_; i++)
+    {
+        // Unless a data frame has overwritten it meanwhile
+        Sample &sample = history_[filled_[i]];
+        if (sample.state == SampleState::kPending)
+        {
+            sample.state = SampleState::kSent;
+            pending_count_--;
+            sent_count_++;
+        }
+    }
+
+    frame_count_ += filled_count_ > 0;
+    filled_count_ = 0;
+}
+
+unsigned long Backfill::GetSlotsBetween(const Sample &from, const Sample &to)
+{
+    unsigned long cycles = (to.cycle + tdma::kCyclesPerDay - from.cycle) % tdma::kCyclesPerDay;
+
+    return cycles * tdma::kSlotCount + to.slot - from.slot;
+}
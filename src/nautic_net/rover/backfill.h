@@ -0,0 +1,81 @@
+#ifndef BACKFILL_H
+#define BACKFILL_H
+
+#include "lora_packet.pb.h"
+#include "nautic_net/tdma.h"
+
+namespace nautic_net::rover
+{
+    //
+    // Radio backfill. Every data frame we send stays in a history indexed by its sequence number, so the last
+    // tdma::kSequenceModulus of them (two minutes at the full rate) can be sent again. The base's beacons list the
+    // ones it missed (BackfillRequest); those go out again as RoverBackfill frames in slots that would otherwise stay
+    // empty: our own slots skipped while stationary, and a slot set the base lends us for the rest of a cycle.
+    //
+    // A RoverBackfill carries as many samples as fit in a micro-slot, oldest first, each with the cycle and slot it
+    // was first sent in; the first in full, the rest as deltas from the one before. The base keeps asking until they
+    // arrive, or gives up after a few beacons without any (e.g. after we rebooted and lost the history).
+    //
+    class Backfill
+    {
+    public:
+        static const unsigned int kMaxDeltas = sizeof(RoverBackfill::deltas) / sizeof(BackfillDelta);
+
+        Backfill();
+
+        void Record(const RoverData &data, tdma::Slot slot); // Every data frame, once it's sent
+        void HandleRequest(const BackfillRequest &request, unsigned long cycle); // cycle: when the beacon came
+
+        bool HasPending();
+        unsigned int GetPendingCount();
+        bool IsLentSlot(tdma::Slot slot); // In the slot set the base lent us for backfill
+
+        // Puts the oldest pending samples in packet's payload, as many as keep the encoded packet within max_length.
+        // False if none are pending. They stay pending until HandleSent(), in case the frame is discarded instead.
+        bool TryFill(LoRaPacket *packet, size_t max_length);
+        void HandleSent(); // The latest TryFill() went out
+
+        unsigned long requested_count_ = 0; // Samples the base asked for that we still had
+        unsigned long sent_count_ = 0;      // Samples resent, each time
+        unsigned long frame_count_ = 0;
+
+    private:
+        static const unsigned int kHistoryLength = tdma::kSequenceModulus;
+
+        enum class SampleState : uint8_t
+        {
+            kEmpty,
+            kSent,
+            kPending // The base asked for it again
+        };
+
+        // RoverData as sent, with coordinates in fixed point so that deltas are exact
+        typedef struct
+        {
+            int32_t latitude;  // degrees * 1e7
+            int32_t longitude; // degrees * 1e7
+            uint16_t heading;  // In RoverData's units
+            uint16_t heel;
+            uint16_t cog;
+            uint16_t sog;
+            uint16_t cycle; // Cycle of the day and slot it was sent in
+            uint8_t slot;
+            SampleState state;
+        } Sample;
+
+        Sample history_[kHistoryLength]; // Indexed by sequence number
+        unsigned int filled_[1 + kMaxDeltas]; // Sequence numbers in the latest TryFill()
+        unsigned int filled_count_ = 0;
+        unsigned int newest_ = 0;        // Sequence number of the latest frame
+        unsigned int pending_count_ = 0;
+
+        bool has_lent_slot_set_ = false;
+        unsigned int lent_slot_set_ = 0;
+        unsigned int lent_micro_slot_ = 0;
+        unsigned long lent_cycle_ = 0; // Only lent until this cycle ends
+
+        static unsigned long GetSlotsBetween(const Sample &from, const Sample &to);
+    };
+}
+
+#endif
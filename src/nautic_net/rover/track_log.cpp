@@ -0,0 +1,295 @@
+#include <Arduino.h>
+
+#include "debug.h"
+#include "nautic_net/host_frame.h"
+#include "track_log.h"
+
+using namespace nautic_net::rover;
+using namespace nautic_net;
+
+TrackLog::TrackLog(nautic_net::hw::gps::GPS *gps, nautic_net::hw::imu::IMU *imu)
+    : flash_(FLASH_SIZE - kFlashSize, kFlashSize), gps_(gps), imu_(imu)
+{
+}
+
+void TrackLog::Setup()
+{
+    if (flash_.Setup())
+    {
+        Recover();
+
+        debug("Track log holds ");
+        debug(span_);
+        debugln(" pages");
+    }
+
+    next_sample_at_ = millis();
+}
+
+// Finds the ring's ends from the page sequence numbers. They all lie within one ring's length of each other, so
+// comparing them as differences from any one of them survives the 16-bit wrap.
+void TrackLog::Recover()
+{
+    unsigned int page_count = flash_.GetPageCount();
+    bool has_pages = false;
+    uint16_t reference = 0;
+    int newest_offset = 0, oldest_offset = 0;
+    unsigned int newest = 0;
+
+    for (unsigned int i = 0; i < page_count; i++)
+    {
+        if (!IsValid(i))
+        {
+            continue;
+        }
+
+        uint16_t sequence = ((const track::Page *)flash_.GetPage(i))->sequence;
+        if (!has_pages)
+        {
+            has_pages = true;
+            reference = sequence;
+            newest = i;
+            oldest_ = i;
+        }
+
+        int offset = (int16_t)(sequence - reference);
+        if (offset > newest_offset)
+        {
+            newest_offset = offset;
+            newest = i;
+        }
+        if (offset < oldest_offset)
+        {
+            oldest_offset = offset;
+            oldest_ = i;
+        }
+    }
+
+    if (!has_pages)
+    {
+        head_ = 0;
+        oldest_ = 0;
+        span_ = 0;
+        sequence_ = 0;
+        is_row_erased_ = false;
+        return;
+    }
+
+    // A head that has caught up with the oldest page means a full ring, not an empty one
+    head_ = (newest + 1) % page_count;
+    span_ = head_ == oldest_ ? page_count : (head_ + page_count - oldest_) % page_count;
+    sequence_ = reference + newest_offset + 1;
+
+    // The rest of the newest page's row was erased with it, unless a write was torn; then start on a fresh row
+    is_row_erased_ = head_ % 4 != 0;
+    for (unsigned int i = head_; is_row_erased_ && i % 4 != 0; i++)
+    {
+        is_row_erased_ = IsErased(i);
+    }
+
+    if (!is_row_erased_ && head_ % 4 != 0)
+    {
+        unsigned int skipped = 4 - head_ % 4;
+        head_ = (head_ + skipped) % page_count;
+        span_ = span_ + skipped < page_count ? span_ + skipped : page_count;
+        oldest_ = span_ == page_count ? head_ : oldest_;
+    }
+}
+
+void TrackLog::Loop(bool can_stall)
+{
+    if ((long)(millis() - next_sample_at_) >= 0)
+    {
+        Sample();
+    }
+
+    // A dump step blocks on USB for a few hundred bytes, so it waits for a quiet moment like flash does
+    if (is_dumping_)
+    {
+        if (can_stall)
+        {
+            StepDump();
+        }
+    }
+    else if (queued_count_ > 0 && can_stall)
+    {
+        // One stall per loop at most
+        if (!is_row_erased_)
+        {
+            EraseHeadRow();
+        }
+        else
+        {
+            WriteQueued();
+        }
+    }
+}
+
+void TrackLog::Sample()
+{
+    // Evenly spaced, so the page only needs the first sample's time; after a long stall, skip ahead rather than
+    // fill pages with stale copies
+    unsigned long now = millis();
+    next_sample_at_ += track::kSampleInterval;
+    if ((long)(now - next_sample_at_) > (long)(2 * track::kSampleInterval))
+    {
+        next_sample_at_ = now + track::kSampleInterval;
+    }
+
+    if (sample_index_ == 0)
+    {
+        const Adafruit_GPS &gps = gps_->gps_;
+
+        page_ = {};
+        page_.time = now;
+        page_.second_of_day = gps.fix ? gps.hour * 3600L + gps.minute * 60L + gps.seconds : track::kNoFix;
+        page_.latitude = (int32_t)(gps.latitudeDegrees * 1e7);
+        page_.longitude = (int32_t)(gps.longitudeDegrees * 1e7);
+        page_.sog = min((uint32_t)(gps.speed * 10), 65535U);
+        page_.cog = (uint16_t)(gps.angle * 10);
+    }
+
+    track::Sample &sample = page_.samples[sample_index_++];
+    sample.heading = (uint16_t)(imu_->compass_angle_deg_ * 10);
+    sample.heel = (int16_t)(imu_->heel_angle_deg_ * 10);
+
+    if (sample_index_ < track::kSamplesPerPage)
+    {
+        return;
+    }
+
+    sample_index_ = 0;
+    if (flash_.GetPageCount() == 0)
+    {
+        return;
+    }
+
+    if (queued_count_ == kQueueCapacity)
+    {
+        dropped_page_count_++;
+        return;
+    }
+
+    queue_[queued_count_++] = page_;
+}
+
+void TrackLog::EraseHeadRow()
+{
+    // Rows ahead of the head hold the oldest pages once the ring has gone round
+    if (span_ + 4 > flash_.GetPageCount())
+    {
+        oldest_ = (head_ + 4) % flash_.GetPageCount();
+        span_ = flash_.GetPageCount() - 4;
+    }
+
+    flash_.EraseRow(head_ / 4);
+    is_row_erased_ = true;
+}
+
+void TrackLog::WriteQueued()
+{
+    track::Page &page = queue_[0];
+    page.sequence = sequence_++;
+    page.crc = track::GetCRC(page);
+    flash_.WritePage(head_, &page);
+
+    head_ = (head_ + 1) % flash_.GetPageCount();
+    span_++;
+    is_row_erased_ = head_ % 4 != 0;
+
+    queued_count_--;
+    memmove(queue_, queue_ + 1, queued_count_ * sizeof(track::Page));
+}
+
+bool TrackLog::BeginDump()
+{
+    if (flash_.GetPageCount() == 0 || is_dumping_)
+    {
+        return false;
+    }
+
+    // Pages finished meanwhile queue up; the ring doesn't move under the dump
+    is_dumping_ = true;
+    dump_page_ = oldest_;
+    dump_remaining_ = span_;
+    dumped_page_count_ = 0;
+
+    return true;
+}
+
+bool TrackLog::IsDumping()
+{
+    return is_dumping_;
+}
+
+void TrackLog::StepDump()
+{
+    // Nobody to send it to
+    if (!Serial.dtr())
+    {
+        is_dumping_ = false;
+        return;
+    }
+
+    uint8_t frames[kDumpPagesPerLoop * host_frame::GetFrameSize(sizeof(track::Page))];
+    size_t length = 0;
+
+    for (unsigned int i = 0; i < kDumpPagesPerLoop && dump_remaining_ > 0; i++)
+    {
+        if (IsValid(dump_page_))
+        {
+            length += host_frame::Encode(host_frame::Type::kTrackPage, (const uint8_t *)flash_.GetPage(dump_page_),
+                                         sizeof(track::Page), frames + length);
+            dumped_page_count_++;
+        }
+
+        dump_page_ = (dump_page_ + 1) % flash_.GetPageCount();
+        dump_remaining_--;
+    }
+
+    if (dump_remaining_ == 0)
+    {
+        uint8_t count[4] = {(uint8_t)dumped_page_count_, (uint8_t)(dumped_page_count_ >> 8),
+                            (uint8_t)(dumped_page_count_ >> 16), (uint8_t)(dumped_page_count_ >> 24)};
+        uint8_t end[host_frame::GetFrameSize(sizeof(count))];
+        host_frame::Encode(host_frame::Type::kTrackEnd, count, sizeof(count), end);
+
+        Serial.write(frames, length);
+        Serial.write(end, sizeof(end));
+        is_dumping_ = false;
+        return;
+    }
+
+    Serial.write(frames, length);
+}
+
+unsigned long TrackLog::GetPageCount()
+{
+    return span_;
+}
+
+unsigned int TrackLog::GetCapacity()
+{
+    // A full ring loses its oldest row at a time, just before the head moves into it
+    return flash_.GetPageCount();
+}
+
+bool TrackLog::IsValid(unsigned int page)
+{
+    const track::Page *stored = (const track::Page *)flash_.GetPage(page);
+    return track::GetCRC(*stored) == stored->crc;
+}
+
+bool TrackLog::IsErased(unsigned int page)
+{
+    const uint8_t *bytes = (const uint8_t *)flash_.GetPage(page);
+    for (unsigned int i = 0; i < hw::flash::kPageSize; i++)
+    {
+        if (bytes[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
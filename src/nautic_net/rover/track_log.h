@@ -0,0 +1,79 @@
+#ifndef TRACK_LOG_H
+#define TRACK_LOG_H
+
+#include "nautic_net/hw/flash.h"
+#include "nautic_net/hw/gps.h"
+#include "nautic_net/hw/imu.h"
+#include "nautic_net/memory_budget.h"
+#include "nautic_net/track_page.h"
+
+namespace nautic_net::rover
+{
+    //
+    // Full-rate track log. The radio carries one RoverData per cycle at best; this keeps heading and heel every
+    // track::kSampleInterval, and the GPS fix every second, for analysing tacks and gybes after the race. Pages
+    // (track_page.h) go into a ring at the top of internal flash, since the EEPROM would only hold a few minutes.
+    //
+    // Every page is written once per pass around the ring, and each row erased just before its first page, so wear
+    // is even and no page is written twice between erases. Both stall the CPU (see hw::flash::Flash), so Loop() only
+    // touches flash when the caller says nothing is due for kMaxStall; finished pages wait in RAM until then.
+    //
+    // trackdump streams the log over USB as binary frames (host_frame.h), oldest page first, between loop()
+    // iterations; tools/track_dump turns it into CSV.
+    //
+    class TrackLog
+    {
+    public:
+        static const unsigned long kMaxStall = 10000;    // µs; a row erase, with margin
+        static const uint32_t kFlashSize = memory::kTrackLogFlashSize; // bytes, at the top of flash; about 34 minutes
+        static const unsigned int kDumpPagesPerLoop = 8;
+
+        TrackLog(nautic_net::hw::gps::GPS *gps, nautic_net::hw::imu::IMU *imu);
+        void Setup();
+        void Loop(bool can_stall);
+
+        bool BeginDump(); // False if there's no log, or a dump is already running
+        bool IsDumping();
+
+        unsigned long GetPageCount(); // Pages in the ring, torn ones included
+        unsigned int GetCapacity();   // Pages
+
+        nautic_net::hw::flash::Flash flash_;
+        unsigned long dropped_page_count_ = 0; // Finished while kQueueCapacity pages were waiting for flash
+        unsigned long dumped_page_count_ = 0;  // By the last dump
+
+    private:
+        static const unsigned int kQueueCapacity = 4;
+
+        nautic_net::hw::gps::GPS *gps_;
+        nautic_net::hw::imu::IMU *imu_;
+
+        track::Page page_; // Being filled
+        unsigned int sample_index_ = 0;
+        unsigned long next_sample_at_ = 0; // ms
+
+        track::Page queue_[kQueueCapacity];
+        unsigned int queued_count_ = 0;
+
+        // The ring holds pages [oldest_, oldest_ + span_), modulo the page count; head_ is the next one to write
+        unsigned int head_ = 0;
+        unsigned int oldest_ = 0;
+        unsigned int span_ = 0;
+        uint16_t sequence_ = 0;      // Of the next page
+        bool is_row_erased_ = false; // The rest of head_'s row
+
+        bool is_dumping_ = false;
+        unsigned int dump_page_ = 0;
+        unsigned int dump_remaining_ = 0;
+
+        void Sample();
+        void Recover();
+        void EraseHeadRow();
+        void WriteQueued();
+        void StepDump();
+        bool IsValid(unsigned int page);
+        bool IsErased(unsigned int page);
+    };
+}
+
+#endif
@@ -9,12 +9,13 @@ TDMA::TDMA()
 {
 }
 
-void TDMA::SyncToGPS(int second)
+void TDMA::SyncToGPS(long second_of_day)
 {
-    if (second != -1 && second % kCycleDurationSec == 0)
+    if (second_of_day != -1 && second_of_day % kCycleDurationSec == 0)
     {
-        debugln("Synced TDMA cycle to GPS");
         synced_at_ = micros();
+        synced_cycle_ = second_of_day / kCycleDurationSec;
+        trace(kSync, synced_cycle_, 0);
     }
 }
 
@@ -39,6 +40,21 @@ SlotType TDMA::GetSlotType(int slot)
     }
 }
 
+Slot TDMA::GetNextSlot(Slot slot)
+{
+    unsigned long slot_started_at = slot.started_at - slot.micro_slot * kMicroSlotDuration;
+
+    if (slot.type == SlotType::kRoverData && slot.micro_slot + 1 < kMicroSlotCount)
+    {
+        return Slot{slot.number, slot.type, slot.cycle, slot.micro_slot + 1, slot_started_at + (slot.micro_slot + 1) * kMicroSlotDuration};
+    }
+
+    int number = (slot.number + 1) % kSlotCount;
+    unsigned long cycle = number == 0 ? (slot.cycle + 1) % kCyclesPerDay : slot.cycle;
+
+    return Slot{number, GetSlotType(number), cycle, 0, slot_started_at + kSlotDuration};
+}
+
 bool TDMA::TryGetSlotTransition(tdma::Slot *slot)
 {
     if (synced_at_ != 0)
@@ -47,14 +63,30 @@ bool TDMA::TryGetSlotTransition(tdma::Slot *slot)
         int slot_num = GetSlotNumber(synced_time);
 
         // Only move forward to the next slot, never backwards to a previous one
-        if (slot_num > current_slot_number_ || (slot_num == 0 && current_slot_number_ == (kSlotCount - 1)))
+        bool is_next_slot = slot_num > current_slot_number_ || (slot_num == 0 && current_slot_number_ == (kSlotCount - 1));
+        if (is_next_slot)
         {
-            SlotType slot_type = GetSlotType(slot_num);
-
             current_slot_number_ = slot_num;
-            current_slot_type_ = slot_type;
+            current_slot_type_ = GetSlotType(slot_num);
+        }
+
+        // Micro-slots move forward within a data slot; if we're late, skip straight to the current one
+        unsigned int micro_slot = 0;
+        if (current_slot_type_ == SlotType::kRoverData && slot_num == current_slot_number_)
+        {
+            micro_slot = (synced_time % kSlotDuration) / kMicroSlotDuration;
+            micro_slot = micro_slot < kMicroSlotCount ? micro_slot : kMicroSlotCount - 1;
+        }
+
+        if (is_next_slot || micro_slot > current_micro_slot_)
+        {
+            current_micro_slot_ = micro_slot;
+
+            unsigned long cycle = (synced_cycle_ + synced_time / kCycleDuration) % kCyclesPerDay;
+
+            unsigned long started_at = synced_at_ + (synced_time - synced_time % kSlotDuration) + micro_slot * kMicroSlotDuration;
 
-            *slot = Slot{slot_num, slot_type};
+            *slot = Slot{slot_num, current_slot_type_, cycle, micro_slot, started_at};
             return true;
         }
     }
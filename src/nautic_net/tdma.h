@@ -4,9 +4,49 @@
 #include <set>
 
 #include "config.h"
+#include "lora_packet.pb.h"
+#include "nautic_net/hw/airtime.h"
+#include "nautic_net/tdma/channel_plan.h"
+#include "nautic_net/tdma/discovery.h"
+#include "nautic_net/tdma/frame_size.h"
+#include "nautic_net/tdma/superframe.h"
 
 namespace nautic_net::tdma
 {
+    // µs; frame_size includes RadioHead's header
+    constexpr unsigned long GetTimeOnAir(hw::radio::Config profile, unsigned int frame_size)
+    {
+        return hw::airtime::GetTimeOnAir(profile.sbw, profile.sf, frame_size, profile.coding_rate, profile.preamble, profile.is_implicit_header);
+    }
+
+    // The profile at another coding rate (denominator)
+    constexpr hw::radio::Config WithCodingRate(hw::radio::Config profile, unsigned int coding_rate)
+    {
+        return {profile.sbw, profile.sf, profile.channel, coding_rate, profile.preamble, profile.is_implicit_header, profile.implicit_length};
+    }
+
+    // The highest coding rate, from the profile's up to 4/8, at which a frame_size frame still takes at most budget µs
+    constexpr unsigned int GetMaxCodingRate(hw::radio::Config profile, unsigned int frame_size, unsigned long budget)
+    {
+        return profile.coding_rate >= 8 || hw::airtime::GetTimeOnAir(profile.sbw, profile.sf, frame_size, profile.coding_rate + 1, profile.preamble, profile.is_implicit_header) > budget
+                   ? profile.coding_rate
+                   : GetMaxCodingRate(WithCodingRate(profile, profile.coding_rate + 1), frame_size, budget);
+    }
+
+    // The largest frame, from frame_size down, that takes at most budget µs
+    constexpr unsigned int GetMaxFrameSize(hw::radio::Config profile, unsigned long budget, unsigned int frame_size = RH_RF95_HEADER_LEN + RH_RF95_MAX_MESSAGE_LEN)
+    {
+        return frame_size == 0 || GetTimeOnAir(profile, frame_size) <= budget ? frame_size : GetMaxFrameSize(profile, budget, frame_size - 1);
+    }
+
+    // How many frames of frame_duration (µs), each followed by guard, fit in a slot; at least 1 and at most max_count
+    constexpr unsigned int GetMicroSlotCount(unsigned long slot_duration, unsigned long frame_duration, unsigned long guard, unsigned int max_count)
+    {
+        return slot_duration / (frame_duration + guard) < 1          ? 1
+               : slot_duration / (frame_duration + guard) > max_count ? max_count
+                                                                      : slot_duration / (frame_duration + guard);
+    }
+
     // See config.h
     static const int kCycleDurationSec = config::kCycleDurationSec;   // sec, must divide evenly into 60
     static const int kSlotCount = config::kSlotCount;                 // Total number of slots available
@@ -15,6 +55,11 @@ namespace nautic_net::tdma
     static const std::set<int> kRoverConfigurationSlots = config::kRoverConfigurationSlots;
     static const unsigned int kMaxRoverCount = config::kMaxRoverCount;
     static const unsigned int kSlotCountPerTransmit = config::kSlotCountPerTransmit;
+    static const ChannelPlan kChannelPlan = config::kChannelPlan;
+    static const unsigned int kChannelCount = config::kChannelCount;
+    static const unsigned int kSuperframeCycleCount = config::kSuperframeCycleCount;
+    static const unsigned long kMicroSlotGuard = config::kMicroSlotGuard;
+    static const unsigned int kMaxMicroSlotCount = config::kMaxMicroSlotCount;
 
     // Derived
     static const int kRoverDataSlotCount = kSlotCount - kReservedSlotCount;                                           // Total number of slots reserved for rover data
@@ -22,6 +67,49 @@ namespace nautic_net::tdma
     static const unsigned long kSlotDuration = kCycleDuration / kSlotCount;                                           // µs
     static const unsigned int kRoverSlotCount = tdma::kRoverDataSlotCount / (kMaxRoverCount * kSlotCountPerTransmit); // The number of TX slots allocated to each rover in one cycle
     static const unsigned int kRoverSlotInterval = tdma::kSlotCount / kRoverSlotCount;                                // The number of slots between subsequent TX for one rover
+    static const unsigned int kSlotSetCount = kRoverSlotInterval / kSlotCountPerTransmit;                              // Candidate rover base slots, including ones that land on reserved slots
+    static const unsigned int kAssignableChannelCount = GetAssignableChannelCount(kChannelPlan, kChannelCount);         // Rovers that can share one slot set
+    static const unsigned int kCyclesPerDay = 86400 / kCycleDurationSec;
+
+    // RoverData.sequence wraps here, so that it always encodes to a single byte
+    static const unsigned int kSequenceModulus = 128;
+
+    // kRoverDataPayloadSize and kRoverDataFrameSize are in tdma/frame_size.h, for host tools
+    static_assert(kChannelCount <= hw::radio::kMaxChannelCount, "Add the extra channels to hw::radio::kFrequencyRegisters");
+    static_assert(sizeof(RoverData) == 32, "RoverData changed; update kRoverDataPayloadSize");
+    static_assert(kRadioHeadHeaderSize == RH_RF95_HEADER_LEN, "RadioHead's header changed; update frame_size.h");
+    static const unsigned int kRoverDiscoveryFrameSize = RH_RF95_HEADER_LEN + 5 + 6 + 2 + RoverDiscovery_size;
+    static const unsigned long kRoverDataAirtime = GetTimeOnAir(config::kLoraRoverDataConfig, kRoverDataFrameSize);          // µs
+    static const unsigned long kRoverDiscoveryAirtime = GetTimeOnAir(config::kLoraDefaultConfig, kRoverDiscoveryFrameSize); // µs
+
+    // Data slots are split into as many micro-slots as RoverData frames at the data rate fit in, each owned by a
+    // different rover. Only when a transmission is one slot long; longer transmissions already span slots.
+    static const unsigned int kMicroSlotCount = kSlotCountPerTransmit == 1 ? GetMicroSlotCount(kSlotDuration, kRoverDataAirtime, kMicroSlotGuard, kMaxMicroSlotCount) : 1;
+    static const unsigned long kMicroSlotDuration = kSlotDuration / kMicroSlotCount; // µs
+
+    // Implicit header data frames are all padded to the largest size (see hw::radio::Config)
+    static const unsigned int kRoverDataImplicitLength = kRoverDataFrameSize - RH_RF95_HEADER_LEN;
+
+    // Weak links get more redundancy, as far as the slack in a micro-slot allows (see Base::SelectCodingRate). Not
+    // with an implicit header, where the base would have to know each frame's coding rate before receiving it.
+    static const unsigned int kMaxRoverDataCodingRate = config::kLoraRoverDataConfig.is_implicit_header
+                                                            ? config::kLoraRoverDataConfig.coding_rate
+                                                            : GetMaxCodingRate(config::kLoraRoverDataConfig, kRoverDataFrameSize, kMicroSlotDuration * kSlotCountPerTransmit - kMicroSlotGuard);
+
+    // The largest frame, RadioHead's header included, that fits in a micro-slot at kLoraRoverDataConfig and each
+    // coding rate from 4/5 to 4/8 (index coding_rate - 5); what a rover can fill with backfill
+    static constexpr unsigned int kMaxMicroSlotFrameSize[] = {
+        GetMaxFrameSize(WithCodingRate(config::kLoraRoverDataConfig, 5), kMicroSlotDuration * kSlotCountPerTransmit - kMicroSlotGuard),
+        GetMaxFrameSize(WithCodingRate(config::kLoraRoverDataConfig, 6), kMicroSlotDuration * kSlotCountPerTransmit - kMicroSlotGuard),
+        GetMaxFrameSize(WithCodingRate(config::kLoraRoverDataConfig, 7), kMicroSlotDuration * kSlotCountPerTransmit - kMicroSlotGuard),
+        GetMaxFrameSize(WithCodingRate(config::kLoraRoverDataConfig, 8), kMicroSlotDuration * kSlotCountPerTransmit - kMicroSlotGuard)};
+
+    static const unsigned int kRosterCapacity = kRoverDataSlotCount / (kRoverSlotCount * kSlotCountPerTransmit) * kMicroSlotCount * kAssignableChannelCount * kSuperframeCycleCount; // Disjoint (channel, slot set, micro-slot, phase) tuples in one superframe, i.e. how many rovers the schedule can carry at the lowest rate
+
+    static_assert(kCyclesPerDay % kSuperframeCycleCount == 0, "Superframes must line up with midnight");
+    static_assert(kSuperframeCycleCount <= kSuperframeGroupBits, "Superframe phases must fit in one slot bitmap group");
+    static_assert(kRoverDataAirtime + kMicroSlotGuard <= kSlotDuration * kSlotCountPerTransmit, "RoverData doesn't fit in kSlotCountPerTransmit slots at kLoraRoverDataConfig");
+    static_assert(kRoverDiscoveryAirtime * kDiscoverySubSlotCount <= kSlotDuration, "Discovery sub-slots don't fit in a slot at kLoraDefaultConfig");
 
     enum class SlotType
     {
@@ -34,16 +122,20 @@ namespace nautic_net::tdma
     {
         int number;
         SlotType type;
+        unsigned long cycle;      // Cycle number of the day (see tdma/superframe.h)
+        unsigned int micro_slot;  // Within a data slot, below kMicroSlotCount; always 0 in reserved slots
+        unsigned long started_at; // micros() at the (micro-)slot boundary, however late the transition is noticed
     };
 
     class TDMA
     {
     public:
         static SlotType GetSlotType(int slot);
+        static Slot GetNextSlot(Slot slot); // The transition after slot, micro-slots included
 
         TDMA();
 
-        void SyncToGPS(int second);
+        void SyncToGPS(long second_of_day);
         bool TryGetSlotTransition(tdma::Slot *slot);
 
         void ClearTxSlots();
@@ -51,7 +143,9 @@ namespace nautic_net::tdma
 
     private:
         unsigned long synced_at_ = 0;
+        unsigned long synced_cycle_ = 0; // Cycle number at synced_at_
         int current_slot_number_ = 0;
+        unsigned int current_micro_slot_ = 0;
         SlotType current_slot_type_ = SlotType::kRoverDiscovery;
 
         int GetSlotNumber(unsigned long synced_time);
@@ -0,0 +1,68 @@
+#ifndef CHANNEL_PLAN_H
+#define CHANNEL_PLAN_H
+
+#include <stdint.h>
+
+//
+// Channel plans for rover data slots. Discovery and configuration always happen on channel 0. tools/channel_sim
+// evaluates the same channel selection as the firmware.
+//
+// A rover's data slots in one cycle are numbered by their transmission index (slot / tdma::kRoverSlotInterval).
+//
+//   kSingle    - Everyone on channel 0, as before.
+//   kStaggered - Every transmission index hops to the next channel, for rovers and base alike. Capacity doesn't
+//                change, but a channel with interference only costs each rover a fraction of its transmissions.
+//   kRotating  - The base assigns each rover a (channel, slot set) pair, so up to kChannelCount rovers share a slot
+//                set. The base's single receiver rotates across the occupied channels of each slot set, one per
+//                transmission. Capacity is multiplied by the channel count; a rover sharing its slot set with N-1
+//                others is heard in 1/N of its slots. A rover alone in its slot set is always heard.
+//
+namespace nautic_net::tdma
+{
+    enum class ChannelPlan
+    {
+        kSingle,
+        kStaggered,
+        kRotating
+    };
+
+    // How many rovers can share one slot set
+    constexpr unsigned int GetAssignableChannelCount(ChannelPlan plan, unsigned int channel_count)
+    {
+        return plan == ChannelPlan::kRotating ? channel_count : 1;
+    }
+
+    // The channel a rover transmits on. assigned_channel is the one from its RoverAssignment.
+    inline unsigned int GetTransmitChannel(ChannelPlan plan, unsigned int channel_count, unsigned int transmission_index, unsigned int assigned_channel)
+    {
+        switch (plan)
+        {
+        case ChannelPlan::kStaggered:
+            return transmission_index % channel_count;
+        case ChannelPlan::kRotating:
+            return assigned_channel;
+        default:
+            return 0;
+        }
+    }
+
+    // The channel the base listens on (kRotating only), given a bitmask of the channels occupied in the slot set
+    inline unsigned int SelectReceiveChannel(uint32_t occupied_channels, unsigned int transmission_index)
+    {
+        unsigned int occupied_count = __builtin_popcount(occupied_channels);
+        if (occupied_count == 0)
+        {
+            return 0;
+        }
+
+        // The (transmission_index % occupied_count)-th set bit
+        for (unsigned int n = transmission_index % occupied_count; n > 0; n--)
+        {
+            occupied_channels &= occupied_channels - 1;
+        }
+
+        return __builtin_ctz(occupied_channels);
+    }
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <stdint.h>
+
+//
+// Slotted-ALOHA rover discovery. tools/discovery_sim runs this exact logic on the host.
+//
+// Every discovery slot is divided into kDiscoverySubSlotCount sub-slots, each long enough for one RoverDiscovery
+// frame (~15ms at 500kHz/SF7; tdma.h checks this against the airtime model) plus guard time. An unconfigured rover skips a random number of discovery slots within
+// its contention window, then transmits in a random sub-slot. If it hasn't been configured by its next attempt, it
+// assumes a collision and doubles its window. The base advertises a window floor in its BaseBeacon, based on how busy
+// discovery is, so that rovers powering on into a crowd start out at a sensible window.
+//
+namespace nautic_net::tdma
+{
+    static const unsigned int kDiscoverySubSlotCount = 6;
+    static const unsigned int kMinContentionWindow = 1;  // Discovery slots
+    static const unsigned int kMaxContentionWindow = 64; // Discovery slots; ~6 cycles between attempts
+
+    class DiscoveryBackoff
+    {
+    public:
+        DiscoveryBackoff();
+        void Reset();
+
+        // Call at every discovery slot while unconfigured. Returns true if the rover should transmit in this slot,
+        // in sub-slot *sub_slot. random_value should be uniformly distributed (e.g. from random()).
+        bool HandleDiscoverySlot(uint32_t random_value, unsigned int *sub_slot);
+        void SetAdvertisedWindow(unsigned int window);
+        unsigned int GetWindow() const;
+
+        unsigned long attempt_count_ = 0;
+        unsigned long failure_count_ = 0;
+
+    private:
+        unsigned int window_;            // Own window, doubled on every failure
+        unsigned int advertised_window_; // Floor advertised by the base
+        unsigned int skip_remaining_;    // Discovery slots to skip before the next attempt
+        bool is_skip_drawn_;             // skip_remaining_ is valid for the current attempt
+        bool is_attempt_pending_;        // Transmitted, and not configured since
+    };
+
+    class ContentionEstimator
+    {
+    public:
+        ContentionEstimator();
+
+        void HandleDiscoverySlot(); // A discovery slot began
+        void HandleDiscovery();     // A RoverDiscovery was received
+        void HandleCollision();     // A corrupted frame was received in a discovery slot
+        void HandleCycleEnd();
+        unsigned int GetWindow() const;
+
+    private:
+        static const unsigned int kBusyIdlePercent = 30;  // e^-1.2; offered load above ~1.2 per sub-slot
+        static const unsigned int kQuietIdlePercent = 60; // e^-0.5; offered load below ~0.5 per sub-slot
+
+        unsigned int window_;
+        unsigned int busy_sub_slots_;       // This cycle
+        unsigned int discovery_slot_count_; // This cycle
+    };
+
+    //
+    // Inline implementations, so host tools don't need to link anything
+    //
+
+    inline DiscoveryBackoff::DiscoveryBackoff()
+    {
+        advertised_window_ = kMinContentionWindow;
+        Reset();
+    }
+
+    inline void DiscoveryBackoff::Reset()
+    {
+        window_ = kMinContentionWindow;
+        skip_remaining_ = 0;
+        is_skip_drawn_ = false;
+        is_attempt_pending_ = false;
+    }
+
+    inline bool DiscoveryBackoff::HandleDiscoverySlot(uint32_t random_value, unsigned int *sub_slot)
+    {
+        if (is_attempt_pending_)
+        {
+            // Still unconfigured since our last attempt; assume it collided
+            is_attempt_pending_ = false;
+            is_skip_drawn_ = false;
+            failure_count_++;
+            window_ = window_ * 2 > kMaxContentionWindow ? kMaxContentionWindow : window_ * 2;
+        }
+
+        if (!is_skip_drawn_)
+        {
+            skip_remaining_ = (random_value / kDiscoverySubSlotCount) % GetWindow();
+            is_skip_drawn_ = true;
+        }
+
+        if (skip_remaining_ > 0)
+        {
+            skip_remaining_--;
+            return false;
+        }
+
+        *sub_slot = random_value % kDiscoverySubSlotCount;
+        is_attempt_pending_ = true;
+        attempt_count_++;
+        return true;
+    }
+
+    inline void DiscoveryBackoff::SetAdvertisedWindow(unsigned int window)
+    {
+        if (window < kMinContentionWindow)
+        {
+            window = kMinContentionWindow;
+        }
+        else if (window > kMaxContentionWindow)
+        {
+            window = kMaxContentionWindow;
+        }
+
+        advertised_window_ = window;
+    }
+
+    inline unsigned int DiscoveryBackoff::GetWindow() const
+    {
+        return window_ > advertised_window_ ? window_ : advertised_window_;
+    }
+
+    inline ContentionEstimator::ContentionEstimator() : window_(kMinContentionWindow), busy_sub_slots_(0), discovery_slot_count_(0)
+    {
+    }
+
+    inline void ContentionEstimator::HandleDiscoverySlot()
+    {
+        discovery_slot_count_++;
+    }
+
+    inline void ContentionEstimator::HandleDiscovery()
+    {
+        busy_sub_slots_++;
+    }
+
+    inline void ContentionEstimator::HandleCollision()
+    {
+        busy_sub_slots_++;
+    }
+
+    inline void ContentionEstimator::HandleCycleEnd()
+    {
+        // Slotted ALOHA does best at about one transmission per sub-slot, where ~37% of the sub-slots stay idle.
+        // Mostly-busy sub-slots mean rovers should back off further; mostly-idle ones mean they can try more often.
+        unsigned int sub_slot_count = discovery_slot_count_ * kDiscoverySubSlotCount;
+        if (sub_slot_count == 0)
+        {
+            return;
+        }
+
+        unsigned int idle_percent = 100 - (busy_sub_slots_ >= sub_slot_count ? 100 : 100 * busy_sub_slots_ / sub_slot_count);
+
+        if (idle_percent < kBusyIdlePercent && window_ < kMaxContentionWindow)
+        {
+            window_ *= 2;
+        }
+        else if (idle_percent > kQuietIdlePercent && window_ > kMinContentionWindow)
+        {
+            window_ /= 2;
+        }
+
+        busy_sub_slots_ = 0;
+        discovery_slot_count_ = 0;
+    }
+
+    inline unsigned int ContentionEstimator::GetWindow() const
+    {
+        return window_;
+    }
+}
+
+#endif
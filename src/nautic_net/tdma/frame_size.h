@@ -0,0 +1,25 @@
+#ifndef FRAME_SIZE_H
+#define FRAME_SIZE_H
+
+//
+// Worst-case sizes of the frames that have to fit a slot. Arduino- and nanopb-free, so host tools
+// (tools/airtime_table) use the same numbers as the firmware; tdma.h checks them against lora_packet.pb.h and
+// RadioHead.
+//
+namespace nautic_net::tdma
+{
+    static const unsigned int kRadioHeadHeaderSize = 4; // RH_RF95_HEADER_LEN
+
+    // RoverData as Rover::GetData encodes it: two fixed32 coordinates, then varints bounded by their ranges (heading,
+    // heel, cog and sog below 16384; battery at most 100; sequence below kSequenceModulus). Tighter than
+    // RoverData_size, which allows any uint32.
+    static const unsigned int kRoverDataPayloadSize = 2 * 5 + 4 * 3 + 2 + 2;
+
+    // Largest frames on air, including RadioHead's header: LoRaPacket's fixed32 hardware_id, a serial number of up to
+    // 5 bytes, the payload's tag and length, and for data, a network address (one byte below 128, two beyond). Most
+    // data frames leave out hardware_id and serial number (see Rover::GetData), but every frame must still fit its
+    // micro-slot.
+    static const unsigned int kRoverDataFrameSize = kRadioHeadHeaderSize + 5 + 6 + 2 + 3 + kRoverDataPayloadSize;
+}
+
+#endif
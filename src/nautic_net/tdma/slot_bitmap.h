@@ -0,0 +1,168 @@
+#ifndef SLOT_BITMAP_H
+#define SLOT_BITMAP_H
+
+#include <stdint.h>
+
+//
+// Free/used bitmap for handing out TDMA slot sets. Finding a free entry scans whole 32-bit words and uses
+// count-trailing-zeros on the first one with a free bit, so allocation costs O(words) instead of probing entries one
+// by one.
+//
+namespace nautic_net::tdma
+{
+    template <unsigned int kBits>
+    class SlotBitmap
+    {
+    public:
+        static const int kNone = -1;
+
+        SlotBitmap();
+        void Clear(); // Everything free
+
+        // Marks and returns the lowest free entry, or kNone if all are used
+        int Allocate();
+        void Reserve(unsigned int index);
+        void Release(unsigned int index);
+
+        // Multi-bit entries: pattern is placed at every offset below shift_count within each group_bits-wide group
+        // (group_bits must divide 32), and the first placement whose bits are all free is marked and returned as the
+        // index of its bit 0.
+        int AllocatePattern(uint32_t pattern, unsigned int group_bits, unsigned int shift_count);
+        void ReservePattern(unsigned int index, uint32_t pattern);
+        void ReleasePattern(unsigned int index, uint32_t pattern);
+        bool IsFree(unsigned int index) const;
+        unsigned int GetFreeCount() const;
+
+    private:
+        static const unsigned int kWordCount = (kBits + 31) / 32;
+
+        uint32_t free_[kWordCount]; // Bit set = free
+    };
+
+    template <unsigned int kBits>
+    SlotBitmap<kBits>::SlotBitmap()
+    {
+        Clear();
+    }
+
+    template <unsigned int kBits>
+    void SlotBitmap<kBits>::Clear()
+    {
+        for (unsigned int i = 0; i < kWordCount; i++)
+        {
+            free_[i] = 0xFFFFFFFF;
+        }
+
+        // Bits past the end are never free
+        if (kBits % 32 != 0)
+        {
+            free_[kWordCount - 1] = (1UL << (kBits % 32)) - 1;
+        }
+    }
+
+    template <unsigned int kBits>
+    int SlotBitmap<kBits>::Allocate()
+    {
+        for (unsigned int i = 0; i < kWordCount; i++)
+        {
+            if (free_[i] != 0)
+            {
+                unsigned int bit = __builtin_ctz(free_[i]);
+                free_[i] &= ~(1UL << bit);
+                return i * 32 + bit;
+            }
+        }
+
+        return kNone;
+    }
+
+    template <unsigned int kBits>
+    void SlotBitmap<kBits>::Reserve(unsigned int index)
+    {
+        if (index < kBits)
+        {
+            free_[index / 32] &= ~(1UL << (index % 32));
+        }
+    }
+
+    template <unsigned int kBits>
+    void SlotBitmap<kBits>::Release(unsigned int index)
+    {
+        if (index < kBits)
+        {
+            free_[index / 32] |= 1UL << (index % 32);
+        }
+    }
+
+    template <unsigned int kBits>
+    int SlotBitmap<kBits>::AllocatePattern(uint32_t pattern, unsigned int group_bits, unsigned int shift_count)
+    {
+        for (unsigned int i = 0; i < kWordCount; i++)
+        {
+            if (free_[i] == 0)
+            {
+                continue;
+            }
+
+            for (unsigned int group = 0; group < 32; group += group_bits)
+            {
+                for (unsigned int shift = 0; shift < shift_count; shift++)
+                {
+                    uint32_t mask = pattern << (group + shift);
+                    if ((free_[i] & mask) == mask)
+                    {
+                        free_[i] &= ~mask;
+                        return i * 32 + group + shift;
+                    }
+                }
+            }
+        }
+
+        return kNone;
+    }
+
+    template <unsigned int kBits>
+    void SlotBitmap<kBits>::ReservePattern(unsigned int index, uint32_t pattern)
+    {
+        for (unsigned int bit = 0; pattern != 0; bit++, pattern >>= 1)
+        {
+            if (pattern & 1)
+            {
+                Reserve(index + bit);
+            }
+        }
+    }
+
+    template <unsigned int kBits>
+    void SlotBitmap<kBits>::ReleasePattern(unsigned int index, uint32_t pattern)
+    {
+        for (unsigned int bit = 0; pattern != 0; bit++, pattern >>= 1)
+        {
+            if (pattern & 1)
+            {
+                Release(index + bit);
+            }
+        }
+    }
+
+    template <unsigned int kBits>
+    bool SlotBitmap<kBits>::IsFree(unsigned int index) const
+    {
+        return index < kBits && (free_[index / 32] & (1UL << (index % 32))) != 0;
+    }
+
+    template <unsigned int kBits>
+    unsigned int SlotBitmap<kBits>::GetFreeCount() const
+    {
+        unsigned int count = 0;
+
+        for (unsigned int i = 0; i < kWordCount; i++)
+        {
+            count += __builtin_popcount(free_[i]);
+        }
+
+        return count;
+    }
+}
+
+#endif
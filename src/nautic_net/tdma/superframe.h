@@ -0,0 +1,51 @@
+#ifndef SUPERFRAME_H
+#define SUPERFRAME_H
+
+#include <stdint.h>
+
+//
+// Superframes: every cycle has a number, derived from GPS time of day (second of day / cycle duration), so rover
+// and base agree on it without exchanging anything. A superframe is a fixed number of cycles. A rover with period P
+// and phase F only transmits in cycles where cycle % P == F, so up to P rovers of that rate class time-share one slot
+// set. Periods must divide the superframe length, which must divide the number of cycles in a day so that phases
+// carry over midnight.
+//
+namespace nautic_net::tdma
+{
+    // Slot set allocations are tracked as one group of bits per slot set, one bit per cycle of the superframe. Groups
+    // are a power of two wide so they never straddle a 32-bit word in the SlotBitmap.
+    static const unsigned int kSuperframeGroupBits = 16;
+
+    // Bits 0, P, 2P, ... below cycle_count
+    inline uint32_t GetPhasePattern(unsigned int period, unsigned int cycle_count)
+    {
+        uint32_t pattern = 0;
+
+        for (unsigned int cycle = 0; cycle < cycle_count; cycle += period)
+        {
+            pattern |= 1UL << cycle;
+        }
+
+        return pattern;
+    }
+
+    // The smallest period >= requested that divides cycle_count, so every phase repeats identically each superframe
+    inline unsigned int GetValidPeriod(unsigned int requested, unsigned int cycle_count)
+    {
+        unsigned int period = requested == 0 ? 1 : requested;
+
+        while (period < cycle_count && cycle_count % period != 0)
+        {
+            period++;
+        }
+
+        return period > cycle_count ? cycle_count : period;
+    }
+
+    inline bool IsActiveCycle(unsigned long cycle, unsigned int period, unsigned int phase)
+    {
+        return period <= 1 || cycle % period == phase;
+    }
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "nautic_net/host_frame.h"
+#include "nautic_net/trace.h"
+
+using namespace nautic_net::trace;
+using namespace nautic_net;
+
+void Trace::Loop()
+{
+    if (!is_dumping_ && !is_streaming_)
+    {
+        return;
+    }
+
+    // Nobody to send it to. A stream picks up where it can when the host is back; what was overwritten meanwhile
+    // counts as lost.
+    if (!Serial.dtr())
+    {
+        is_dumping_ = false;
+        return;
+    }
+
+    uint32_t oldest = GetOldest();
+    if ((int32_t)(next_ - oldest) < 0)
+    {
+        lost_count_ += oldest - next_;
+        next_ = oldest;
+    }
+
+    if (is_dumping_)
+    {
+        if ((int32_t)(dump_end_ - next_) <= 0)
+        {
+            SendEnd();
+            is_dumping_ = false;
+            return;
+        }
+
+        SendEntries(min(dump_end_ - next_, (uint32_t)kEntriesPerFrame));
+        return;
+    }
+
+    // Streaming: a full frame, or whatever there is once in a while
+    uint32_t pending = head_ - next_;
+    if (pending >= kEntriesPerFrame || (pending > 0 && millis() - last_sent_at_ >= kStreamBatchInterval))
+    {
+        SendEntries(min(pending, (uint32_t)kEntriesPerFrame));
+    }
+}
+
+bool Trace::BeginDump()
+{
+    if (is_dumping_)
+    {
+        return false;
+    }
+
+    // Entries recorded meanwhile aren't part of it; a stream resumes with them afterwards
+    is_dumping_ = true;
+    next_ = GetOldest();
+    dump_end_ = head_;
+
+    return true;
+}
+
+bool Trace::IsDumping()
+{
+    return is_dumping_;
+}
+
+void Trace::SetStreaming(bool is_streaming)
+{
+    // Only what's recorded from now on
+    if (is_streaming && !is_streaming_ && !is_dumping_)
+    {
+        next_ = head_;
+    }
+
+    is_streaming_ = is_streaming;
+}
+
+bool Trace::IsStreaming()
+{
+    return is_streaming_;
+}
+
+void Trace::Clear()
+{
+    cleared_at_ = head_;
+    next_ = head_;
+    dump_end_ = head_;
+}
+
+unsigned long Trace::GetCount()
+{
+    return head_ - GetOldest();
+}
+
+unsigned long Trace::GetTotal()
+{
+    return head_;
+}
+
+uint32_t Trace::GetOldest()
+{
+    return head_ - cleared_at_ < kCapacity ? cleared_at_ : head_ - kCapacity;
+}
+
+void Trace::SendEntries(unsigned int count)
+{
+    uint8_t payload[kIndexSize + kEntriesPerFrame * sizeof(Entry)];
+    uint8_t frame[host_frame::GetFrameSize(sizeof(payload))];
+
+    payload[0] = (uint8_t)next_;
+    payload[1] = (uint8_t)(next_ >> 8);
+    payload[2] = (uint8_t)(next_ >> 16);
+    payload[3] = (uint8_t)(next_ >> 24);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        memcpy(payload + kIndexSize + i * sizeof(Entry), &entries_[(next_ + i) % kCapacity], sizeof(Entry));
+    }
+
+    size_t length = host_frame::Encode(host_frame::Type::kTraceEntries, payload, kIndexSize + count * sizeof(Entry),
+                                       frame);
+    Serial.write(frame, length);
+
+    next_ += count;
+    last_sent_at_ = millis();
+}
+
+void Trace::SendEnd()
+{
+    uint8_t payload[8] = {(uint8_t)head_, (uint8_t)(head_ >> 8), (uint8_t)(head_ >> 16), (uint8_t)(head_ >> 24),
+                          (uint8_t)lost_count_, (uint8_t)(lost_count_ >> 8), (uint8_t)(lost_count_ >> 16),
+                          (uint8_t)(lost_count_ >> 24)};
+    uint8_t frame[host_frame::GetFrameSize(sizeof(payload))];
+
+    Serial.write(frame, host_frame::Encode(host_frame::Type::kTraceEnd, payload, sizeof(payload), frame));
+}
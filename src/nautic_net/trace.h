@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+#include "nautic_net/trace_events.h"
+
+//
+// Deferred tracing. trace() (debug.h) stores an event ID, a micros() timestamp and two integer arguments in a RAM
+// ring and returns; nothing is formatted or printed on the spot, so tracing can stay on without moving TX by the
+// milliseconds a debugln() over USB costs. The ring goes to the host as binary frames (host_frame.h), from loop()
+// and only while a host is connected: all of it on demand (trace dump), or continuously (trace stream 1).
+// tools/trace_dump prints them using the names and formats in trace_events.h.
+//
+// The ring keeps the newest kCapacity entries. Entries overwritten before they were sent are counted, and the
+// running index in every frame shows where they were.
+//
+namespace nautic_net::trace
+{
+    class Trace
+    {
+    public:
+        static const unsigned int kCapacity = 128; // Entries; a power of two, so the running index wraps cleanly
+        static const unsigned long kStreamBatchInterval = 200; // ms; fewer, fuller frames while streaming
+
+        // Only from loop(); nothing traces from an interrupt
+        void Record(Event event, int32_t a, int32_t b)
+        {
+            Entry &entry = entries_[head_ % kCapacity];
+            entry.time_us = micros();
+            entry.a = a;
+            entry.b = b;
+            entry.event = (uint16_t)event;
+            head_++;
+        }
+
+        void Loop(); // Sends at most one frame
+
+        bool BeginDump(); // Sends everything in the ring, then a kTraceEnd frame. False if already dumping.
+        bool IsDumping();
+        void SetStreaming(bool is_streaming);
+        bool IsStreaming();
+        void Clear();
+
+        unsigned long GetCount();  // Entries in the ring
+        unsigned long GetTotal();  // Entries recorded since boot
+        unsigned long lost_count_ = 0; // Overwritten before they were sent
+
+    private:
+        Entry entries_[kCapacity];
+        uint32_t head_ = 0;       // Running index of the next entry; it goes in entries_[head_ % kCapacity]
+        uint32_t cleared_at_ = 0; // Running index of the first entry after the last Clear()
+        uint32_t next_ = 0;       // Running index of the next entry to send
+        uint32_t dump_end_ = 0;
+        bool is_dumping_ = false;
+        bool is_streaming_ = false;
+        unsigned long last_sent_at_ = 0;
+
+        uint32_t GetOldest();
+        void SendEntries(unsigned int count);
+        void SendEnd();
+    };
+
+    // Defined in main.cpp; trace() records into it
+    extern Trace kTrace;
+}
+
+#endif
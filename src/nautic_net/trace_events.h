@@ -0,0 +1,74 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <stdint.h>
+
+//
+// The trace events (see trace.h) and how they're stored and sent. The firmware only ever uses the IDs; the names and
+// argument formats are for host tools (tools/trace_dump), which include this header, so the table can't go out of
+// date with the firmware it was built with.
+//
+// Add events at the end: the IDs are positions in this table. Formats take both arguments as longs; payload is a
+// LoRaPacket payload tag (lora_packet.pb.h).
+//
+#define NAUTIC_NET_TRACE_EVENTS(X)                                   \
+    X(kSync, "sync", "cycle=%ld")                                    \
+    X(kSlot, "slot", "slot=%ld cycle=%ld")                           \
+    X(kConfigure, "configure", "sf=%ld channel=%ld")                 \
+    X(kStage, "stage", "length=%ld payload=%ld")                     \
+    X(kTx, "tx", "length=%ld payload=%ld")                           \
+    X(kTxStaged, "tx staged", "length=%ld late_us=%ld")              \
+    X(kTxDone, "tx done", "length=%ld airtime_us=%ld")               \
+    X(kRx, "rx", "length=%ld rssi=%ld")                              \
+    X(kRxMalformed, "rx malformed", "length=%ld")                    \
+    X(kRxPacket, "rx packet", "payload=%ld address=%ld")             \
+    X(kBeacon, "beacon", "cycle=%ld backfill_requests=%ld")          \
+    X(kRoverData, "rover data", "address=%ld sequence=%ld")          \
+    X(kBackfill, "backfill", "address=%ld samples=%ld")              \
+    X(kRoverSlot, "rover slot", "slot=%ld backfill=%ld")
+
+namespace nautic_net::trace
+{
+#define NAUTIC_NET_TRACE_ID(id, name, format) id,
+    enum class Event : uint16_t
+    {
+        NAUTIC_NET_TRACE_EVENTS(NAUTIC_NET_TRACE_ID)
+        kCount // Not an event; the number of events
+    };
+#undef NAUTIC_NET_TRACE_ID
+
+    // One recorded event, as stored and sent (little-endian, like the MCU)
+    typedef struct
+    {
+        uint32_t time_us; // micros()
+        int32_t a;
+        int32_t b;
+        uint16_t event; // Event
+        uint16_t reserved;
+    } Entry;
+
+    static_assert(sizeof(Entry) == 16, "Entry is sent as is");
+
+    // A host_frame::Type::kTraceEntries payload: the running index of the first entry (uint32, counting every entry
+    // recorded since boot, so gaps show), then up to kEntriesPerFrame entries
+    static const unsigned int kEntriesPerFrame = 15;
+    static const unsigned int kIndexSize = 4;
+
+    inline const char *GetName(Event event)
+    {
+#define NAUTIC_NET_TRACE_NAME(id, name, format) name,
+        static const char *const kNames[] = {NAUTIC_NET_TRACE_EVENTS(NAUTIC_NET_TRACE_NAME)};
+#undef NAUTIC_NET_TRACE_NAME
+        return event < Event::kCount ? kNames[(int)event] : "unknown";
+    }
+
+    inline const char *GetFormat(Event event)
+    {
+#define NAUTIC_NET_TRACE_FORMAT(id, name, format) format,
+        static const char *const kFormats[] = {NAUTIC_NET_TRACE_EVENTS(NAUTIC_NET_TRACE_FORMAT)};
+#undef NAUTIC_NET_TRACE_FORMAT
+        return event < Event::kCount ? kFormats[(int)event] : "a=%ld b=%ld";
+    }
+}
+
+#endif
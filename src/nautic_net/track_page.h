@@ -0,0 +1,48 @@
+#ifndef TRACK_PAGE_H
+#define TRACK_PAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nautic_net/crc.h"
+
+//
+// The rover's track log: a second of IMU samples at 10 Hz, plus the GPS fix of that second, per 64-byte page, so one
+// flash page write per second covers it. Dumped over USB as it is stored (see host_frame::Type::kTrackPage).
+// Everything is little-endian.
+//
+namespace nautic_net::track
+{
+    static const unsigned int kSamplesPerPage = 10;
+    static const unsigned long kSampleInterval = 100; // ms
+    static const int32_t kNoFix = -1;
+
+    typedef struct
+    {
+        uint16_t heading; // degrees * 10, from the compass
+        int16_t heel;     // degrees * 10, IMU::heel_angle_deg_
+    } Sample;
+
+    typedef struct
+    {
+        uint16_t sequence;     // Pages written, modulo 65536; tells the oldest page in the ring from the newest
+        uint16_t crc;          // CRC16 (crc.h) of the page with crc = 0; erased and torn pages fail it
+        uint32_t time;         // Rover's millis() at the first sample; the rest follow every kSampleInterval
+        int32_t second_of_day; // UTC, of the latest fix at the first sample; kNoFix without one
+        int32_t latitude;      // degrees * 1e7
+        int32_t longitude;     // degrees * 1e7
+        uint16_t sog;          // knots * 10
+        uint16_t cog;          // degrees * 10
+        Sample samples[kSamplesPerPage];
+    } Page;
+
+    static_assert(sizeof(Page) == 64, "A track page is one SAMD21 flash page");
+
+    inline uint16_t GetCRC(Page page)
+    {
+        page.crc = 0;
+        return crc::CRC16(&page, sizeof(page));
+    }
+}
+
+#endif
@@ -0,0 +1,82 @@
+//
+// LoRa time on air (hw/airtime.h), against the SX1276 datasheet's formula worked by hand
+//
+#include <unity.h>
+
+#include "nautic_net/hw/airtime.h"
+
+using namespace nautic_net::hw::airtime;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_symbol_duration()
+{
+    TEST_ASSERT_EQUAL_UINT32(1024, GetSymbolDuration(125, 7));
+    TEST_ASSERT_EQUAL_UINT32(1024, GetSymbolDuration(500, 9));
+    TEST_ASSERT_EQUAL_UINT32(32768, GetSymbolDuration(125, 12));
+}
+
+static void test_low_data_rate_optimization()
+{
+    TEST_ASSERT_FALSE(IsLowDataRateOptimized(125, 10));
+    TEST_ASSERT_TRUE(IsLowDataRateOptimized(125, 11));
+    TEST_ASSERT_FALSE(IsLowDataRateOptimized(500, 12));
+}
+
+static void test_payload_symbols()
+{
+    // 8 + ceil((80 - 28 + 28 + 16) / 28) * 5
+    TEST_ASSERT_EQUAL_UINT(28, GetPayloadSymbolCount(125, 7, 10));
+    TEST_ASSERT_EQUAL_UINT(32, GetPayloadSymbolCount(125, 7, 10, 6));
+
+    // Nothing beyond the header fits in its 8 symbols
+    TEST_ASSERT_EQUAL_UINT(8, GetPayloadSymbolCount(125, 12, 0));
+
+    // An implicit header saves 20 bits
+    TEST_ASSERT_EQUAL_UINT(23, GetPayloadSymbolCount(125, 7, 10, 5, true));
+}
+
+static void test_time_on_air()
+{
+    // 12.25 preamble symbols and 28 payload symbols of 1.024 ms
+    TEST_ASSERT_EQUAL_UINT32(41216, GetTimeOnAir(125, 7, 10));
+
+    // 6-symbol preamble, as for rover data
+    TEST_ASSERT_EQUAL_UINT32((6 * 4 + 17) * 1024 / 4 + 28 * 1024, GetTimeOnAir(125, 7, 10, 5, 6));
+
+    // Longer frames never take less time
+    for (unsigned int length = 1; length < 255; length++)
+    {
+        TEST_ASSERT_TRUE(GetTimeOnAir(500, 9, length + 1) >= GetTimeOnAir(500, 9, length));
+    }
+}
+
+static void test_constexpr()
+{
+    static_assert(GetTimeOnAir(125, 7, 10) == 41216, "GetTimeOnAir() must stay usable at compile time");
+    TEST_PASS();
+}
+
+static void test_sensitivity()
+{
+    TEST_ASSERT_EQUAL_INT(-124, GetSensitivity(125, 7));
+    TEST_ASSERT_EQUAL_INT(-123, GetSensitivity(500, 9));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_symbol_duration);
+    RUN_TEST(test_low_data_rate_optimization);
+    RUN_TEST(test_payload_symbols);
+    RUN_TEST(test_time_on_air);
+    RUN_TEST(test_constexpr);
+    RUN_TEST(test_sensitivity);
+    return UNITY_END();
+}
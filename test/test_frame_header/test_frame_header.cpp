@@ -0,0 +1,104 @@
+//
+// Peeking at a LoRaPacket's addressing fields (frame_header.h) in hand-encoded frames
+//
+#include <unity.h>
+
+#include "nautic_net/frame_header.h"
+
+using namespace nautic_net::frame;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_reads_addressing_fields()
+{
+    const uint8_t frame[] = {
+        0x0D, 0x78, 0x56, 0x34, 0x12, // hardware_id (fixed32): 0x12345678
+        0x48, 0xAC, 0x02,             // address (varint): 300
+        0x1A, 0x02, 0x08, 0x01,       // Payload, tag 3, two bytes
+    };
+    Header header;
+
+    TEST_ASSERT_TRUE(TryPeekHeader(frame, sizeof(frame), &header));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, header.hardware_id);
+    TEST_ASSERT_EQUAL_UINT32(300, header.address);
+    TEST_ASSERT_EQUAL_UINT32(3, header.payload_tag);
+}
+
+static void test_zero_padding_ends_frame()
+{
+    const uint8_t frame[] = {0x48, 0x05, 0x00, 0x00, 0x00, 0x00};
+    Header header;
+
+    TEST_ASSERT_TRUE(TryPeekHeader(frame, sizeof(frame), &header));
+    TEST_ASSERT_EQUAL_UINT32(5, header.address);
+    TEST_ASSERT_EQUAL_UINT32(0, header.hardware_id);
+    TEST_ASSERT_EQUAL_UINT32(0, header.payload_tag);
+}
+
+static void test_last_field_wins()
+{
+    const uint8_t frame[] = {0x48, 0x01, 0x48, 0x02};
+    Header header;
+
+    TEST_ASSERT_TRUE(TryPeekHeader(frame, sizeof(frame), &header));
+    TEST_ASSERT_EQUAL_UINT32(2, header.address);
+}
+
+static void test_skips_unknown_fields()
+{
+    const uint8_t frame[] = {
+        0x11, 1, 2, 3, 4, 5, 6, 7, 8, // Tag 2, fixed64
+        0x20, 0x7F,                   // Tag 4, varint
+        0x48, 0x09,                   // address
+    };
+    Header header;
+
+    TEST_ASSERT_TRUE(TryPeekHeader(frame, sizeof(frame), &header));
+    TEST_ASSERT_EQUAL_UINT32(9, header.address);
+}
+
+static void test_rejects_malformed()
+{
+    Header header;
+
+    const uint8_t truncated_fixed32[] = {0x0D, 0x78, 0x56};
+    TEST_ASSERT_FALSE(TryPeekHeader(truncated_fixed32, sizeof(truncated_fixed32), &header));
+
+    const uint8_t truncated_varint[] = {0x48, 0x80};
+    TEST_ASSERT_FALSE(TryPeekHeader(truncated_varint, sizeof(truncated_varint), &header));
+
+    const uint8_t overlong_payload[] = {0x1A, 0x05, 0x08, 0x01};
+    TEST_ASSERT_FALSE(TryPeekHeader(overlong_payload, sizeof(overlong_payload), &header));
+
+    const uint8_t group_wire_type[] = {0x0B};
+    TEST_ASSERT_FALSE(TryPeekHeader(group_wire_type, sizeof(group_wire_type), &header));
+
+    const uint8_t varint_too_long[] = {0x48, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+    TEST_ASSERT_FALSE(TryPeekHeader(varint_too_long, sizeof(varint_too_long), &header));
+}
+
+static void test_empty_frame()
+{
+    Header header;
+
+    TEST_ASSERT_TRUE(TryPeekHeader(nullptr, 0, &header));
+    TEST_ASSERT_EQUAL_UINT32(0, header.payload_tag);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_reads_addressing_fields);
+    RUN_TEST(test_zero_padding_ends_frame);
+    RUN_TEST(test_last_field_wins);
+    RUN_TEST(test_skips_unknown_fields);
+    RUN_TEST(test_rejects_malformed);
+    RUN_TEST(test_empty_frame);
+    return UNITY_END();
+}
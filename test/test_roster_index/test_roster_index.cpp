@@ -0,0 +1,45 @@
+//
+// The roster's hash index (RosterTable): inserting, finding and filling up
+//
+#include <unity.h>
+
+#include "nautic_net/base/roster_table.h"
+
+using namespace nautic_net::base;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_roster_insert_and_find()
+{
+    RosterTable<4> roster;
+
+    TEST_ASSERT_EQUAL_UINT(0, roster.Insert(0x1234));
+    TEST_ASSERT_EQUAL_UINT(1, roster.Insert(0xABCD));
+    TEST_ASSERT_EQUAL_UINT(0, roster.Insert(0x1234));
+    TEST_ASSERT_EQUAL_UINT(1, roster.Find(0xABCD));
+    TEST_ASSERT_EQUAL_UINT(RosterTable<4>::kNotFound, roster.Find(0x5555));
+    TEST_ASSERT_EQUAL_UINT(RosterTable<4>::kNotFound, roster.Insert(0)); // Broadcast
+    TEST_ASSERT_EQUAL_UINT(2, roster.Count());
+
+    roster.Insert(3);
+    roster.Insert(4);
+    TEST_ASSERT_TRUE(roster.IsFull());
+    TEST_ASSERT_EQUAL_UINT(RosterTable<4>::kNotFound, roster.Insert(5));
+
+    roster.Clear();
+    TEST_ASSERT_EQUAL_UINT(0, roster.Count());
+    TEST_ASSERT_EQUAL_UINT(RosterTable<4>::kNotFound, roster.Find(0x1234));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_roster_insert_and_find);
+    return UNITY_END();
+}
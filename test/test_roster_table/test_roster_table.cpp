@@ -0,0 +1,158 @@
+//
+// Link bookkeeping (RecordLinkFrame, RecordBackfillFrame, TryGetMissingFrames), at the firmware's sequence modulus
+//
+#include <unity.h>
+
+#include "nautic_net/base/roster_table.h"
+
+using namespace nautic_net::base;
+
+static const unsigned int kModulus = 128; // tdma::kSequenceModulus
+
+static LinkStats link;
+
+void setUp()
+{
+    link = {};
+}
+
+void tearDown()
+{
+}
+
+static void Record(unsigned int sequence, int rssi = -80)
+{
+    RecordLinkFrame<kModulus>(&link, sequence, rssi, 5, 0);
+}
+
+static void test_first_frame_owes_nothing()
+{
+    unsigned int first;
+    uint32_t missing;
+
+    Record(40);
+
+    TEST_ASSERT_TRUE(link.is_started);
+    TEST_ASSERT_EQUAL_UINT(1, link.received);
+    TEST_ASSERT_EQUAL_UINT(0, link.missed);
+    TEST_ASSERT_FALSE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+}
+
+static void test_gap_marks_skipped_frames_missing()
+{
+    unsigned int first;
+    uint32_t missing;
+
+    Record(5);
+    Record(8);
+
+    TEST_ASSERT_EQUAL_UINT(2, link.missed);
+    TEST_ASSERT_TRUE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+    TEST_ASSERT_EQUAL_UINT(6, first);
+    TEST_ASSERT_EQUAL_HEX32(0x3, missing);
+}
+
+static void test_gap_across_sequence_wrap()
+{
+    unsigned int first;
+    uint32_t missing;
+
+    Record(126);
+    Record(2);
+
+    TEST_ASSERT_EQUAL_UINT(3, link.missed);
+    TEST_ASSERT_TRUE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+    TEST_ASSERT_EQUAL_UINT(127, first);
+    TEST_ASSERT_EQUAL_HEX32(0x7, missing);
+}
+
+static void test_duplicate_counts_once()
+{
+    Record(10);
+    Record(10);
+
+    TEST_ASSERT_EQUAL_UINT(1, link.duplicates);
+    TEST_ASSERT_EQUAL_UINT(0, link.missed);
+    TEST_ASSERT_EQUAL_UINT(2, link.received);
+}
+
+static void test_missing_frames_beyond_one_request()
+{
+    unsigned int first;
+    uint32_t missing;
+
+    Record(0);
+    Record(50);
+
+    TEST_ASSERT_EQUAL_UINT(49, link.missed);
+    TEST_ASSERT_TRUE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+    TEST_ASSERT_EQUAL_UINT(1, first);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, missing);
+}
+
+static void test_backfill_fills_gap_once()
+{
+    unsigned int first;
+    uint32_t missing;
+
+    Record(5);
+    Record(8);
+    link.backfill_requests = 3;
+
+    TEST_ASSERT_TRUE(RecordBackfillFrame<kModulus>(&link, 6));
+    TEST_ASSERT_EQUAL_UINT(0, link.backfill_requests);
+    TEST_ASSERT_FALSE(RecordBackfillFrame<kModulus>(&link, 6));
+
+    TEST_ASSERT_TRUE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+    TEST_ASSERT_EQUAL_UINT(7, first);
+    TEST_ASSERT_EQUAL_HEX32(0x1, missing);
+
+    TEST_ASSERT_TRUE(RecordBackfillFrame<kModulus>(&link, 7 + kModulus)); // Taken modulo kModulus
+    TEST_ASSERT_FALSE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+}
+
+static void test_backfill_rejects_latest_and_unstarted()
+{
+    TEST_ASSERT_FALSE(RecordBackfillFrame<kModulus>(&link, 3));
+
+    Record(3);
+    TEST_ASSERT_FALSE(RecordBackfillFrame<kModulus>(&link, 3));
+}
+
+static void test_forget_missing_frames()
+{
+    unsigned int first;
+    uint32_t missing;
+
+    Record(5);
+    Record(20);
+    ForgetMissingFrames(&link);
+
+    TEST_ASSERT_FALSE(TryGetMissingFrames<kModulus>(link, &first, &missing));
+}
+
+static void test_rssi_is_clamped_and_tracked()
+{
+    Record(1, -140);
+    TEST_ASSERT_EQUAL_INT(-128, link.rssi);
+
+    Record(2, -60);
+    TEST_ASSERT_EQUAL_INT(-128, link.rssi_min);
+    TEST_ASSERT_EQUAL_INT(-60, link.rssi_max);
+    TEST_ASSERT_EQUAL_INT(-111, link.rssi); // (3 * -128 + -60) / 4
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_owes_nothing);
+    RUN_TEST(test_gap_marks_skipped_frames_missing);
+    RUN_TEST(test_gap_across_sequence_wrap);
+    RUN_TEST(test_duplicate_counts_once);
+    RUN_TEST(test_missing_frames_beyond_one_request);
+    RUN_TEST(test_backfill_fills_gap_once);
+    RUN_TEST(test_backfill_rejects_latest_and_unstarted);
+    RUN_TEST(test_forget_missing_frames);
+    RUN_TEST(test_rssi_is_clamped_and_tracked);
+    return UNITY_END();
+}
@@ -0,0 +1,59 @@
+//
+// Rate classes within a superframe (tdma/superframe.h)
+//
+#include <unity.h>
+
+#include "nautic_net/tdma/superframe.h"
+
+using namespace nautic_net::tdma;
+
+static const unsigned int kCycles = 12; // tdma::kSuperframeCycleCount
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_phase_pattern()
+{
+    TEST_ASSERT_EQUAL_HEX32(0xFFF, GetPhasePattern(1, kCycles));
+    TEST_ASSERT_EQUAL_HEX32(0x249, GetPhasePattern(3, kCycles)); // Cycles 0, 3, 6 and 9
+    TEST_ASSERT_EQUAL_HEX32(0x1, GetPhasePattern(kCycles, kCycles));
+}
+
+static void test_pattern_fits_group()
+{
+    TEST_ASSERT_TRUE(GetPhasePattern(1, kCycles) < (1UL << kSuperframeGroupBits));
+}
+
+static void test_valid_period_divides_superframe()
+{
+    TEST_ASSERT_EQUAL_UINT(1, GetValidPeriod(0, kCycles));
+    TEST_ASSERT_EQUAL_UINT(4, GetValidPeriod(4, kCycles));
+    TEST_ASSERT_EQUAL_UINT(6, GetValidPeriod(5, kCycles));
+    TEST_ASSERT_EQUAL_UINT(12, GetValidPeriod(7, kCycles));
+    TEST_ASSERT_EQUAL_UINT(12, GetValidPeriod(100, kCycles));
+}
+
+static void test_active_cycle()
+{
+    TEST_ASSERT_TRUE(IsActiveCycle(7, 1, 0));
+    TEST_ASSERT_TRUE(IsActiveCycle(7, 3, 1));
+    TEST_ASSERT_FALSE(IsActiveCycle(7, 3, 2));
+
+    // Phases carry over from one superframe to the next
+    TEST_ASSERT_TRUE(IsActiveCycle(kCycles + 1, 3, 1));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_phase_pattern);
+    RUN_TEST(test_pattern_fits_group);
+    RUN_TEST(test_valid_period_divides_superframe);
+    RUN_TEST(test_active_cycle);
+    return UNITY_END();
+}
@@ -0,0 +1,102 @@
+//
+// Host-side table of LoRa PHY profiles, using the same airtime model as the firmware (src/nautic_net/hw/airtime.h).
+//
+// For every bandwidth and spreading factor, prints the time on air of a RoverData frame under each profile, the
+// saving against the standard RadioHead profile, and how many micro-slots that leaves in one TDMA slot. Frames are
+// timed at two sizes: an address-only frame (what a configured rover sends most cycles) and the worst case
+// (identity fields included, tdma::kRoverDataFrameSize). An implicit header has to be padded to the worst case, so
+// it only pays off where the header symbols it saves outweigh the padding.
+//
+// Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -Isrc tools/airtime_table/airtime_table.cpp -o airtime_table && ./airtime_table
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "nautic_net/hw/airtime.h"
+#include "nautic_net/tdma/frame_size.h"
+
+using namespace nautic_net::hw::airtime;
+
+static const unsigned int kAddressOnlyFrameSize = 32; // Bytes handed to the modem, RadioHead's header included
+static const unsigned int kWorstFrameSize = nautic_net::tdma::kRoverDataFrameSize;
+static const unsigned long kSlotDuration = 100000;    // µs; config::kSlotDuration
+static const unsigned long kMicroSlotGuard = 1000;    // µs; config::kMicroSlotGuard
+static const unsigned int kMaxMicroSlotCount = 4;     // config::kMaxMicroSlotCount
+
+struct Profile
+{
+    const char *name;
+    unsigned int coding_rate;
+    unsigned int preamble;
+    bool is_implicit_header;
+};
+
+static const Profile kProfiles[] = {
+    {"standard", 5, kDefaultPreambleSymbolCount, false},
+    {"preamble 6", 5, kMinPreambleSymbolCount, false},
+    {"implicit", 5, kMinPreambleSymbolCount, true},
+    {"CR 4/6", 6, kMinPreambleSymbolCount, false},
+    {"CR 4/8", 8, kMinPreambleSymbolCount, false},
+};
+
+// µs. An implicit header frame is always padded to the worst case.
+static unsigned long GetFrameTime(const Profile &profile, unsigned int sbw, unsigned int sf, unsigned int frame_size)
+{
+    return GetTimeOnAir(sbw, sf, profile.is_implicit_header ? kWorstFrameSize : frame_size, profile.coding_rate,
+                        profile.preamble, profile.is_implicit_header);
+}
+
+static unsigned int GetMicroSlotCount(unsigned long airtime)
+{
+    unsigned long count = kSlotDuration / (airtime + kMicroSlotGuard);
+    return count > kMaxMicroSlotCount ? kMaxMicroSlotCount : count;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int only_sbw = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sbw") == 0 && i + 1 < argc)
+        {
+            only_sbw = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--sbw 125|250|500]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-4s %-3s %-11s %10s %10s %10s %12s\n", "sbw", "sf", "profile", "addr ms", "worst ms", "saving %", "micro-slots");
+
+    for (unsigned int sbw : {125u, 250u, 500u})
+    {
+        if (only_sbw != 0 && sbw != only_sbw)
+        {
+            continue;
+        }
+
+        for (unsigned int sf = 7; sf <= 12; sf++)
+        {
+            unsigned long standard = GetFrameTime(kProfiles[0], sbw, sf, kAddressOnlyFrameSize);
+
+            for (const Profile &profile : kProfiles)
+            {
+                unsigned long address_only = GetFrameTime(profile, sbw, sf, kAddressOnlyFrameSize);
+                unsigned long worst = GetFrameTime(profile, sbw, sf, kWorstFrameSize);
+
+                // Saving on the typical (address-only) frame; micro-slots are sized for the worst case
+                printf("%-4u %-3u %-11s %10.1f %10.1f %10.1f %12u\n", sbw, sf, profile.name, address_only / 1000.0,
+                       worst / 1000.0, 100.0 * ((double)standard - address_only) / standard, GetMicroSlotCount(worst));
+            }
+        }
+    }
+
+    return 0;
+}
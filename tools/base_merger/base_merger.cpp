@@ -0,0 +1,257 @@
+//
+// Merges the serial output of several base stations covering one course into a single stream (see merger.h).
+//
+// Each input (a serial port, already set up with stty, or a pipe) gets its own reader thread, which decodes it with
+// tools/serial_decoder and hands records to the merging thread through a lock-free queue, stamped with the time they
+// were read. The merged stream goes to stdout in the base's own BOAT and LINK line format, with extra fields:
+// base (the base that heard the kept copy best), bases (bit per base that heard it), copies, and ms (first receipt,
+// since start). Lines the base logged or the rover backfilled keep their cycle, slot and flag, since ms says nothing
+// about when those were heard. Inputs are numbered from 0 in command-line order. Statistics go to stderr when every
+// input has ended.
+//
+// Build from the repository root, with nanopb from PlatformIO's library directory:
+//
+//   NANOPB=.pio/libdeps/adafruit_feather_m0/Nanopb
+//   g++ -std=c++17 -O2 -pthread -Isrc -I$NANOPB tools/base_merger/base_merger.cpp src/lora_packet.pb.c $NANOPB/pb_decode.c $NANOPB/pb_common.c -o base_merger
+//
+//   ./base_merger [--latency ms] [--memory ms] /dev/ttyACM0 /dev/ttyACM1 ...
+//
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "merger.h"
+#include "spsc_queue.h"
+
+using namespace nautic_net;
+using namespace nautic_net::base_merger;
+
+static const unsigned int kDefaultLatency = 300; // ms; bases' serial output lags the air by a few ms, USB adds more
+static const unsigned int kDefaultMemory = 3000; // ms; well under 128 TX intervals at the fastest rate class
+static const size_t kReadSize = 4096;
+static const size_t kQueueCapacity = 4096;
+
+typedef SPSCQueue<Arrival, kQueueCapacity> ArrivalQueue;
+
+struct Input
+{
+    const char *path;
+    ArrivalQueue queue;
+    std::atomic<bool> is_done{false};
+};
+
+// Runs on the reader thread: queues every BOAT and LINK record, waiting for room rather than dropping any
+class QueueingHandler : public serial_decoder::RecordHandler
+{
+public:
+    QueueingHandler(Input *input, unsigned int base) : input_(input), base_(base)
+    {
+    }
+
+    void SetReceivedAt(Clock::time_point received_at)
+    {
+        received_at_ = received_at;
+    }
+
+    void OnBoat(const serial_decoder::BoatRecord &record) override
+    {
+        Arrival arrival = {};
+        arrival.kind = Arrival::Kind::kBoat;
+        arrival.boat = record;
+        Push(&arrival);
+    }
+
+    void OnLink(const serial_decoder::LinkRecord &record) override
+    {
+        Arrival arrival = {};
+        arrival.kind = Arrival::Kind::kLink;
+        arrival.link = record;
+        Push(&arrival);
+    }
+
+private:
+    Input *input_;
+    unsigned int base_;
+    Clock::time_point received_at_;
+
+    void Push(Arrival *arrival)
+    {
+        arrival->base = base_;
+        arrival->received_at = received_at_;
+
+        while (!input_->queue.TryPush(*arrival))
+        {
+            std::this_thread::yield();
+        }
+    }
+};
+
+static void Read(Input *input, unsigned int base)
+{
+    int fd = open(input->path, O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", input->path, strerror(errno));
+        input->is_done = true;
+        return;
+    }
+
+    // LORA frames aren't needed; BOAT lines carry the decoded fields with the hardware ID resolved
+    QueueingHandler handler(input, base);
+    serial_decoder::SerialDecoder decoder(&handler, false);
+    uint8_t buffer[kReadSize];
+
+    for (;;)
+    {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (length <= 0)
+        {
+            break;
+        }
+
+        handler.SetReceivedAt(Clock::now());
+        decoder.Feed(buffer, length);
+    }
+
+    close(fd);
+    input->is_done = true;
+}
+
+static void Print(const MergedRecord &record, Clock::time_point started_at)
+{
+    const Arrival &best = record.best;
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(best.received_at - started_at).count();
+
+    if (best.kind == Arrival::Kind::kLink)
+    {
+        const serial_decoder::LinkRecord &link = best.link;
+        printf("LINK hwid:%X rx:%u missed:%u dup:%u slotmiss:%u rssi:%d rssimin:%d rssimax:%d snr:%d cycle:%u base:%u ms:%lld\n",
+               link.hardware_id, link.received, link.missed, link.duplicates, link.slot_misses, link.rssi, link.rssi_min,
+               link.rssi_max, link.snr, link.last_heard_cycle, best.base, ms);
+        return;
+    }
+
+    const serial_decoder::BoatRecord &boat = best.boat;
+    printf("BOAT rssi:%d hwid:%X lat:%.8f lon:%.8f heading:%u heel:%u sog:%u cog:%u bat:%u", boat.rssi, boat.hardware_id,
+           boat.latitude, boat.longitude, boat.heading, boat.heel, boat.sog, boat.cog, boat.battery);
+    if (boat.sequence != serial_decoder::kNoSequence)
+    {
+        printf(" seq:%u", boat.sequence);
+    }
+    printf(" serial:%u base:%u bases:%X copies:%u ms:%lld", boat.serial_number, best.base, record.bases, record.copies, ms);
+    if (boat.cycle != serial_decoder::kNoCycle)
+    {
+        printf(" cycle:%u slot:%u", boat.cycle, boat.slot);
+    }
+    printf("%s%s\n", boat.logged ? " logged:1" : "", boat.backfill ? " backfill:1" : "");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int latency = kDefaultLatency;
+    unsigned int memory = kDefaultMemory;
+    std::vector<std::unique_ptr<Input>> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+        {
+            latency = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc)
+        {
+            memory = atoi(argv[++i]);
+        }
+        else if (argv[i][0] != '-')
+        {
+            inputs.emplace_back(new Input());
+            inputs.back()->path = argv[i];
+        }
+        else
+        {
+            inputs.clear();
+            break;
+        }
+    }
+
+    if (inputs.empty() || inputs.size() > kMaxBases || memory < latency)
+    {
+        fprintf(stderr, "usage: %s [--latency ms] [--memory ms] input...   (at most %u inputs; memory >= latency)\n",
+                argv[0], kMaxBases);
+        return 1;
+    }
+
+    Clock::time_point started_at = Clock::now();
+    std::vector<std::thread> readers;
+    for (unsigned int i = 0; i < inputs.size(); i++)
+    {
+        readers.emplace_back(Read, inputs[i].get(), i);
+    }
+
+    Merger merger{std::chrono::milliseconds(latency), std::chrono::milliseconds(memory)};
+    auto print = [started_at](const MergedRecord &record) { Print(record, started_at); };
+
+    for (;;)
+    {
+        // Check before draining, so nothing queued just before an input ends is left behind
+        bool is_done = true;
+        for (const auto &input : inputs)
+        {
+            is_done &= input->is_done.load();
+        }
+
+        bool is_idle = true;
+        Arrival arrival;
+        for (const auto &input : inputs)
+        {
+            while (input->queue.TryPop(&arrival))
+            {
+                merger.Offer(arrival);
+                is_idle = false;
+            }
+        }
+
+        if (is_done)
+        {
+            break;
+        }
+
+        unsigned long emitted = merger.GetStats().emitted;
+        merger.Poll(Clock::now(), print);
+        if (merger.GetStats().emitted != emitted)
+        {
+            fflush(stdout);
+        }
+
+        if (is_idle)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    merger.Flush(print);
+    fflush(stdout);
+
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+
+    const MergerStats &stats = merger.GetStats();
+    fprintf(stderr, "%lu records in, %lu out: %lu duplicates (%lu after their record was emitted), %lu out of order\n",
+            stats.arrivals, stats.emitted, stats.duplicates, stats.late_duplicates, stats.late);
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+#ifndef MERGER_H
+#define MERGER_H
+
+//
+// Merges records from several base stations into one stream. A RoverData frame heard by more than one base arrives
+// as a BOAT line from each; the copies are recognised by hardware ID and RoverData.sequence and folded into one
+// record, keeping the copy with the best RSSI. Records are held for a fixed reorder latency after their first copy
+// arrives, so that slower bases can catch up, and come out in order of first arrival: the bases' TDMA clocks aren't
+// synchronized with each other, so the host's receive time is the shared timeline.
+//
+// Sequence numbers wrap every 128 frames, so a frame is remembered (to drop stragglers) for much less than 128 TX
+// intervals. From firmware that doesn't print sequence numbers, copies are matched by hardware ID alone: each base
+// hears a frame once, so a copy from a base that hasn't yet contributed to a recent record is taken to be the same
+// frame.
+//
+// Single-threaded; base_merger.cpp feeds it from one reader thread per base.
+//
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+#include "../serial_decoder/serial_decoder.h"
+
+namespace nautic_net::base_merger
+{
+    typedef std::chrono::steady_clock Clock;
+
+    static const unsigned int kMaxBases = 32;
+
+    // One record from one base
+    struct Arrival
+    {
+        enum class Kind : uint8_t
+        {
+            kBoat,
+            kLink, // Per-base link statistics; never de-duplicated
+        };
+
+        Kind kind;
+        unsigned int base; // Index of the stream it came from
+        Clock::time_point received_at;
+        serial_decoder::BoatRecord boat;
+        serial_decoder::LinkRecord link;
+    };
+
+    struct MergedRecord
+    {
+        Arrival best;   // The copy with the best RSSI, but received_at is the first copy's
+        uint32_t bases; // Bit per base that heard it
+        unsigned int copies;
+        bool is_late; // Arrived after records stamped later than it had been emitted
+    };
+
+    struct MergerStats
+    {
+        unsigned long arrivals = 0;
+        unsigned long emitted = 0;
+        unsigned long duplicates = 0;      // Copies folded into an earlier one
+        unsigned long late_duplicates = 0; // Of those, copies that turned up after the record was emitted
+        unsigned long late = 0;            // Records emitted out of order
+    };
+
+    class Merger
+    {
+    public:
+        // reorder_latency: how long a record waits for copies from other bases. duplicate_memory: how long stragglers
+        // are still recognised, at least reorder_latency.
+        Merger(Clock::duration reorder_latency, Clock::duration duplicate_memory)
+            : reorder_latency_(reorder_latency), duplicate_memory_(duplicate_memory), next_emit_(entries_.end())
+        {
+        }
+
+        void Offer(const Arrival &arrival)
+        {
+            stats_.arrivals++;
+
+            if (arrival.kind == Arrival::Kind::kBoat && TryMerge(arrival))
+            {
+                stats_.duplicates++;
+                return;
+            }
+
+            // Insert in time order, but never among records already emitted
+            auto position = entries_.end();
+            while (position != next_emit_ && std::prev(position)->record.best.received_at > arrival.received_at)
+            {
+                position--;
+            }
+
+            auto entry = entries_.insert(position, {{arrival, 1u << arrival.base, 1, arrival.received_at < last_emitted_at_}, false});
+            if (position == next_emit_)
+            {
+                next_emit_ = entry;
+            }
+
+            if (arrival.kind == Arrival::Kind::kBoat)
+            {
+                by_rover_.emplace(arrival.boat.hardware_id, entry);
+            }
+        }
+
+        // Emits every record whose reorder latency has passed, in order, and forgets the ones past duplicate_memory
+        template <typename Emitter>
+        void Poll(Clock::time_point now, Emitter emit)
+        {
+            while (next_emit_ != entries_.end() && next_emit_->record.best.received_at + reorder_latency_ <= now)
+            {
+                EmitNext(emit);
+            }
+
+            while (entries_.begin() != next_emit_ && entries_.front().record.best.received_at + duplicate_memory_ <= now)
+            {
+                Forget();
+            }
+        }
+
+        // Emits everything still waiting, e.g. once every input has ended
+        template <typename Emitter>
+        void Flush(Emitter emit)
+        {
+            while (next_emit_ != entries_.end())
+            {
+                EmitNext(emit);
+            }
+
+            while (!entries_.empty())
+            {
+                Forget();
+            }
+        }
+
+        const MergerStats &GetStats() const
+        {
+            return stats_;
+        }
+
+    private:
+        struct Pending
+        {
+            MergedRecord record;
+            bool is_emitted;
+        };
+        typedef std::list<Pending>::iterator Entry;
+
+        Clock::duration reorder_latency_;
+        Clock::duration duplicate_memory_;
+        Clock::time_point last_emitted_at_;
+        MergerStats stats_;
+
+        // Oldest first; everything before next_emit_ has been emitted
+        std::list<Pending> entries_;
+        Entry next_emit_;
+        std::unordered_multimap<uint32_t, Entry> by_rover_; // BOAT entries by hardware ID
+
+        // Folds a BOAT arrival into an entry for the same frame, if there is one
+        bool TryMerge(const Arrival &arrival)
+        {
+            auto range = by_rover_.equal_range(arrival.boat.hardware_id);
+            for (auto i = range.first; i != range.second; i++)
+            {
+                MergedRecord &record = i->second->record;
+                if (!IsSameFrame(record, arrival))
+                {
+                    continue;
+                }
+
+                record.bases |= 1u << arrival.base;
+                record.copies++;
+
+                if (i->second->is_emitted)
+                {
+                    stats_.late_duplicates++;
+                }
+                else if (arrival.boat.rssi > record.best.boat.rssi)
+                {
+                    Clock::time_point received_at = record.best.received_at;
+                    record.best = arrival;
+                    record.best.received_at = received_at;
+                }
+
+                return true;
+            }
+
+            return false;
+        }
+
+        static bool IsSameFrame(const MergedRecord &record, const Arrival &arrival)
+        {
+            uint32_t sequence = record.best.boat.sequence;
+            if (sequence != serial_decoder::kNoSequence || arrival.boat.sequence != serial_decoder::kNoSequence)
+            {
+                return sequence == arrival.boat.sequence;
+            }
+
+            return (record.bases & 1u << arrival.base) == 0;
+        }
+
+        template <typename Emitter>
+        void EmitNext(Emitter &emit)
+        {
+            const MergedRecord &record = next_emit_->record;
+            if (record.best.received_at > last_emitted_at_)
+            {
+                last_emitted_at_ = record.best.received_at;
+            }
+
+            stats_.emitted++;
+            stats_.late += record.is_late;
+            emit(record);
+            next_emit_->is_emitted = true;
+            next_emit_++;
+        }
+
+        void Forget()
+        {
+            Entry entry = entries_.begin();
+            if (entry->record.best.kind == Arrival::Kind::kBoat)
+            {
+                auto range = by_rover_.equal_range(entry->record.best.boat.hardware_id);
+                for (auto i = range.first; i != range.second; i++)
+                {
+                    if (i->second == entry)
+                    {
+                        by_rover_.erase(i);
+                        break;
+                    }
+                }
+            }
+
+            if (next_emit_ == entry)
+            {
+                next_emit_++;
+            }
+            entries_.pop_front();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+//
+// Bounded lock-free queue between exactly one producer thread and one consumer thread. Each side owns one index and
+// only reads the other's, so a push or pop is a couple of atomic loads and one release store, with no locks and no
+// allocation. The indexes sit on separate cache lines so the two threads don't bounce one line between cores.
+//
+#include <atomic>
+#include <cstddef>
+
+namespace nautic_net::base_merger
+{
+    template <typename T, size_t kCapacity>
+    class SPSCQueue
+    {
+    public:
+        static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two");
+
+        // Producer only. False if full.
+        bool TryPush(const T &item)
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == kCapacity)
+            {
+                return false;
+            }
+
+            items_[tail & (kCapacity - 1)] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. False if empty.
+        bool TryPop(T *item)
+        {
+            size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            *item = items_[head & (kCapacity - 1)];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        alignas(64) std::atomic<size_t> head_{0}; // Next to pop; written by the consumer
+        alignas(64) std::atomic<size_t> tail_{0}; // Next to push; written by the producer
+        alignas(64) T items_[kCapacity];
+    };
+}
+
+#endif
@@ -0,0 +1,422 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+//
+// Writing and memory-mapped reading of captures (capture_format.h). POSIX only.
+//
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "capture_format.h"
+
+namespace nautic_net::capture
+{
+    // Groups record numbers by hardware ID, keeping each group in record (time) order
+    inline void BuildRoverIndex(const std::vector<uint32_t> &hardware_ids, std::vector<RoverEntry> *rovers,
+                                std::vector<uint32_t> *rover_records)
+    {
+        rover_records->resize(hardware_ids.size());
+        for (uint32_t i = 0; i < hardware_ids.size(); i++)
+        {
+            (*rover_records)[i] = i;
+        }
+        std::stable_sort(rover_records->begin(), rover_records->end(),
+                         [&](uint32_t a, uint32_t b) { return hardware_ids[a] < hardware_ids[b]; });
+
+        rovers->clear();
+        for (uint32_t i = 0; i < rover_records->size(); i++)
+        {
+            uint32_t hardware_id = hardware_ids[(*rover_records)[i]];
+            if (rovers->empty() || rovers->back().hardware_id != hardware_id)
+            {
+                rovers->push_back({hardware_id, i, 0, 0});
+            }
+            rovers->back().count++;
+        }
+    }
+
+    class CaptureReader
+    {
+    public:
+        CaptureReader() = default;
+        CaptureReader(const CaptureReader &) = delete;
+        CaptureReader &operator=(const CaptureReader &) = delete;
+
+        ~CaptureReader()
+        {
+            if (data_ != nullptr)
+            {
+                munmap((void *)data_, size_);
+            }
+        }
+
+        bool Open(const char *path, std::string *error)
+        {
+            int fd = open(path, O_RDONLY);
+            struct stat status;
+            if (fd < 0 || fstat(fd, &status) != 0)
+            {
+                *error = std::string(path) + ": " + strerror(errno);
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                return false;
+            }
+
+            size_ = status.st_size;
+            void *data = size_ >= sizeof(FileHeader) ? mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (data == MAP_FAILED)
+            {
+                *error = std::string(path) + ": not a capture";
+                size_ = 0;
+                return false;
+            }
+
+            data_ = (const uint8_t *)data;
+            header_ = (const FileHeader *)data_;
+            if (header_->magic != kFileMagic || header_->version != kVersion || header_->header_size < sizeof(FileHeader) ||
+                header_->header_size > size_)
+            {
+                *error = std::string(path) + ": not a capture, or an unsupported version";
+                return false;
+            }
+
+            if (!TryLoadIndex())
+            {
+                RebuildIndex();
+            }
+
+            return true;
+        }
+
+        int64_t GetStartedAt() const
+        {
+            return header_->started_at;
+        }
+
+        // False if the writer never closed the capture, and the index was rebuilt by scanning
+        bool IsIndexed() const
+        {
+            return is_indexed_;
+        }
+
+        // Where the next record would go
+        uint64_t GetRecordsEnd() const
+        {
+            return records_end_;
+        }
+
+        size_t GetRecordCount() const
+        {
+            return record_count_;
+        }
+
+        const Record &GetRecord(size_t number) const
+        {
+            return *(const Record *)(data_ + offsets_[number]);
+        }
+
+        uint64_t GetOffset(size_t number) const
+        {
+            return offsets_[number];
+        }
+
+        static const uint8_t *GetFrame(const Record &record)
+        {
+            return (const uint8_t *)(&record + 1);
+        }
+
+        size_t GetRoverCount() const
+        {
+            return rover_count_;
+        }
+
+        const RoverEntry &GetRover(size_t index) const
+        {
+            return rovers_[index];
+        }
+
+        // Number of the first record at or after time, or GetRecordCount()
+        size_t FindTime(uint64_t time) const
+        {
+            return std::partition_point(offsets_, offsets_ + record_count_,
+                                        [&](uint64_t offset) { return ((const Record *)(data_ + offset))->time < time; }) -
+                   offsets_;
+        }
+
+        // Every record in [from, to), in time order
+        template <typename Visitor>
+        void ForEach(uint64_t from, uint64_t to, Visitor visit) const
+        {
+            for (size_t i = FindTime(from); i < record_count_ && GetRecord(i).time < to; i++)
+            {
+                visit(GetRecord(i));
+            }
+        }
+
+        // One rover's records in [from, to), in time order
+        template <typename Visitor>
+        void ForEach(uint32_t hardware_id, uint64_t from, uint64_t to, Visitor visit) const
+        {
+            const RoverEntry *rover = std::lower_bound(rovers_, rovers_ + rover_count_, hardware_id,
+                                                       [](const RoverEntry &entry, uint32_t id) { return entry.hardware_id < id; });
+            if (rover == rovers_ + rover_count_ || rover->hardware_id != hardware_id)
+            {
+                return;
+            }
+
+            const uint32_t *first = rover_records_ + rover->first;
+            const uint32_t *last = first + rover->count;
+            for (const uint32_t *i = std::partition_point(first, last, [&](uint32_t number) { return GetRecord(number).time < from; });
+                 i != last && GetRecord(*i).time < to; i++)
+            {
+                visit(GetRecord(*i));
+            }
+        }
+
+    private:
+        const uint8_t *data_ = nullptr;
+        size_t size_ = 0;
+        const FileHeader *header_ = nullptr;
+        bool is_indexed_ = false;
+        uint64_t records_end_ = 0;
+
+        // Into the mapping, or into the vectors below when rebuilt
+        const uint64_t *offsets_ = nullptr;
+        const RoverEntry *rovers_ = nullptr;
+        const uint32_t *rover_records_ = nullptr;
+        size_t record_count_ = 0;
+        size_t rover_count_ = 0;
+
+        std::vector<uint64_t> scanned_offsets_;
+        std::vector<RoverEntry> scanned_rovers_;
+        std::vector<uint32_t> scanned_rover_records_;
+
+        bool TryLoadIndex()
+        {
+            if (size_ < header_->header_size + sizeof(IndexHeader) + sizeof(Footer))
+            {
+                return false;
+            }
+
+            const Footer *footer = (const Footer *)(data_ + size_ - sizeof(Footer));
+            if (footer->magic != kFooterMagic || footer->index_offset < header_->header_size ||
+                footer->index_offset > size_ - sizeof(Footer) - sizeof(IndexHeader) || footer->index_offset % 8 != 0)
+            {
+                return false;
+            }
+
+            const IndexHeader *index = (const IndexHeader *)(data_ + footer->index_offset);
+            uint64_t index_size = sizeof(IndexHeader) + 8 * (uint64_t)index->record_count +
+                                  sizeof(RoverEntry) * (uint64_t)index->rover_count + ((4 * (uint64_t)index->record_count + 7) & ~(uint64_t)7);
+            if (index->magic != kIndexMagic || footer->index_offset + index_size + sizeof(Footer) != size_)
+            {
+                return false;
+            }
+
+            record_count_ = index->record_count;
+            rover_count_ = index->rover_count;
+            offsets_ = (const uint64_t *)(index + 1);
+            rovers_ = (const RoverEntry *)(offsets_ + record_count_);
+            rover_records_ = (const uint32_t *)(rovers_ + rover_count_);
+            records_end_ = footer->index_offset;
+            is_indexed_ = true;
+
+            return true;
+        }
+
+        // Walks the records up to the first that's missing or cut short
+        void RebuildIndex()
+        {
+            std::vector<uint32_t> hardware_ids;
+            uint64_t offset = header_->header_size;
+
+            while (size_ - offset >= sizeof(Record))
+            {
+                const Record *record = (const Record *)(data_ + offset);
+                if (record->magic != kRecordMagic || size_ - offset < sizeof(Record) + record->frame_length)
+                {
+                    break;
+                }
+
+                scanned_offsets_.push_back(offset);
+                hardware_ids.push_back(record->hardware_id);
+                offset += std::min<uint64_t>(GetRecordSize(record->frame_length), size_ - offset);
+            }
+
+            BuildRoverIndex(hardware_ids, &scanned_rovers_, &scanned_rover_records_);
+
+            record_count_ = scanned_offsets_.size();
+            rover_count_ = scanned_rovers_.size();
+            offsets_ = scanned_offsets_.data();
+            rovers_ = scanned_rovers_.data();
+            rover_records_ = scanned_rover_records_.data();
+            records_end_ = (offset + 7) & ~(uint64_t)7;
+            is_indexed_ = false;
+        }
+    };
+
+    class CaptureWriter
+    {
+    public:
+        CaptureWriter() = default;
+        CaptureWriter(const CaptureWriter &) = delete;
+        CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+        ~CaptureWriter()
+        {
+            Close();
+        }
+
+        // Creates the capture, or reopens an existing one to append to it
+        bool Open(const char *path, std::string *error)
+        {
+            struct stat status;
+            if (stat(path, &status) == 0 && status.st_size > 0)
+            {
+                CaptureReader reader;
+                if (!reader.Open(path, error))
+                {
+                    return false;
+                }
+
+                started_at_ = reader.GetStartedAt();
+                end_ = reader.GetRecordsEnd();
+                for (size_t i = 0; i < reader.GetRecordCount(); i++)
+                {
+                    offsets_.push_back(reader.GetOffset(i));
+                    hardware_ids_.push_back(reader.GetRecord(i).hardware_id);
+                    last_time_ = reader.GetRecord(i).time;
+                }
+
+                file_ = fopen(path, "r+b");
+                if (file_ == nullptr || ftruncate(fileno(file_), end_) != 0 || fseek(file_, end_, SEEK_SET) != 0)
+                {
+                    *error = std::string(path) + ": " + strerror(errno);
+                    return false;
+                }
+
+                return true;
+            }
+
+            file_ = fopen(path, "w+b");
+            if (file_ == nullptr)
+            {
+                *error = std::string(path) + ": " + strerror(errno);
+                return false;
+            }
+
+            FileHeader header = {};
+            header.magic = kFileMagic;
+            header.version = kVersion;
+            header.header_size = sizeof(FileHeader);
+            header.started_at = GetNow();
+            started_at_ = header.started_at;
+            end_ = sizeof(header);
+
+            return Write(&header, sizeof(header));
+        }
+
+        // µs since the capture started, for Record::time
+        uint64_t GetTime() const
+        {
+            return GetNow() - started_at_;
+        }
+
+        bool Append(Record record, const uint8_t *frame)
+        {
+            static const uint8_t kPadding[8] = {};
+
+            // Times never go backwards, so that the file stays in time order even if the clock is stepped
+            record.time = record.time < last_time_ ? last_time_ : record.time;
+            record.magic = kRecordMagic;
+            last_time_ = record.time;
+
+            uint64_t size = GetRecordSize(record.frame_length);
+            offsets_.push_back(end_);
+            hardware_ids_.push_back(record.hardware_id);
+            end_ += size;
+
+            return Write(&record, sizeof(record)) && Write(frame, record.frame_length) &&
+                   Write(kPadding, size - sizeof(record) - record.frame_length);
+        }
+
+        // Makes what's been appended so far visible to readers, if not yet indexed
+        void Flush()
+        {
+            if (file_ != nullptr)
+            {
+                fflush(file_);
+            }
+        }
+
+        // Writes the index. The capture can't be appended to any more until it's reopened.
+        bool Close()
+        {
+            if (file_ == nullptr)
+            {
+                return true;
+            }
+
+            std::vector<RoverEntry> rovers;
+            std::vector<uint32_t> rover_records;
+            BuildRoverIndex(hardware_ids_, &rovers, &rover_records);
+            if (rover_records.size() % 2 != 0)
+            {
+                rover_records.push_back(0);
+            }
+
+            IndexHeader index = {kIndexMagic, (uint32_t)offsets_.size(), (uint32_t)rovers.size(), 0};
+            Footer footer = {end_, kFooterMagic, 0};
+            bool is_written = Write(&index, sizeof(index)) && Write(offsets_.data(), 8 * offsets_.size()) &&
+                              Write(rovers.data(), sizeof(RoverEntry) * rovers.size()) &&
+                              Write(rover_records.data(), 4 * rover_records.size()) && Write(&footer, sizeof(footer));
+
+            is_written &= fclose(file_) == 0;
+            file_ = nullptr;
+            return is_written;
+        }
+
+        int64_t GetStartedAt() const
+        {
+            return started_at_;
+        }
+
+        size_t GetRecordCount() const
+        {
+            return offsets_.size();
+        }
+
+    private:
+        FILE *file_ = nullptr;
+        int64_t started_at_ = 0;
+        uint64_t end_ = 0;       // Of the last record
+        uint64_t last_time_ = 0;
+        std::vector<uint64_t> offsets_;
+        std::vector<uint32_t> hardware_ids_;
+
+        bool Write(const void *data, size_t length)
+        {
+            return length == 0 || fwrite(data, length, 1, file_) == 1;
+        }
+
+        // µs since the Unix epoch
+        static int64_t GetNow()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+//
+// On-disk layout of a capture: the frames one base station received, for post-race analysis and replay.
+//
+//   FileHeader
+//   Record, Record, ...        appended as frames arrive, in arrival order
+//   IndexHeader                written when the capture is closed:
+//   uint64_t[record_count]       file offset of every record, in arrival (and so time) order
+//   RoverEntry[rover_count]      by hardware ID, ascending
+//   uint32_t[record_count]       record numbers grouped by rover, each group in time order; padded to 8 bytes
+//   Footer
+//
+// Everything is little-endian and 8-byte aligned, so a reader can mmap the file and use the structs in place. A
+// capture whose writer died never got its index; records start with a magic number, so a reader can still scan
+// them and rebuild the index in memory. Reopening a capture for writing drops its index and appends after the last
+// record.
+//
+#include <cstdint>
+
+namespace nautic_net::capture
+{
+    static const uint64_t kFileMagic = 0x31504143544E4E00ULL; // "\0NNTCAP1"
+    static const uint32_t kRecordMagic = 0x4345524E;          // "NREC"
+    static const uint32_t kIndexMagic = 0x5844494E;           // "NIDX"
+    static const uint32_t kFooterMagic = 0x544F464E;          // "NFOT"
+    static const uint16_t kVersion = 1;
+
+    static const uint16_t kUnknownCycle = 0xFFFF;
+    static const uint8_t kUnknownSlot = 0xFF;
+
+    struct FileHeader
+    {
+        uint64_t magic;
+        uint16_t version;
+        uint16_t header_size; // sizeof(FileHeader), so fields can be added
+        uint32_t reserved;
+        int64_t started_at;   // µs since the Unix epoch; record times count from here
+        uint64_t reserved2;
+    };
+
+    // Followed by frame_length bytes of LoRaPacket, exactly as received, then zero padding to a multiple of 8
+    struct Record
+    {
+        uint32_t magic;
+        uint16_t frame_length;
+        int16_t rssi;         // dBm
+        uint64_t time;        // µs since FileHeader::started_at, by the host's clock
+        uint32_t hardware_id; // Resolved by the writer for address-only frames; 0 if unknown (e.g. from the base itself)
+        uint16_t cycle;       // Base's cycle of the day, or kUnknownCycle (text serial output doesn't carry it)
+        uint8_t slot;         // Base's slot, or kUnknownSlot
+        int8_t snr;           // dB; 0 if unknown
+    };
+
+    struct IndexHeader
+    {
+        uint32_t magic;
+        uint32_t record_count;
+        uint32_t rover_count;
+        uint32_t reserved;
+    };
+
+    struct RoverEntry
+    {
+        uint32_t hardware_id;
+        uint32_t first; // Into the grouped record numbers
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct Footer
+    {
+        uint64_t index_offset; // Of the IndexHeader
+        uint32_t magic;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(FileHeader) == 32 && sizeof(Record) == 24 && sizeof(IndexHeader) == 16 &&
+                      sizeof(RoverEntry) == 16 && sizeof(Footer) == 16,
+                  "Capture structs are written to disk as they are");
+
+    constexpr uint64_t GetRecordSize(uint16_t frame_length)
+    {
+        return (sizeof(Record) + frame_length + 7) & ~(uint64_t)7;
+    }
+}
+
+#endif
@@ -0,0 +1,199 @@
+//
+// Records a base station's serial output into a capture (capture_format.h): every received frame, with the time it
+// arrived, RSSI, SNR, slot and cycle (from binary frames; text lines don't carry the last three), and the rover's
+// hardware ID. Address-only RoverData frames are resolved to hardware IDs through the BOAT line the base prints after
+// each one. Debug output and console responses are dropped.
+//
+// The capture is flushed after every read, so capture_replay can follow it while recording, and indexed on Ctrl-C or
+// when the input ends. An existing capture is appended to.
+//
+// Build from the repository root, with nanopb from PlatformIO's library directory:
+//
+//   NANOPB=.pio/libdeps/adafruit_feather_m0/Nanopb
+//   g++ -std=c++17 -O2 -Isrc -I$NANOPB tools/capture/capture_record.cpp src/lora_packet.pb.c $NANOPB/pb_decode.c $NANOPB/pb_common.c -o capture_record
+//
+//   ./capture_record race.nncap /dev/ttyACM0
+//
+#include <csignal>
+#include <cstdio>
+#include <unordered_map>
+
+#include "../serial_decoder/serial_decoder.h"
+#include "capture_file.h"
+#include "nautic_net/frame_header.h"
+
+using namespace nautic_net;
+using namespace nautic_net::capture;
+
+static volatile sig_atomic_t is_stopping = 0;
+
+static void Stop(int)
+{
+    is_stopping = 1;
+}
+
+// Holds each frame back until the next record, in case it's a BOAT line naming the rover
+class RecordingHandler : public serial_decoder::RecordHandler
+{
+public:
+    explicit RecordingHandler(CaptureWriter *writer) : writer_(writer)
+    {
+    }
+
+    void SetReceivedAt(uint64_t time)
+    {
+        received_at_ = time;
+    }
+
+    void OnLoRa(const serial_decoder::LoRaRecord &lora) override
+    {
+        Commit();
+
+        frame::Header header;
+        if (!frame::TryPeekHeader(lora.frame, lora.frame_length, &header))
+        {
+            malformed_count_++;
+            return;
+        }
+
+        pending_ = {};
+        pending_.frame_length = lora.frame_length;
+        pending_.rssi = lora.rssi;
+        pending_.time = received_at_;
+        pending_.hardware_id = header.hardware_id;
+        pending_.cycle = lora.cycle < 0 ? kUnknownCycle : lora.cycle;
+        pending_.slot = lora.slot < 0 ? kUnknownSlot : lora.slot;
+        pending_.snr = lora.snr;
+        memcpy(pending_frame_, lora.frame, lora.frame_length);
+        pending_address_ = header.address;
+        is_pending_rover_data_ = header.payload_tag == LoRaPacket_rover_data_tag;
+        is_pending_ = true;
+
+        if (header.hardware_id != 0 && header.address != 0)
+        {
+            hardware_ids_[header.address] = header.hardware_id;
+        }
+        else if (header.hardware_id == 0 && header.address != 0)
+        {
+            // Until the BOAT line turns up
+            auto known = hardware_ids_.find(header.address);
+            pending_.hardware_id = known == hardware_ids_.end() ? 0 : known->second;
+        }
+    }
+
+    void OnBoat(const serial_decoder::BoatRecord &boat) override
+    {
+        // A line drained from the base's backlog doesn't follow its frame
+        if (is_pending_ && is_pending_rover_data_ && !boat.logged)
+        {
+            pending_.hardware_id = boat.hardware_id;
+            if (pending_address_ != 0)
+            {
+                hardware_ids_[pending_address_] = boat.hardware_id;
+            }
+        }
+
+        Commit();
+    }
+
+    void OnLink(const serial_decoder::LinkRecord &link) override
+    {
+        Commit();
+    }
+
+    void Commit()
+    {
+        if (is_pending_)
+        {
+            is_written_ &= writer_->Append(pending_, pending_frame_);
+            is_pending_ = false;
+        }
+    }
+
+    bool IsWritten() const
+    {
+        return is_written_;
+    }
+
+    unsigned long GetMalformedCount() const
+    {
+        return malformed_count_;
+    }
+
+private:
+    CaptureWriter *writer_;
+    uint64_t received_at_ = 0;
+    Record pending_;
+    uint8_t pending_frame_[host_frame::kMaxPayloadSize];
+    uint32_t pending_address_ = 0;
+    bool is_pending_rover_data_ = false;
+    bool is_pending_ = false;
+    bool is_written_ = true;
+    unsigned long malformed_count_ = 0;
+    std::unordered_map<uint32_t, uint32_t> hardware_ids_; // By network address, as last seen
+};
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s capture input   (input: a serial port set up with stty, a pipe, or - for stdin)\n", argv[0]);
+        return 1;
+    }
+
+    CaptureWriter writer;
+    std::string error;
+    if (!writer.Open(argv[1], &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    int fd = strcmp(argv[2], "-") == 0 ? 0 : open(argv[2], O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", argv[2], strerror(errno));
+        return 1;
+    }
+
+    // No SA_RESTART, so a blocked read() returns and the capture gets its index
+    struct sigaction action = {};
+    action.sa_handler = Stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    size_t initial_count = writer.GetRecordCount();
+    RecordingHandler handler(&writer);
+    serial_decoder::SerialDecoder decoder(&handler, false);
+    uint8_t buffer[4096];
+
+    while (!is_stopping)
+    {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            if (length < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        handler.SetReceivedAt(writer.GetTime());
+        decoder.Feed(buffer, length);
+        writer.Flush();
+    }
+
+    handler.Commit();
+    bool is_closed = writer.Close();
+    fprintf(stderr, "%zu frames recorded (%zu in the capture), %lu malformed\n", writer.GetRecordCount() - initial_count,
+            writer.GetRecordCount(), handler.GetMalformedCount() + decoder.GetStats().malformed);
+
+    if (!handler.IsWritten() || !is_closed)
+    {
+        fprintf(stderr, "%s: write failed\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
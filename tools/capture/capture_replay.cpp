@@ -0,0 +1,276 @@
+//
+// Replays a capture (capture_format.h) recorded by capture_record.
+//
+//   capture_replay [options] capture            re-emits the frames as the base printed them (LORA lines), at the
+//                                               speed they were received; feed it to anything that reads a base
+//   capture_replay --rovers capture             lists the rovers heard, with frame counts and time spans
+//   capture_replay --link [options] capture     runs the RoverData frames through the base's link accounting
+//                                               (base/roster_table.h) and prints the LINK lines it would have
+//
+// Options select and pace the frames:
+//
+//   --rover HWID    only this rover's frames (hex)
+//   --from S        only frames received at least S seconds into the capture
+//   --to S          only frames received less than S seconds into the capture
+//   --speed N       N times real time; 0 replays as fast as possible
+//   --binary        binary frames (host_frame.h) instead of LORA lines, carrying SNR, slot and cycle too
+//
+// --link is for regression testing changes to the link accounting against real traffic. Slot misses depend on the
+// base's schedule, which isn't captured, so they stay 0.
+//
+// Build from the repository root, with nanopb from PlatformIO's library directory:
+//
+//   NANOPB=.pio/libdeps/adafruit_feather_m0/Nanopb
+//   g++ -std=c++17 -O2 -Isrc -I$NANOPB tools/capture/capture_replay.cpp src/lora_packet.pb.c $NANOPB/pb_decode.c $NANOPB/pb_common.c -o capture_replay
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+
+#include <pb_decode.h>
+
+#include "capture_file.h"
+#include "lora_packet.pb.h"
+#include "nautic_net/base/roster_table.h"
+#include "nautic_net/host_frame.h"
+
+using namespace nautic_net;
+using namespace nautic_net::capture;
+
+static const unsigned int kSequenceModulus = 128;   // tdma::kSequenceModulus
+static const unsigned int kLinkReportInterval = 10; // Base::kLinkReportInterval
+
+static void PrintLoRa(const Record &record, bool is_binary)
+{
+    const uint8_t *frame = CaptureReader::GetFrame(record);
+
+    if (is_binary)
+    {
+        uint8_t payload[host_frame::kMaxPayloadSize];
+        uint8_t out[host_frame::kMaxFrameSize];
+        size_t length = record.frame_length < host_frame::kMaxPayloadSize - host_frame::kLoRaPrefixSize
+                            ? record.frame_length
+                            : host_frame::kMaxPayloadSize - host_frame::kLoRaPrefixSize;
+
+        payload[0] = record.rssi & 0xFF;
+        payload[1] = (record.rssi >> 8) & 0xFF;
+        payload[2] = record.snr;
+        payload[3] = record.slot;
+        payload[4] = record.cycle & 0xFF;
+        payload[5] = record.cycle >> 8;
+        memcpy(payload + host_frame::kLoRaPrefixSize, frame, length);
+
+        fwrite(out, host_frame::Encode(host_frame::Type::kLoRa, payload, host_frame::kLoRaPrefixSize + length, out), 1, stdout);
+        return;
+    }
+
+    printf("LORA,%d,", record.rssi);
+    for (unsigned int i = 0; i < record.frame_length; i++)
+    {
+        printf("%02X", frame[i]);
+    }
+    printf("\r\n");
+}
+
+// Paces records to speed times the rate they were received at
+class Pacer
+{
+public:
+    explicit Pacer(double speed) : speed_(speed)
+    {
+    }
+
+    void Wait(uint64_t time)
+    {
+        if (speed_ <= 0)
+        {
+            return;
+        }
+
+        if (!is_started_)
+        {
+            first_time_ = time;
+            started_at_ = std::chrono::steady_clock::now();
+            is_started_ = true;
+            return;
+        }
+
+        fflush(stdout);
+        std::this_thread::sleep_until(started_at_ + std::chrono::microseconds((uint64_t)((time - first_time_) / speed_)));
+    }
+
+private:
+    double speed_;
+    bool is_started_ = false;
+    uint64_t first_time_ = 0;
+    std::chrono::steady_clock::time_point started_at_;
+};
+
+static void PrintRovers(const CaptureReader &reader)
+{
+    printf("%-10s %8s %10s %10s\n", "hwid", "frames", "first s", "last s");
+
+    for (size_t i = 0; i < reader.GetRoverCount(); i++)
+    {
+        const RoverEntry &rover = reader.GetRover(i);
+        uint64_t first = ~(uint64_t)0, last = 0;
+        reader.ForEach(rover.hardware_id, 0, ~(uint64_t)0, [&](const Record &record) {
+            first = record.time < first ? record.time : first;
+            last = record.time;
+        });
+
+        printf("%-10X %8u %10.1f %10.1f\n", rover.hardware_id, rover.count, first / 1e6, last / 1e6);
+    }
+}
+
+static void PrintLink(uint32_t hardware_id, const base::LinkStats &link)
+{
+    printf("LINK hwid:%X rx:%u missed:%u dup:%u slotmiss:%u rssi:%d rssimin:%d rssimax:%d snr:%d cycle:%u\n",
+           hardware_id, link.received, link.missed, link.duplicates, link.slot_misses, link.rssi, link.rssi_min,
+           link.rssi_max, link.snr, link.last_heard_cycle);
+}
+
+// What Base::HandlePacket does with a RoverData frame's link statistics
+static void ReplayLink(const Record &record, std::map<uint32_t, base::LinkStats> *links, unsigned long *malformed_count)
+{
+    LoRaPacket packet = LoRaPacket_init_zero;
+    pb_istream_t stream = pb_istream_from_buffer(CaptureReader::GetFrame(record), record.frame_length);
+    if (!pb_decode_ex(&stream, LoRaPacket_fields, &packet, PB_DECODE_NULLTERMINATED))
+    {
+        (*malformed_count)++;
+        return;
+    }
+
+    // Like the base, ignore data it can't attribute to a rover
+    if (packet.which_payload != LoRaPacket_rover_data_tag || record.hardware_id == 0)
+    {
+        return;
+    }
+
+    base::LinkStats &link = (*links)[record.hardware_id];
+    base::RecordLinkFrame<kSequenceModulus>(&link, packet.payload.rover_data.sequence, record.rssi, record.snr,
+                                            record.cycle == kUnknownCycle ? 0 : record.cycle);
+
+    if (link.received % kLinkReportInterval == 0)
+    {
+        PrintLink(record.hardware_id, link);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    enum class Mode
+    {
+        kReplay,
+        kRovers,
+        kLink,
+    } mode = Mode::kReplay;
+
+    const char *path = nullptr;
+    bool has_rover = false;
+    uint32_t rover = 0;
+    uint64_t from = 0, to = ~(uint64_t)0;
+    double speed = 1;
+    bool is_binary = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--rovers") == 0)
+        {
+            mode = Mode::kRovers;
+        }
+        else if (strcmp(argv[i], "--link") == 0)
+        {
+            mode = Mode::kLink;
+        }
+        else if (strcmp(argv[i], "--binary") == 0)
+        {
+            is_binary = true;
+        }
+        else if (strcmp(argv[i], "--rover") == 0 && has_value)
+        {
+            has_rover = true;
+            rover = strtoul(argv[++i], nullptr, 16);
+        }
+        else if (strcmp(argv[i], "--from") == 0 && has_value)
+        {
+            from = atof(argv[++i]) * 1e6;
+        }
+        else if (strcmp(argv[i], "--to") == 0 && has_value)
+        {
+            to = atof(argv[++i]) * 1e6;
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && has_value)
+        {
+            speed = atof(argv[++i]);
+        }
+        else if (argv[i][0] != '-' && path == nullptr)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path = nullptr;
+            break;
+        }
+    }
+
+    if (path == nullptr)
+    {
+        fprintf(stderr, "usage: %s [--rovers | --link] [--rover HWID] [--from S] [--to S] [--speed N] [--binary] capture\n", argv[0]);
+        return 1;
+    }
+
+    CaptureReader reader;
+    std::string error;
+    if (!reader.Open(path, &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    if (!reader.IsIndexed())
+    {
+        fprintf(stderr, "%s: not closed cleanly; index rebuilt from %zu records\n", path, reader.GetRecordCount());
+    }
+
+    if (mode == Mode::kRovers)
+    {
+        PrintRovers(reader);
+        return 0;
+    }
+
+    Pacer pacer(mode == Mode::kReplay ? speed : 0);
+    std::map<uint32_t, base::LinkStats> links;
+    unsigned long malformed_count = 0;
+
+    auto visit = [&](const Record &record) {
+        if (mode == Mode::kLink)
+        {
+            ReplayLink(record, &links, &malformed_count);
+            return;
+        }
+
+        pacer.Wait(record.time);
+        PrintLoRa(record, is_binary);
+    };
+
+    if (has_rover)
+    {
+        reader.ForEach(rover, from, to, visit);
+    }
+    else
+    {
+        reader.ForEach(from, to, visit);
+    }
+
+    if (malformed_count != 0)
+    {
+        fprintf(stderr, "%lu frames didn't decode\n", malformed_count);
+    }
+
+    return 0;
+}
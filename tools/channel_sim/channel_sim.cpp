@@ -0,0 +1,183 @@
+//
+// Host simulation of the TDMA channel plans, using the same channel selection as the firmware
+// (src/nautic_net/tdma/channel_plan.h).
+//
+// The schedule matches the default config: 8 usable slot sets per cycle, each with 10 transmissions. Rovers get
+// (channel, slot set) pairs in the same order as the base hands them out: every slot set on channel 0 first, then
+// channel 1, and so on. Each channel has an independent per-frame loss probability; by default channel 0 is shared
+// with interference (e.g. a neighbouring fleet) and loses far more than the rest.
+//
+// "parallel" is a reference point rather than a firmware plan: it assumes one base receiver per channel.
+//
+// Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -Isrc tools/channel_sim/channel_sim.cpp -o channel_sim && ./channel_sim
+//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "nautic_net/tdma/channel_plan.h"
+
+using namespace nautic_net::tdma;
+
+static const unsigned int kSlotSetCount = 8;       // Data slot sets per cycle (tdma::kRosterCapacity on one channel)
+static const unsigned int kTransmitsPerCycle = 10; // tdma::kRoverSlotCount
+
+enum class Plan
+{
+    kSingle,
+    kStaggered,
+    kRotating,
+    kParallel
+};
+
+struct Options
+{
+    unsigned int channel_count = 4;
+    unsigned int cycles = 2000;
+    double noisy_loss = 0.3; // Channel 0
+    double loss = 0.05;      // Every other channel
+    unsigned int seed = 1;
+};
+
+static const char *GetPlanName(Plan plan)
+{
+    switch (plan)
+    {
+    case Plan::kSingle:
+        return "single";
+    case Plan::kStaggered:
+        return "staggered";
+    case Plan::kRotating:
+        return "rotating";
+    default:
+        return "parallel";
+    }
+}
+
+static unsigned int GetCapacity(Plan plan, unsigned int channel_count)
+{
+    return plan == Plan::kRotating || plan == Plan::kParallel ? kSlotSetCount * channel_count : kSlotSetCount;
+}
+
+static void RunPlan(Plan plan, unsigned int rover_count, const Options &options, std::mt19937 &rng)
+{
+    unsigned int capacity = GetCapacity(plan, options.channel_count);
+    unsigned int served = std::min(rover_count, capacity);
+    ChannelPlan firmware_plan = plan == Plan::kStaggered ? ChannelPlan::kStaggered : plan == Plan::kSingle ? ChannelPlan::kSingle : ChannelPlan::kRotating;
+
+    // Channel-major assignment, like Base::DiscoverRover
+    std::vector<unsigned int> rover_slot_sets(served), rover_channels(served);
+    std::vector<uint32_t> occupied_channels(kSlotSetCount);
+    for (unsigned int r = 0; r < served; r++)
+    {
+        rover_slot_sets[r] = r % kSlotSetCount;
+        rover_channels[r] = r / kSlotSetCount;
+        occupied_channels[rover_slot_sets[r]] |= 1u << rover_channels[r];
+    }
+
+    std::vector<unsigned long> delivered(served);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    for (unsigned int cycle = 0; cycle < options.cycles; cycle++)
+    {
+        for (unsigned int i = 0; i < kTransmitsPerCycle; i++)
+        {
+            for (unsigned int r = 0; r < served; r++)
+            {
+                unsigned int tx_channel = GetTransmitChannel(firmware_plan, options.channel_count, i, rover_channels[r]);
+
+                bool is_heard;
+                if (plan == Plan::kParallel)
+                {
+                    is_heard = true;
+                }
+                else if (plan == Plan::kRotating)
+                {
+                    is_heard = SelectReceiveChannel(occupied_channels[rover_slot_sets[r]], i) == tx_channel;
+                }
+                else
+                {
+                    is_heard = GetTransmitChannel(firmware_plan, options.channel_count, i, 0) == tx_channel;
+                }
+
+                double loss = tx_channel == 0 ? options.noisy_loss : options.loss;
+                if (is_heard && uniform(rng) >= loss)
+                {
+                    delivered[r]++;
+                }
+            }
+        }
+    }
+
+    double total_sent = (double)options.cycles * kTransmitsPerCycle;
+    double mean = 0;
+    double min = served == 0 ? 0 : 1;
+    for (unsigned long count : delivered)
+    {
+        mean += count / total_sent;
+        min = std::min(min, count / total_sent);
+    }
+    mean = served == 0 ? 0 : mean / served;
+
+    printf("%-10s %6u %8u %6u %12.1f %12.1f %14.2f\n",
+           GetPlanName(plan), rover_count, capacity, served, 100 * mean, 100 * min, mean * kTransmitsPerCycle);
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--channels") == 0 && i + 1 < argc)
+        {
+            options.channel_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc)
+        {
+            options.cycles = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--noisy-loss") == 0 && i + 1 < argc)
+        {
+            options.noisy_loss = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc)
+        {
+            options.loss = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            options.seed = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--channels N] [--cycles N] [--noisy-loss P] [--loss P] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.channel_count < 1 || options.channel_count > 32)
+    {
+        fprintf(stderr, "--channels must be 1 through 32\n");
+        return 1;
+    }
+
+    std::mt19937 rng(options.seed);
+
+    printf("%-10s %6s %8s %6s %12s %12s %14s\n", "plan", "rovers", "capacity", "served", "mean dlv %", "min dlv %", "updates/cycle");
+
+    for (Plan plan : {Plan::kSingle, Plan::kStaggered, Plan::kRotating, Plan::kParallel})
+    {
+        for (unsigned int rover_count = kSlotSetCount; rover_count <= kSlotSetCount * options.channel_count; rover_count += kSlotSetCount)
+        {
+            RunPlan(plan, rover_count, options, rng);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+//
+// Host simulation of rover discovery, using the same DiscoveryBackoff and ContentionEstimator as the firmware.
+//
+// All rovers power on at once (the dock-out case) and contend in the discovery slots. The base configures up to
+// --configs-per-slot rovers per configuration slot (one RoverConfigurationBatch holds 8; the original
+// RoverConfiguration held 1), and advertises its contention window whenever it has nobody to configure.
+// A sub-slot with exactly one transmitter is received; anything more is a collision (no capture effect).
+//
+// For comparison, "legacy" is the original scheme: every unconfigured rover transmits in every discovery slot after
+// a random 0-80ms delay, and two ~12ms frames collide if their start times are less than a frame apart.
+//
+// Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -Isrc tools/discovery_sim/discovery_sim.cpp -o discovery_sim && ./discovery_sim
+//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "nautic_net/tdma/discovery.h"
+
+using namespace nautic_net::tdma;
+
+static const unsigned int kDiscoverySlotsPerCycle = 10; // config::kRoverDiscoverySlots
+static const double kCycleDurationSec = 10.0;           // config::kCycleDurationSec
+static const double kLegacyMaxDelayMs = 80.0;
+static const double kDiscoveryAirtimeMs = 12.0;
+static const unsigned int kMaxCycles = 200;
+
+enum class Strategy
+{
+    kLegacy,
+    kBackoff
+};
+
+struct Result
+{
+    unsigned long attempts = 0;
+    unsigned long successes = 0;
+    std::vector<double> configure_times; // sec
+    unsigned int unconfigured = 0;
+};
+
+struct Rover
+{
+    DiscoveryBackoff backoff;
+    bool is_configured = false;
+    bool is_queued = false;
+    double configured_at = 0;
+};
+
+static void RunTrial(Strategy strategy, unsigned int rover_count, unsigned int configs_per_slot, std::mt19937 &rng, Result *result)
+{
+    std::vector<Rover> rovers(rover_count);
+    std::deque<unsigned int> config_queue;
+    ContentionEstimator estimator;
+    std::uniform_real_distribution<double> delay(0, kLegacyMaxDelayMs);
+
+    for (unsigned int slot = 0; slot < kMaxCycles * kDiscoverySlotsPerCycle; slot++)
+    {
+        //
+        // Discovery slot
+        //
+        std::vector<unsigned int> transmitters;
+        std::vector<double> offsets; // ms into the slot
+        estimator.HandleDiscoverySlot();
+
+        for (unsigned int i = 0; i < rover_count; i++)
+        {
+            Rover &rover = rovers[i];
+            if (rover.is_configured)
+            {
+                continue;
+            }
+
+            if (strategy == Strategy::kLegacy)
+            {
+                transmitters.push_back(i);
+                offsets.push_back(delay(rng));
+            }
+            else
+            {
+                unsigned int sub_slot;
+                if (rover.backoff.HandleDiscoverySlot(rng(), &sub_slot))
+                {
+                    transmitters.push_back(i);
+                    offsets.push_back(sub_slot * (100.0 / kDiscoverySubSlotCount));
+                }
+            }
+        }
+
+        result->attempts += transmitters.size();
+
+        // The base sees a collided sub-slot as one corrupted frame
+        std::vector<unsigned int> sub_slot_counts(kDiscoverySubSlotCount);
+        for (double offset : offsets)
+        {
+            sub_slot_counts[std::min((unsigned int)(offset * kDiscoverySubSlotCount / 100.0), kDiscoverySubSlotCount - 1)]++;
+        }
+        for (unsigned int count : sub_slot_counts)
+        {
+            if (count > 1)
+            {
+                estimator.HandleCollision();
+            }
+        }
+
+        for (size_t a = 0; a < transmitters.size(); a++)
+        {
+            bool is_collision = false;
+            for (size_t b = 0; b < transmitters.size() && !is_collision; b++)
+            {
+                is_collision = a != b && std::abs(offsets[a] - offsets[b]) < kDiscoveryAirtimeMs;
+            }
+
+            if (!is_collision)
+            {
+                result->successes++;
+                estimator.HandleDiscovery();
+
+                Rover &rover = rovers[transmitters[a]];
+                if (!rover.is_queued)
+                {
+                    rover.is_queued = true;
+                    config_queue.push_back(transmitters[a]);
+                }
+            }
+        }
+
+        //
+        // Configuration slot, immediately after
+        //
+        double now = (slot / kDiscoverySlotsPerCycle) * kCycleDurationSec + (slot % kDiscoverySlotsPerCycle + 1) * (kCycleDurationSec / kDiscoverySlotsPerCycle);
+
+        if (config_queue.empty())
+        {
+            for (Rover &rover : rovers)
+            {
+                rover.backoff.SetAdvertisedWindow(estimator.GetWindow());
+            }
+        }
+
+        for (unsigned int c = 0; c < configs_per_slot && !config_queue.empty(); c++)
+        {
+            Rover &rover = rovers[config_queue.front()];
+            config_queue.pop_front();
+
+            rover.is_configured = true;
+            rover.configured_at = now;
+            result->configure_times.push_back(now);
+        }
+
+        if (slot % kDiscoverySlotsPerCycle == kDiscoverySlotsPerCycle - 1)
+        {
+            estimator.HandleCycleEnd();
+        }
+
+        if (std::all_of(rovers.begin(), rovers.end(), [](const Rover &r) { return r.is_configured; }))
+        {
+            return;
+        }
+    }
+
+    for (const Rover &rover : rovers)
+    {
+        result->unconfigured += rover.is_configured ? 0 : 1;
+    }
+}
+
+static double Percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int trials = 200;
+    unsigned int configs_per_slot = 8;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--trials") == 0 && i + 1 < argc)
+        {
+            trials = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--configs-per-slot") == 0 && i + 1 < argc)
+        {
+            configs_per_slot = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--trials N] [--configs-per-slot N] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    const unsigned int rover_counts[] = {1, 5, 10, 20, 30, 50, 80, 100};
+
+    printf("%-8s %6s %10s %10s %10s %10s %12s\n", "strategy", "rovers", "p(success)", "mean (s)", "p90 (s)", "max (s)", "unconfigured");
+
+    for (Strategy strategy : {Strategy::kLegacy, Strategy::kBackoff})
+    {
+        for (unsigned int rover_count : rover_counts)
+        {
+            Result result;
+            for (unsigned int t = 0; t < trials; t++)
+            {
+                RunTrial(strategy, rover_count, configs_per_slot, rng, &result);
+            }
+
+            double mean = 0;
+            for (double time : result.configure_times)
+            {
+                mean += time;
+            }
+            mean = result.configure_times.empty() ? 0 : mean / result.configure_times.size();
+
+            printf("%-8s %6u %10.3f %10.1f %10.1f %10.1f %12u\n",
+                   strategy == Strategy::kLegacy ? "legacy" : "backoff",
+                   rover_count,
+                   result.attempts == 0 ? 0.0 : (double)result.successes / result.attempts,
+                   mean,
+                   Percentile(result.configure_times, 0.9),
+                   Percentile(result.configure_times, 1.0),
+                   result.unconfigured);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+//
+// Host benchmark of the base station roster, using the same RosterTable and SlotBitmap as the firmware.
+//
+// For 256 to 1024 simulated rovers, compares:
+//
+//   - lookup by hardware ID (the per-packet cost in Base::HandlePacket) against the original linear scan over an
+//     array of RoverInfo pointers
+//   - filling every slot set through SlotBitmap::Allocate against probing entries one at a time
+//
+// Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -Isrc tools/roster_bench/roster_bench.cpp -o roster_bench && ./roster_bench
+//
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "nautic_net/base/roster_table.h"
+#include "nautic_net/tdma/slot_bitmap.h"
+
+using namespace nautic_net;
+
+static const unsigned int kLookupCount = 2000000;
+static const unsigned int kAllocateRepeats = 2000;
+
+// The original layout: one heap object per rover, found by scanning pointers
+struct LegacyRover
+{
+    unsigned int hardware_id_;
+    unsigned int serial_number_;
+    bool is_configured_;
+    int slots_[10];
+};
+
+static double ElapsedNs(std::chrono::steady_clock::time_point started_at)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started_at).count();
+}
+
+template <unsigned int kRoverCount>
+static void RunBenchmark(std::mt19937 &rng)
+{
+    std::vector<uint32_t> hardware_ids(kRoverCount);
+    for (uint32_t &hardware_id : hardware_ids)
+    {
+        hardware_id = rng() | 1; // Never 0
+    }
+
+    // Lookups are 90% known rovers and 10% strangers, e.g. a neighbouring fleet
+    std::vector<uint32_t> queries(kLookupCount);
+    for (uint32_t &query : queries)
+    {
+        query = rng() % 10 == 0 ? (rng() | 1) : hardware_ids[rng() % kRoverCount];
+    }
+
+    //
+    // Lookup
+    //
+    static base::RosterTable<kRoverCount> roster;
+    roster.Clear();
+    for (uint32_t hardware_id : hardware_ids)
+    {
+        roster.Insert(hardware_id);
+    }
+
+    std::vector<LegacyRover *> legacy(kRoverCount);
+    for (unsigned int i = 0; i < kRoverCount; i++)
+    {
+        legacy[i] = new LegacyRover{hardware_ids[i], 0, false, {}};
+    }
+
+    unsigned long found = 0;
+    auto started_at = std::chrono::steady_clock::now();
+    for (uint32_t query : queries)
+    {
+        found += roster.Find(query) != roster.kNotFound;
+    }
+    double table_ns = ElapsedNs(started_at) / kLookupCount;
+
+    unsigned long legacy_found = 0;
+    started_at = std::chrono::steady_clock::now();
+    for (uint32_t query : queries)
+    {
+        for (unsigned int i = 0; i < kRoverCount; i++)
+        {
+            if (legacy[i]->hardware_id_ == query)
+            {
+                legacy_found++;
+                break;
+            }
+        }
+    }
+    double legacy_ns = ElapsedNs(started_at) / kLookupCount;
+
+    for (LegacyRover *rover : legacy)
+    {
+        delete rover;
+    }
+
+    //
+    // Slot set allocation, from empty to full
+    //
+    static tdma::SlotBitmap<kRoverCount> bitmap;
+    unsigned long allocated = 0;
+    started_at = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < kAllocateRepeats; r++)
+    {
+        bitmap.Clear();
+        while (bitmap.Allocate() != bitmap.kNone)
+        {
+            allocated++;
+        }
+    }
+    double bitmap_ns = ElapsedNs(started_at) / allocated;
+
+    static bool is_used[kRoverCount];
+    unsigned long probed = 0;
+    started_at = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < kAllocateRepeats; r++)
+    {
+        for (bool &used : is_used)
+        {
+            used = false;
+        }
+
+        for (unsigned int n = 0; n < kRoverCount; n++)
+        {
+            unsigned int i = 0;
+            while (is_used[i])
+            {
+                i++;
+            }
+            is_used[i] = true;
+            probed++;
+        }
+    }
+    double probe_ns = ElapsedNs(started_at) / probed;
+
+    printf("%6u %12.1f %12.1f %10lu %12.1f %12.1f\n", kRoverCount, table_ns, legacy_ns, found == legacy_found ? found : 0, bitmap_ns, probe_ns);
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+
+    printf("%6s %12s %12s %10s %12s %12s\n", "rovers", "find (ns)", "scan (ns)", "hits", "bitmap (ns)", "probe (ns)");
+    RunBenchmark<256>(rng);
+    RunBenchmark<512>(rng);
+    RunBenchmark<1024>(rng);
+
+    return 0;
+}
@@ -0,0 +1,370 @@
+//
+// Throughput of the host-side serial decoder (serial_decoder.h), in records per second.
+//
+// Synthesizes what a busy base station prints: for every RoverData frame a LORA line and a BOAT line, a LINK line
+// every 10 frames, and the odd debug line. The same traffic is also encoded as binary frames (host_frame.h) in place
+// of the LORA lines. Each stream is fed in 4KB reads, as from a serial port, and decoded with and without nanopb
+// packet decoding. The hex decoders are also timed on their own, SIMD against a lookup table.
+//
+// Before timing, checks that SIMD and table hex decoding agree, that the CRC table matches crc.h, and that feeding a
+// stream one byte at a time gives the same records as feeding it whole.
+//
+// Build and run from the repository root, with nanopb from PlatformIO's library directory:
+//
+//   NANOPB=.pio/libdeps/adafruit_feather_m0/Nanopb
+//   g++ -std=c++17 -O2 -Isrc -I$NANOPB tools/serial_decoder/decoder_bench.cpp src/lora_packet.pb.c $NANOPB/pb_decode.c $NANOPB/pb_common.c -o decoder_bench && ./decoder_bench
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "serial_decoder.h"
+
+using namespace nautic_net;
+using namespace nautic_net::serial_decoder;
+
+static const size_t kReadSize = 4096;
+static const double kMinDuration = 0.5; // s per measurement
+
+// Counts records and folds their contents into a checksum, so nothing is optimized away
+class CountingHandler : public RecordHandler
+{
+public:
+    unsigned long records = 0;
+    unsigned long decoded = 0;
+    unsigned long checksum = 0;
+
+    void OnLoRa(const LoRaRecord &record) override
+    {
+        records++;
+        checksum += record.frame_length + record.rssi;
+        if (record.packet != nullptr)
+        {
+            decoded++;
+            checksum += record.packet->address + record.packet->payload.rover_data.sequence;
+        }
+    }
+
+    void OnBoat(const BoatRecord &record) override
+    {
+        records++;
+        checksum += record.hardware_id + record.heading + (unsigned long)(record.latitude * 1e6);
+    }
+
+    void OnLink(const LinkRecord &record) override
+    {
+        records++;
+        checksum += record.hardware_id + record.received;
+    }
+};
+
+static void WriteVarint(std::vector<uint8_t> *out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out->push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back((uint8_t)value);
+}
+
+static void WriteFixed32(std::vector<uint8_t> *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out->push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void WriteFloat(std::vector<uint8_t> *out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    WriteFixed32(out, bits);
+}
+
+// An address-only RoverData frame, as a configured rover sends most cycles, encoded by hand so the benchmark needs
+// only nanopb's decoder
+static std::vector<uint8_t> EncodeRoverData(unsigned int address, const RoverData &data)
+{
+    std::vector<uint8_t> fields;
+    fields.push_back(RoverData_latitude_tag << 3 | 5);
+    WriteFloat(&fields, data.latitude);
+    fields.push_back(RoverData_longitude_tag << 3 | 5);
+    WriteFloat(&fields, data.longitude);
+    for (auto [tag, value] : {std::pair<uint32_t, uint32_t>{RoverData_heading_tag, data.heading},
+                              {RoverData_heel_tag, data.heel},
+                              {RoverData_cog_tag, data.cog},
+                              {RoverData_sog_tag, data.sog},
+                              {RoverData_battery_tag, data.battery},
+                              {RoverData_sequence_tag, data.sequence}})
+    {
+        fields.push_back((uint8_t)(tag << 3));
+        WriteVarint(&fields, value);
+    }
+
+    std::vector<uint8_t> frame;
+    frame.push_back(LoRaPacket_rover_data_tag << 3 | 2);
+    WriteVarint(&frame, fields.size());
+    frame.insert(frame.end(), fields.begin(), fields.end());
+    frame.push_back(LoRaPacket_address_tag << 3);
+    WriteVarint(&frame, address);
+
+    return frame;
+}
+
+static void Append(std::vector<uint8_t> *stream, const std::string &text)
+{
+    stream->insert(stream->end(), text.begin(), text.end());
+}
+
+// Base station output for frame_count RoverData frames from rover_count rovers
+static std::vector<uint8_t> MakeStream(unsigned int frame_count, unsigned int rover_count, bool is_binary)
+{
+    std::mt19937 random(1);
+    std::vector<uint8_t> stream;
+    char line[512];
+
+    for (unsigned int i = 0; i < frame_count; i++)
+    {
+        unsigned int rover = i % rover_count;
+        uint32_t hardware_id = 0x10000000 + rover * 7919;
+        int rssi = -60 - (int)(random() % 60);
+
+        RoverData data = RoverData_init_zero;
+        data.latitude = 37.8f + (random() % 10000) * 1e-6f;
+        data.longitude = -122.4f - (random() % 10000) * 1e-6f;
+        data.heading = random() % 3600;
+        data.heel = random() % 400;
+        data.cog = random() % 3600;
+        data.sog = random() % 150;
+        data.battery = 50 + random() % 50;
+        data.sequence = (i / rover_count) % 128;
+        std::vector<uint8_t> frame = EncodeRoverData(rover + 1, data);
+
+        if (is_binary)
+        {
+            unsigned int cycle = i / rover_count;
+            std::vector<uint8_t> payload = {(uint8_t)(rssi & 0xFF), (uint8_t)((rssi >> 8) & 0xFF), (uint8_t)(random() % 20),
+                                            (uint8_t)(i % 100), (uint8_t)(cycle & 0xFF), (uint8_t)(cycle >> 8)};
+            payload.insert(payload.end(), frame.begin(), frame.end());
+
+            uint8_t out[host_frame::kMaxFrameSize];
+            size_t size = host_frame::Encode(host_frame::Type::kLoRa, payload.data(), payload.size(), out);
+            stream.insert(stream.end(), out, out + size);
+        }
+        else
+        {
+            std::string hex;
+            for (uint8_t byte : frame)
+            {
+                snprintf(line, sizeof(line), "%02X", byte);
+                hex += line;
+            }
+            snprintf(line, sizeof(line), "LORA,%d,%s\r\n", rssi, hex.c_str());
+            Append(&stream, line);
+        }
+
+        snprintf(line, sizeof(line), "%sBOAT rssi:%d hwid:%X lat:%.8f lon:%.8f heading:%u heel:%u sog:%u cog:%u bat:%u seq:%u serial:%u\r\n",
+                 i < rover_count ? "\a" : "", rssi, hardware_id, data.latitude, data.longitude, data.heading, data.heel,
+                 data.sog, data.cog, data.battery, data.sequence, rover + 1000);
+        Append(&stream, line);
+
+        if (i % 10 == 9)
+        {
+            snprintf(line, sizeof(line), "LINK hwid:%X rx:%u missed:%u dup:0 slotmiss:%u rssi:%d rssimin:%d rssimax:%d snr:%u cycle:%u\r\n",
+                     hardware_id, i / rover_count, (unsigned int)(random() % 5), (unsigned int)(random() % 5), rssi,
+                     rssi - 10, rssi + 10, (unsigned int)(random() % 10), i / rover_count);
+            Append(&stream, line);
+        }
+
+        if (i % 50 == 49)
+        {
+            Append(&stream, "TX ->   BaseBeacon (12)\r\n");
+        }
+    }
+
+    return stream;
+}
+
+static void Feed(SerialDecoder *decoder, const std::vector<uint8_t> &stream, size_t read_size)
+{
+    for (size_t position = 0; position < stream.size(); position += read_size)
+    {
+        decoder->Feed(stream.data() + position, std::min(read_size, stream.size() - position));
+    }
+}
+
+static bool CheckHex()
+{
+    std::mt19937 random(2);
+    const char *kDigits = "0123456789ABCDEFabcdef";
+
+    for (int trial = 0; trial < 100000; trial++)
+    {
+        size_t digit_count = 2 * (random() % 64);
+        char hex[128];
+        for (size_t i = 0; i < digit_count; i++)
+        {
+            hex[i] = kDigits[random() % 22];
+        }
+
+        // Now and then, one bad digit
+        bool is_corrupt = digit_count > 0 && random() % 4 == 0;
+        if (is_corrupt)
+        {
+            hex[random() % digit_count] = "g/:@G`\x80 "[random() % 8];
+        }
+
+        uint8_t simd[64], scalar[64];
+        bool simd_ok = hex::Decode(hex, digit_count, simd);
+        bool scalar_ok = hex::DecodeScalar(hex, digit_count, scalar);
+        if (simd_ok != scalar_ok || simd_ok == is_corrupt || (simd_ok && memcmp(simd, scalar, digit_count / 2) != 0))
+        {
+            fprintf(stderr, "hex mismatch: %.*s\n", (int)digit_count, hex);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool CheckCRC()
+{
+    std::mt19937 random(4);
+    uint8_t data[host_frame::kMaxPayloadSize + 2];
+
+    for (int trial = 0; trial < 10000; trial++)
+    {
+        size_t length = random() % sizeof(data);
+        for (size_t i = 0; i < length; i++)
+        {
+            data[i] = random();
+        }
+
+        if (crc_table::CRC16(data, length) != crc::CRC16(data, length))
+        {
+            fprintf(stderr, "CRC mismatch\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool CheckChunking(const std::vector<uint8_t> &stream)
+{
+    CountingHandler whole, bytewise, odd;
+    SerialDecoder whole_decoder(&whole), bytewise_decoder(&bytewise), odd_decoder(&odd);
+
+    Feed(&whole_decoder, stream, stream.size());
+    Feed(&bytewise_decoder, stream, 1);
+    Feed(&odd_decoder, stream, 37);
+
+    const DecoderStats &stats = whole_decoder.GetStats();
+    if (stats.malformed != 0 || stats.packet_errors != 0 || whole.records != bytewise.records ||
+        whole.checksum != bytewise.checksum || whole.records != odd.records || whole.checksum != odd.checksum)
+    {
+        fprintf(stderr, "chunking mismatch: %lu/%lu/%lu records, %lu malformed, %lu packet errors\n", whole.records,
+                bytewise.records, odd.records, stats.malformed, stats.packet_errors);
+        return false;
+    }
+
+    return true;
+}
+
+static void Measure(const char *name, const std::vector<uint8_t> &stream, bool is_decoding_packets)
+{
+    CountingHandler handler;
+    unsigned long passes = 0;
+    double elapsed;
+    auto start = std::chrono::steady_clock::now();
+
+    do
+    {
+        SerialDecoder decoder(&handler, is_decoding_packets);
+        Feed(&decoder, stream, kReadSize);
+        passes++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < kMinDuration);
+
+    printf("%-24s %12.0f %10.1f %10lu\n", name, handler.records / elapsed, passes * stream.size() / elapsed / 1e6,
+           handler.checksum % 1000);
+}
+
+static void MeasureHex(const char *name, bool (*decode)(const char *, size_t, uint8_t *))
+{
+    std::mt19937 random(3);
+    std::string hex;
+    for (int i = 0; i < 4096; i++)
+    {
+        hex += "0123456789ABCDEF"[random() % 16];
+    }
+
+    uint8_t out[2048];
+    unsigned long passes = 0, checksum = 0;
+    double elapsed;
+    auto start = std::chrono::steady_clock::now();
+
+    do
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            decode(hex.data(), hex.size(), out);
+            checksum += out[passes % sizeof(out)];
+            passes++;
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < kMinDuration);
+
+    printf("%-24s %12s %10.1f %10lu\n", name, "-", passes * hex.size() / elapsed / 1e6, checksum % 1000);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int frame_count = 20000;
+    unsigned int rover_count = 100;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frame_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--rovers") == 0 && i + 1 < argc)
+        {
+            rover_count = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--frames N] [--rovers N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> text = MakeStream(frame_count, rover_count, false);
+    std::vector<uint8_t> binary = MakeStream(frame_count, rover_count, true);
+
+    if (!CheckHex() || !CheckCRC() || !CheckChunking(text) || !CheckChunking(binary))
+    {
+        return 1;
+    }
+
+    printf("%u frames from %u rovers: %zu bytes as text, %zu with binary frames\n\n", frame_count, rover_count,
+           text.size(), binary.size());
+    printf("%-24s %12s %10s %10s\n", "stream", "records/s", "MB/s", "checksum");
+
+    Measure("text", text, true);
+    Measure("text, no packet decode", text, false);
+    Measure("binary", binary, true);
+    Measure("binary, no packet decode", binary, false);
+    MeasureHex("hex SSE2", hex::Decode);
+    MeasureHex("hex table", hex::DecodeScalar);
+
+    return 0;
+}
@@ -0,0 +1,599 @@
+#ifndef SERIAL_DECODER_H
+#define SERIAL_DECODER_H
+
+//
+// Host-side decoder for the base station's serial stream: LORA and BOAT lines, LINK reports, and binary frames
+// (src/nautic_net/host_frame.h), in any mix and split across reads at any byte.
+//
+// Feed() parses records in place: line fields and binary frame bytes are handed out as slices of the caller's
+// buffer. Only a record cut off at the end of a read is copied, and only until it completes. LORA hex is decoded
+// sixteen digits at a time with SSE2 on x86-64 hosts. LoRaPackets are decoded with nanopb against the firmware's own
+// lora_packet.pb.h, so the decoder can't drift from the wire format.
+//
+// Needs nanopb's pb_decode.c and pb_common.c, and src/lora_packet.pb.c; see tools/serial_decoder/decoder_bench.cpp.
+//
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <pb_decode.h>
+
+#include "lora_packet.pb.h"
+#include "nautic_net/host_frame.h"
+
+namespace nautic_net::serial_decoder
+{
+    // A LoRaPacket as received by the base, from a LORA line or a binary frame
+    struct LoRaRecord
+    {
+        int rssi;             // dBm
+        int snr;              // dB; LORA lines don't carry it, so 0
+        int slot;             // Base's slot number when it was received; LORA lines don't carry it, so -1
+        int cycle;            // Base's cycle of the day (see tdma/superframe.h); -1 from LORA lines
+        bool is_binary;       // From a binary frame rather than a LORA line
+        const uint8_t *frame; // Raw LoRaPacket: the caller's buffer for binary frames, the decoder's for LORA lines
+        size_t frame_length;
+        const LoRaPacket *packet; // nullptr if packet decoding is off or the frame didn't decode
+    };
+
+    // A BOAT line: the base's rendering of one rover's RoverData
+    struct BoatRecord
+    {
+        int rssi; // dBm
+        uint32_t hardware_id;
+        double latitude;   // degrees
+        double longitude;  // degrees
+        uint32_t heading;  // degrees * 10
+        uint32_t heel;     // degrees * 10
+        uint32_t sog;      // knots * 10
+        uint32_t cog;      // degrees * 10
+        uint32_t battery;  // percent, 0 if unknown
+        uint32_t sequence; // RoverData.sequence, or kNoSequence from firmware that doesn't print it
+        uint32_t serial_number;
+        uint32_t logged; // 1 if drained from the base's backlog after a host dropout, so heard long before it was read
+        uint32_t backfill; // 1 if the rover resent it after the base missed it, so sent long before it was read
+        uint32_t cycle;  // For logged and backfill lines, when it was heard or first sent; kNoCycle otherwise
+        uint32_t slot;
+    };
+
+    static const uint32_t kNoSequence = 0xFFFFFFFF;
+    static const uint32_t kNoCycle = 0xFFFFFFFF;
+
+    // A LINK line: the base's running link statistics for one rover
+    struct LinkRecord
+    {
+        uint32_t hardware_id;
+        uint32_t received;
+        uint32_t missed;
+        uint32_t duplicates;
+        uint32_t slot_misses;
+        int rssi;     // dBm, smoothed
+        int rssi_min; // dBm
+        int rssi_max; // dBm
+        int snr;      // dB, smoothed
+        uint32_t last_heard_cycle;
+    };
+
+    // Records are only valid during the call; copy anything worth keeping
+    class RecordHandler
+    {
+    public:
+        virtual ~RecordHandler() = default;
+        virtual void OnLoRa(const LoRaRecord &record) {}
+        virtual void OnBoat(const BoatRecord &record) {}
+        virtual void OnLink(const LinkRecord &record) {}
+        virtual void OnFrame(host_frame::Type type, const uint8_t *payload, size_t length) {} // Other binary frames
+    };
+
+    struct DecoderStats
+    {
+        unsigned long bytes = 0;
+        unsigned long lora_records = 0;
+        unsigned long boat_records = 0;
+        unsigned long link_records = 0;
+        unsigned long ignored = 0;        // Debug output, console responses, frames other than kLoRa
+        unsigned long malformed = 0;      // Unparseable lines, bad hex, bad CRCs, junk between records
+        unsigned long packet_errors = 0;  // Frames nanopb couldn't decode
+    };
+
+    namespace hex
+    {
+        static const uint8_t kInvalid = 0xFF;
+
+        struct NibbleTable
+        {
+            uint8_t values[256];
+
+            constexpr NibbleTable() : values()
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    values[i] = i >= '0' && i <= '9'   ? i - '0'
+                                : i >= 'A' && i <= 'F' ? i - 'A' + 10
+                                : i >= 'a' && i <= 'f' ? i - 'a' + 10
+                                                       : kInvalid;
+                }
+            }
+        };
+
+        static constexpr NibbleTable kNibbles;
+
+        // One byte at a time through a table. False on any non-hex digit.
+        inline bool DecodeScalar(const char *hex, size_t digit_count, uint8_t *out)
+        {
+            for (size_t i = 0; i < digit_count / 2; i++)
+            {
+                uint8_t high = kNibbles.values[(uint8_t)hex[2 * i]];
+                uint8_t low = kNibbles.values[(uint8_t)hex[2 * i + 1]];
+                if (high == kInvalid || low == kInvalid)
+                {
+                    return false;
+                }
+
+                out[i] = high << 4 | low;
+            }
+
+            return true;
+        }
+
+        // Sixteen digits at a time with SSE2, which every x86-64 host has, so no build flags are needed; the table
+        // elsewhere. False on any non-hex digit.
+        inline bool Decode(const char *hex, size_t digit_count, uint8_t *out)
+        {
+            size_t i = 0;
+#ifdef __SSE2__
+            const __m128i kLowNibbles = _mm_set1_epi8(0x0F);
+            const __m128i kLowBytes = _mm_set1_epi16(0x00FF);
+
+            for (; i + 16 <= digit_count; i += 16)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i *)(hex + i));
+
+                // Signed compares, so bytes with the high bit set fail both tests
+                __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+                __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+                __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+                if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF)
+                {
+                    return false;
+                }
+
+                // '0'-'9' are 0x30-0x39, 'A'-'F' and 'a'-'f' 0x41-0x46 and 0x61-0x66: the low nibble, plus 9 for letters
+                __m128i nibbles = _mm_add_epi8(_mm_and_si128(v, kLowNibbles), _mm_and_si128(is_letter, _mm_set1_epi8(9)));
+
+                // Each 16-bit lane holds a digit pair, the first digit in the low byte
+                __m128i pairs = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8)), kLowBytes);
+                _mm_storel_epi64((__m128i *)(out + i / 2), _mm_packus_epi16(pairs, pairs));
+            }
+#endif
+
+            return DecodeScalar(hex + i, digit_count - i, out + i / 2);
+        }
+    }
+
+    // CRC-16/CCITT-FALSE a byte at a time through a table, for binary frames; the same as crc::CRC16, which works
+    // bit by bit to save flash on the firmware side
+    namespace crc_table
+    {
+        struct Table
+        {
+            uint16_t values[256];
+
+            constexpr Table() : values()
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    uint16_t crc = i << 8;
+                    for (int bit = 0; bit < 8; bit++)
+                    {
+                        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+                    }
+                    values[i] = crc;
+                }
+            }
+        };
+
+        static constexpr Table kTable;
+
+        inline uint16_t CRC16(const uint8_t *data, size_t length, uint16_t crc = crc::kCRC16Initial)
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                crc = crc << 8 ^ kTable.values[(crc >> 8 ^ data[i]) & 0xFF];
+            }
+
+            return crc;
+        }
+    }
+
+    class SerialDecoder
+    {
+    public:
+        static const size_t kMaxLineLength = 1024; // Longer runs without a newline are junk and dropped
+
+        // is_decoding_packets: decode every LoRaPacket (LoRaRecord::packet); off, records carry the raw frame only
+        explicit SerialDecoder(RecordHandler *handler, bool is_decoding_packets = true)
+            : handler_(handler), is_decoding_packets_(is_decoding_packets)
+        {
+            carry_.reserve(kMaxLineLength + 1);
+        }
+
+        // Any amount of the stream; a record split across calls is completed by the next one
+        void Feed(const uint8_t *data, size_t length)
+        {
+            stats_.bytes += length;
+            size_t position = 0;
+
+            while (!carry_.empty() && position < length)
+            {
+                position += FeedCarry(data + position, length - position);
+            }
+
+            while (position < length)
+            {
+                size_t consumed = TryConsume(data + position, length - position);
+                if (consumed == 0)
+                {
+                    carry_.assign(data + position, data + length);
+                    break;
+                }
+
+                position += consumed;
+            }
+        }
+
+        const DecoderStats &GetStats() const
+        {
+            return stats_;
+        }
+
+    private:
+        RecordHandler *handler_;
+        bool is_decoding_packets_;
+        DecoderStats stats_;
+        std::vector<uint8_t> carry_;         // The incomplete record at the end of the last Feed()
+        uint8_t frame_[host_frame::kMaxPayloadSize]; // LORA line hex, decoded
+        LoRaPacket packet_;
+
+        // Length of the line at the start of data, up to its newline or to a binary frame that cuts it short. *end is
+        // whichever it was: '\n', kSync0, or 0 if neither is in sight yet.
+        static size_t ScanLine(const uint8_t *data, size_t length, uint8_t *end)
+        {
+            const uint8_t *newline = (const uint8_t *)memchr(data, '\n', length);
+            size_t line_length = newline == nullptr ? length : newline - data;
+            const uint8_t *sync = (const uint8_t *)memchr(data, host_frame::kSync0, line_length);
+
+            *end = sync != nullptr ? host_frame::kSync0 : newline != nullptr ? '\n' : 0;
+            return sync != nullptr ? sync - data : line_length;
+        }
+
+        // Handles the record at the start of data, returning its size, or 0 if data holds only part of it
+        size_t TryConsume(const uint8_t *data, size_t length)
+        {
+            if (data[0] == host_frame::kSync0)
+            {
+                if (length >= 2 && data[1] != host_frame::kSync1)
+                {
+                    stats_.malformed++;
+                    return 1;
+                }
+
+                if (length < host_frame::kHeaderSize || length < host_frame::GetFrameSize(data[3]))
+                {
+                    return 0;
+                }
+
+                HandleFrame(data);
+                return host_frame::GetFrameSize(data[3]);
+            }
+
+            uint8_t end;
+            size_t line_length = ScanLine(data, length, &end);
+            if (end == '\n')
+            {
+                HandleLine(std::string_view((const char *)data, line_length));
+                return line_length + 1;
+            }
+
+            if (end == host_frame::kSync0)
+            {
+                // Never to see its newline
+                stats_.malformed++;
+                return line_length;
+            }
+
+            if (length > kMaxLineLength)
+            {
+                stats_.malformed++;
+                return length;
+            }
+
+            return 0;
+        }
+
+        // Appends to carry_ only as much of data as its record needs, handling the record once it's complete.
+        // Returns the bytes taken from data.
+        size_t FeedCarry(const uint8_t *data, size_t length)
+        {
+            size_t take;
+            uint8_t end = 0;
+            if (carry_[0] == host_frame::kSync0)
+            {
+                size_t size = carry_.size() < host_frame::kHeaderSize ? host_frame::kHeaderSize
+                                                                      : host_frame::GetFrameSize(carry_[3]);
+                take = size - carry_.size() < length ? size - carry_.size() : length;
+            }
+            else
+            {
+                take = ScanLine(data, length, &end);
+                take += end == '\n';
+            }
+
+            carry_.insert(carry_.end(), data, data + take);
+
+            size_t consumed;
+            while (!carry_.empty() && (consumed = TryConsume(carry_.data(), carry_.size())) != 0)
+            {
+                carry_.erase(carry_.begin(), carry_.begin() + consumed);
+            }
+
+            if (end == host_frame::kSync0 && !carry_.empty())
+            {
+                // A line fragment, cut short by a binary frame
+                stats_.malformed++;
+                carry_.clear();
+            }
+
+            return take;
+        }
+
+        void HandleFrame(const uint8_t *frame)
+        {
+            size_t crc_offset = host_frame::kHeaderSize + frame[3];
+            if (crc_table::CRC16(frame + 2, 2 + frame[3]) != (frame[crc_offset] | frame[crc_offset + 1] << 8))
+            {
+                stats_.malformed++;
+                return;
+            }
+
+            const uint8_t *payload = frame + host_frame::kHeaderSize;
+            size_t length = frame[3];
+
+            if (frame[2] != (uint8_t)host_frame::Type::kLoRa)
+            {
+                stats_.ignored++;
+                handler_->OnFrame((host_frame::Type)frame[2], payload, length);
+                return;
+            }
+
+            if (length < host_frame::kLoRaPrefixSize)
+            {
+                stats_.malformed++;
+                return;
+            }
+
+            LoRaRecord record;
+            record.rssi = (int16_t)(payload[0] | payload[1] << 8);
+            record.snr = (int8_t)payload[2];
+            record.slot = payload[3];
+            record.cycle = payload[4] | payload[5] << 8;
+            record.is_binary = true;
+            record.frame = payload + host_frame::kLoRaPrefixSize;
+            record.frame_length = length - host_frame::kLoRaPrefixSize;
+            record.packet = DecodePacket(record.frame, record.frame_length);
+
+            stats_.lora_records++;
+            handler_->OnLoRa(record);
+        }
+
+        void HandleLine(std::string_view line)
+        {
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+
+            // The bell the base rings for the first frame from a rover
+            if (!line.empty() && line.front() == '\a')
+            {
+                line.remove_prefix(1);
+            }
+
+            bool is_valid;
+            if (line.substr(0, 5) == "LORA,")
+            {
+                is_valid = TryHandleLoRa(line.substr(5));
+            }
+            else if (line.substr(0, 5) == "BOAT ")
+            {
+                is_valid = TryHandleBoat(line.substr(5));
+            }
+            else if (line.substr(0, 5) == "LINK ")
+            {
+                is_valid = TryHandleLink(line.substr(5));
+            }
+            else
+            {
+                stats_.ignored++;
+                return;
+            }
+
+            if (!is_valid)
+            {
+                stats_.malformed++;
+            }
+        }
+
+        // <rssi>,<hex>
+        bool TryHandleLoRa(std::string_view fields)
+        {
+            size_t comma = fields.find(',');
+            if (comma == std::string_view::npos)
+            {
+                return false;
+            }
+
+            LoRaRecord record;
+            std::string_view hex = fields.substr(comma + 1);
+            if (!TryParse(fields.substr(0, comma), &record.rssi) || hex.size() % 2 != 0 ||
+                hex.size() > 2 * sizeof(frame_) || !hex::Decode(hex.data(), hex.size(), frame_))
+            {
+                return false;
+            }
+
+            record.snr = 0;
+            record.slot = -1;
+            record.cycle = -1;
+            record.is_binary = false;
+            record.frame = frame_;
+            record.frame_length = hex.size() / 2;
+            record.packet = DecodePacket(record.frame, record.frame_length);
+
+            stats_.lora_records++;
+            handler_->OnLoRa(record);
+            return true;
+        }
+
+        // key:value pairs; unknown keys are skipped, so the firmware can add fields
+        bool TryHandleBoat(std::string_view fields)
+        {
+            BoatRecord record = {};
+            record.sequence = kNoSequence;
+            record.cycle = kNoCycle;
+            bool is_valid = true;
+
+            ForEachField(fields, [&](std::string_view key, std::string_view value) {
+                TryParseField(key, value, "rssi", &record.rssi, &is_valid) ||
+                    TryParseField(key, value, "hwid", &record.hardware_id, &is_valid, 16) ||
+                    TryParseField(key, value, "lat", &record.latitude, &is_valid) ||
+                    TryParseField(key, value, "lon", &record.longitude, &is_valid) ||
+                    TryParseField(key, value, "heading", &record.heading, &is_valid) ||
+                    TryParseField(key, value, "heel", &record.heel, &is_valid) ||
+                    TryParseField(key, value, "sog", &record.sog, &is_valid) ||
+                    TryParseField(key, value, "cog", &record.cog, &is_valid) ||
+                    TryParseField(key, value, "bat", &record.battery, &is_valid) ||
+                    TryParseField(key, value, "seq", &record.sequence, &is_valid) ||
+                    TryParseField(key, value, "serial", &record.serial_number, &is_valid) ||
+                    TryParseField(key, value, "logged", &record.logged, &is_valid) ||
+                    TryParseField(key, value, "backfill", &record.backfill, &is_valid) ||
+                    TryParseField(key, value, "cycle", &record.cycle, &is_valid) ||
+                    TryParseField(key, value, "slot", &record.slot, &is_valid);
+            });
+
+            // Hardware ID 0 is the broadcast address, never a rover
+            if (!is_valid || record.hardware_id == 0)
+            {
+                return false;
+            }
+
+            stats_.boat_records++;
+            handler_->OnBoat(record);
+            return true;
+        }
+
+        bool TryHandleLink(std::string_view fields)
+        {
+            LinkRecord record = {};
+            bool is_valid = true;
+
+            ForEachField(fields, [&](std::string_view key, std::string_view value) {
+                TryParseField(key, value, "hwid", &record.hardware_id, &is_valid, 16) ||
+                    TryParseField(key, value, "rx", &record.received, &is_valid) ||
+                    TryParseField(key, value, "missed", &record.missed, &is_valid) ||
+                    TryParseField(key, value, "dup", &record.duplicates, &is_valid) ||
+                    TryParseField(key, value, "slotmiss", &record.slot_misses, &is_valid) ||
+                    TryParseField(key, value, "rssi", &record.rssi, &is_valid) ||
+                    TryParseField(key, value, "rssimin", &record.rssi_min, &is_valid) ||
+                    TryParseField(key, value, "rssimax", &record.rssi_max, &is_valid) ||
+                    TryParseField(key, value, "snr", &record.snr, &is_valid) ||
+                    TryParseField(key, value, "cycle", &record.last_heard_cycle, &is_valid);
+            });
+
+            if (!is_valid || record.hardware_id == 0)
+            {
+                return false;
+            }
+
+            stats_.link_records++;
+            handler_->OnLink(record);
+            return true;
+        }
+
+        const LoRaPacket *DecodePacket(const uint8_t *frame, size_t length)
+        {
+            if (!is_decoding_packets_)
+            {
+                return nullptr;
+            }
+
+            // Implicit header frames arrive zero-padded, as on the rover
+            packet_ = LoRaPacket_init_zero;
+            pb_istream_t stream = pb_istream_from_buffer(frame, length);
+            if (!pb_decode_ex(&stream, LoRaPacket_fields, &packet_, PB_DECODE_NULLTERMINATED))
+            {
+                stats_.packet_errors++;
+                return nullptr;
+            }
+
+            return &packet_;
+        }
+
+        // Space-separated key:value fields
+        template <typename Visitor>
+        static void ForEachField(std::string_view fields, Visitor visit)
+        {
+            while (!fields.empty())
+            {
+                size_t space = fields.find(' ');
+                std::string_view field = fields.substr(0, space);
+                size_t colon = field.find(':');
+                if (colon != std::string_view::npos)
+                {
+                    visit(field.substr(0, colon), field.substr(colon + 1));
+                }
+
+                fields.remove_prefix(space == std::string_view::npos ? fields.size() : space + 1);
+            }
+        }
+
+        // True if key is name, clearing *is_valid unless value parses into *target
+        template <typename T>
+        static bool TryParseField(std::string_view key, std::string_view value, std::string_view name, T *target,
+                                  bool *is_valid, int base = 10)
+        {
+            if (key != name)
+            {
+                return false;
+            }
+
+            *is_valid &= TryParse(value, target, base);
+            return true;
+        }
+
+        // The whole of text must be the number
+        template <typename T>
+        static bool TryParse(std::string_view text, T *value, int base = 10)
+        {
+            std::from_chars_result result;
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                result = std::from_chars(text.data(), text.data() + text.size(), *value);
+            }
+            else
+            {
+                result = std::from_chars(text.data(), text.data() + text.size(), *value, base);
+            }
+
+            return result.ec == std::errc() && result.ptr == text.data() + text.size() && !text.empty();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,264 @@
+//
+// Breaks a firmware build's flash and static RAM down by module, from the linker map, and checks the totals against
+// src/nautic_net/memory_budget.h:
+//
+//   module                                  flash     data      bss
+//   nautic_net/base.cpp                      9876       12     4321
+//   RadioHead                                5432        8      120
+//   ...
+//
+// flash is .text and .rodata; data is .data, which takes flash for its initial values as well as RAM; bss is .bss.
+// Our own sources are listed by file, libraries and the framework by archive. Exits with 1 when the image or static
+// RAM is over budget, so it can gate a build like a test.
+//
+// platformio.ini has the linker write the map next to the firmware. Build from the repository root:
+//
+//   g++ -std=c++17 -O2 -Isrc tools/size_report/size_report.cpp -o size_report
+//
+//   pio run && ./size_report .pio/build/adafruit_feather_m0/firmware.map
+//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "nautic_net/memory_budget.h"
+
+using namespace nautic_net;
+
+enum class Region
+{
+    kNone,
+    kFlash,
+    kData,
+    kBss
+};
+
+typedef struct
+{
+    unsigned long flash = 0;
+    unsigned long data = 0;
+    unsigned long bss = 0;
+} Sizes;
+
+// By output section; input sections are attributed to whichever output section they landed in
+static Region GetRegion(const std::string &section)
+{
+    auto starts_with = [&section](const char *prefix) { return section.compare(0, strlen(prefix), prefix) == 0; };
+
+    if (section == ".data" || section == ".relocate")
+    {
+        return Region::kData;
+    }
+
+    if (section == ".bss" || section == ".zero")
+    {
+        return Region::kBss;
+    }
+
+    if (starts_with(".text") || starts_with(".rodata") || starts_with(".ARM.extab") || starts_with(".ARM.exidx"))
+    {
+        return Region::kFlash;
+    }
+
+    return Region::kNone;
+}
+
+// src/nautic_net/base.cpp from .pio/build/env/src/nautic_net/base.cpp.o, RadioHead from .../libRadioHead.a(x.o)
+static std::string GetModule(const std::string &file)
+{
+    if (file.empty())
+    {
+        return "(linker)";
+    }
+
+    size_t paren = file.find('(');
+    if (paren != std::string::npos)
+    {
+        std::string archive = file.substr(0, paren);
+        archive = archive.substr(archive.rfind('/') == std::string::npos ? 0 : archive.rfind('/') + 1);
+        if (archive.compare(0, 3, "lib") == 0)
+        {
+            archive = archive.substr(3);
+        }
+        if (archive.size() > 2 && archive.compare(archive.size() - 2, 2, ".a") == 0)
+        {
+            archive = archive.substr(0, archive.size() - 2);
+        }
+        return archive;
+    }
+
+    std::string object = file;
+    size_t src = object.find("/src/");
+    object = src != std::string::npos ? object.substr(src + 5)
+                                      : object.substr(object.rfind('/') == std::string::npos ? 0 : object.rfind('/') + 1);
+    if (object.size() > 2 && object.compare(object.size() - 2, 2, ".o") == 0)
+    {
+        object = object.substr(0, object.size() - 2);
+    }
+    return object;
+}
+
+static bool IsHex(const std::string &token)
+{
+    return token.compare(0, 2, "0x") == 0;
+}
+
+static void Add(Sizes *sizes, Region region, unsigned long size)
+{
+    switch (region)
+    {
+    case Region::kFlash:
+        sizes->flash += size;
+        break;
+    case Region::kData:
+        sizes->data += size;
+        break;
+    case Region::kBss:
+        sizes->bss += size;
+        break;
+    case Region::kNone:
+        break;
+    }
+}
+
+//
+// GNU ld's map: after "Linker script and memory map", output sections start in the first column, and the input
+// sections in them are indented by one space:
+//
+//   .text           0x00002000     0x9a3c
+//    .text.loop     0x00002100       0x2c .pio/build/env/src/main.cpp.o
+//    .text._ZN10nautic_net4base4Base10HandleSlotENS_4tdma4SlotE
+//                   0x00002130      0x3f0 .pio/build/env/src/nautic_net/base.cpp.o
+//    *fill*         0x00002520        0x2
+//
+// Names too long for their column push the address and size onto the next line.
+//
+static bool ParseMap(std::istream &in, std::map<std::string, Sizes> *modules)
+{
+    std::string line;
+    bool is_in_map = false;
+    bool is_pending = false; // An input section name on a line of its own
+    Region region = Region::kNone;
+
+    while (std::getline(in, line))
+    {
+        if (!is_in_map)
+        {
+            is_in_map = line.compare(0, 28, "Linker script and memory map") == 0;
+            continue;
+        }
+
+        std::istringstream stream(line);
+        std::vector<std::string> tokens;
+        for (std::string token; stream >> token;)
+        {
+            tokens.push_back(token);
+        }
+
+        if (tokens.empty())
+        {
+            continue;
+        }
+
+        if (line[0] != ' ')
+        {
+            region = GetRegion(tokens[0]);
+            is_pending = false;
+            continue;
+        }
+
+        // Continuation: address, size and file of the input section on the line before. (Symbols are an address and
+        // a name.)
+        if (is_pending && tokens.size() >= 2 && IsHex(tokens[0]) && IsHex(tokens[1]))
+        {
+            Add(&(*modules)[GetModule(tokens.size() >= 3 ? tokens[2] : "")], region, strtoul(tokens[1].c_str(), nullptr, 16));
+            is_pending = false;
+            continue;
+        }
+
+        is_pending = false;
+        if (line.size() < 2 || line[1] == ' ' || tokens[0].compare(0, 2, "*(") == 0)
+        {
+            continue;
+        }
+
+        if (tokens.size() == 1)
+        {
+            is_pending = true;
+            continue;
+        }
+
+        if (tokens.size() >= 3 && IsHex(tokens[1]) && IsHex(tokens[2]))
+        {
+            std::string module = tokens[0] == "*fill*" ? "(fill)" : GetModule(tokens.size() >= 4 ? tokens[3] : "");
+            Add(&(*modules)[module], region, strtoul(tokens[2].c_str(), nullptr, 16));
+        }
+    }
+
+    return is_in_map;
+}
+
+static void PrintBudget(const char *name, unsigned long used, unsigned long budget)
+{
+    printf("%-12s %7lu of %7lu bytes (%3lu%%)%s\n", name, used, budget, used * 100 / budget,
+           used > budget ? "  OVER BUDGET" : "");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s firmware.map\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in)
+    {
+        fprintf(stderr, "%s: can't open\n", argv[1]);
+        return 2;
+    }
+
+    std::map<std::string, Sizes> modules;
+    if (!ParseMap(in, &modules))
+    {
+        fprintf(stderr, "%s: not a GNU ld map\n", argv[1]);
+        return 2;
+    }
+
+    std::vector<std::pair<std::string, Sizes>> sorted(modules.begin(), modules.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+        return a.second.flash + a.second.data + a.second.bss > b.second.flash + b.second.data + b.second.bss;
+    });
+
+    Sizes total;
+    printf("%-36s %8s %8s %8s\n", "module", "flash", "data", "bss");
+    for (const auto &[name, sizes] : sorted)
+    {
+        if (sizes.flash + sizes.data + sizes.bss == 0)
+        {
+            continue;
+        }
+
+        printf("%-36s %8lu %8lu %8lu\n", name.c_str(), sizes.flash, sizes.data, sizes.bss);
+        total.flash += sizes.flash;
+        total.data += sizes.data;
+        total.bss += sizes.bss;
+    }
+    printf("%-36s %8lu %8lu %8lu\n\n", "total", total.flash, total.data, total.bss);
+
+    unsigned long image = total.flash + total.data;
+    unsigned long static_ram = total.data + total.bss;
+    PrintBudget("Image", image, memory::kImageBudget);
+    PrintBudget("Static RAM", static_ram, memory::kStaticRamBudget);
+    printf("(RAM also reserves %lu bytes of stack and %lu of heap; check them on a unit with mem)\n",
+           (unsigned long)memory::kStackReserve, (unsigned long)memory::kHeapReserve);
+
+    return image > memory::kImageBudget || static_ram > memory::kStaticRamBudget ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+//
+// Prints a unit's trace (src/nautic_net/trace.h) as text, one event per line, using the names and formats in
+// src/nautic_net/trace_events.h:
+//
+//   time_us +delta_us event args
+//
+// time_us is the unit's micros() (it wraps every 71 minutes); delta_us is since the previous event. Lines starting
+// with # mark entries that were overwritten before they could be sent.
+//
+// Sends trace dump to the port (set up with stty first) and prints what the ring holds, or with stream, sends
+// trace stream 1 and prints events as they come until interrupted. With - instead of a port, reads frames saved
+// earlier from stdin.
+//
+// Build from the repository root, with nanopb from PlatformIO's library directory:
+//
+//   NANOPB=.pio/libdeps/adafruit_feather_m0/Nanopb
+//   g++ -std=c++17 -O2 -Isrc -I$NANOPB tools/trace_dump/trace_dump.cpp src/lora_packet.pb.c $NANOPB/pb_decode.c $NANOPB/pb_common.c -o trace_dump
+//
+//   ./trace_dump /dev/ttyACM0 stream
+//
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "../serial_decoder/serial_decoder.h"
+#include "nautic_net/trace_events.h"
+
+using namespace nautic_net;
+
+static const int kTimeout = 5000; // ms without data before giving up on a dump
+
+static uint32_t ReadUInt32(const uint8_t *bytes)
+{
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+class TraceHandler : public serial_decoder::RecordHandler
+{
+public:
+    void OnFrame(host_frame::Type type, const uint8_t *payload, size_t length) override
+    {
+        if (type == host_frame::Type::kTraceEntries && length >= trace::kIndexSize &&
+            (length - trace::kIndexSize) % sizeof(trace::Entry) == 0)
+        {
+            uint32_t index = ReadUInt32(payload);
+            if (has_index_ && index != next_index_)
+            {
+                printf("# %ld entries lost\n", (long)(int32_t)(index - next_index_));
+            }
+
+            unsigned int count = (length - trace::kIndexSize) / sizeof(trace::Entry);
+            for (unsigned int i = 0; i < count; i++)
+            {
+                trace::Entry entry;
+                memcpy(&entry, payload + trace::kIndexSize + i * sizeof(entry), sizeof(entry));
+                Print(entry);
+            }
+
+            has_index_ = true;
+            next_index_ = index + count;
+            entry_count_ += count;
+        }
+        else if (type == host_frame::Type::kTraceEnd && length == 8)
+        {
+            recorded_count_ = ReadUInt32(payload);
+            lost_count_ = ReadUInt32(payload + 4);
+            is_ended_ = true;
+        }
+    }
+
+    bool IsEnded() const
+    {
+        return is_ended_;
+    }
+
+    unsigned long GetEntryCount() const
+    {
+        return entry_count_;
+    }
+
+    unsigned long GetRecordedCount() const
+    {
+        return recorded_count_;
+    }
+
+    unsigned long GetLostCount() const
+    {
+        return lost_count_;
+    }
+
+private:
+    bool has_index_ = false;
+    uint32_t next_index_ = 0;
+    bool has_time_ = false;
+    uint32_t last_time_us_ = 0;
+    unsigned long entry_count_ = 0;
+    unsigned long recorded_count_ = 0;
+    unsigned long lost_count_ = 0;
+    bool is_ended_ = false;
+
+    void Print(const trace::Entry &entry)
+    {
+        // Differences survive micros() wrapping
+        long delta_us = has_time_ ? (long)(int32_t)(entry.time_us - last_time_us_) : 0;
+        has_time_ = true;
+        last_time_us_ = entry.time_us;
+
+        trace::Event event = (trace::Event)entry.event;
+        printf("%10lu %+9ld %-14s ", (unsigned long)entry.time_us, delta_us, trace::GetName(event));
+        printf(trace::GetFormat(event), (long)entry.a, (long)entry.b);
+        printf("\n");
+    }
+};
+
+int main(int argc, char **argv)
+{
+    bool is_stream = argc == 3 && strcmp(argv[2], "stream") == 0;
+    if (argc != 2 && !is_stream)
+    {
+        fprintf(stderr, "usage: %s port [stream]   (a serial port set up with stty, or - for saved frames on stdin)\n",
+                argv[0]);
+        return 1;
+    }
+
+    bool is_port = strcmp(argv[1], "-") != 0;
+    int fd = is_port ? open(argv[1], O_RDWR | O_NOCTTY) : 0;
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    if (is_port)
+    {
+        const char *command = is_stream ? "trace stream 1\n" : "trace dump\n";
+        if (write(fd, command, strlen(command)) != (ssize_t)strlen(command))
+        {
+            fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+            return 1;
+        }
+    }
+
+    TraceHandler handler;
+    serial_decoder::SerialDecoder decoder(&handler, false);
+    uint8_t buffer[4096];
+
+    // A stream only ends with the input; a quiet unit isn't an error then
+    while (!handler.IsEnded())
+    {
+        struct pollfd input = {fd, POLLIN, 0};
+        if (poll(&input, 1, is_stream ? -1 : kTimeout) == 0)
+        {
+            fprintf(stderr, "%s: no data for %d ms\n", argv[1], kTimeout);
+            break;
+        }
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (length <= 0)
+        {
+            break;
+        }
+
+        decoder.Feed(buffer, length);
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "%lu entries", handler.GetEntryCount());
+    if (handler.IsEnded())
+    {
+        fprintf(stderr, " (%lu recorded since boot, %lu lost)", handler.GetRecordedCount(), handler.GetLostCount());
+    }
+    fprintf(stderr, "\n");
+
+    return !is_stream && !handler.IsEnded() ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+//
+// Downloads a rover's track log (src/nautic_net/rover/track_log.h) over USB and writes it out as CSV, one row per
+// IMU sample, oldest first:
+//
+//   time_ms,second_of_day,latitude,longitude,sog,cog,heading,heel
+//
+// time_ms is the rover's millis() and restarts at every boot; second_of_day is the UTC time of the GPS fix the row's
+// position, SOG and COG come from (one per second), empty without a fix. SOG is in knots, angles in degrees.
+//
+// Sends trackdump to the port (set up with stty first) and reads frames until the dump ends. With - instead of a
+// port, reads a dump saved earlier from stdin.
+//
+// Build from the repository root, with nanopb from PlatformIO's library directory:
+//
+//   NANOPB=.pio/libdeps/adafruit_feather_m0/Nanopb
+//   g++ -std=c++17 -O2 -Isrc -I$NANOPB tools/track_dump/track_dump.cpp src/lora_packet.pb.c $NANOPB/pb_decode.c $NANOPB/pb_common.c -o track_dump
+//
+//   ./track_dump /dev/ttyACM0 > race.csv
+//
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "../serial_decoder/serial_decoder.h"
+#include "nautic_net/track_page.h"
+
+using namespace nautic_net;
+
+static const int kTimeout = 5000; // ms without data before giving up on the rover
+
+class DumpHandler : public serial_decoder::RecordHandler
+{
+public:
+    void OnFrame(host_frame::Type type, const uint8_t *payload, size_t length) override
+    {
+        if (type == host_frame::Type::kTrackPage && length == sizeof(track::Page))
+        {
+            track::Page page;
+            memcpy(&page, payload, sizeof(page));
+            Print(page);
+            page_count_++;
+        }
+        else if (type == host_frame::Type::kTrackEnd && length == 4)
+        {
+            expected_count_ = payload[0] | payload[1] << 8 | payload[2] << 16 | (unsigned long)payload[3] << 24;
+            is_ended_ = true;
+        }
+    }
+
+    bool IsEnded() const
+    {
+        return is_ended_;
+    }
+
+    unsigned long GetPageCount() const
+    {
+        return page_count_;
+    }
+
+    unsigned long GetExpectedCount() const
+    {
+        return expected_count_;
+    }
+
+private:
+    unsigned long page_count_ = 0;
+    unsigned long expected_count_ = 0;
+    bool is_ended_ = false;
+
+    static void Print(const track::Page &page)
+    {
+        for (unsigned int i = 0; i < track::kSamplesPerPage; i++)
+        {
+            const track::Sample &sample = page.samples[i];
+            printf("%lu,", (unsigned long)(page.time + i * track::kSampleInterval));
+            if (page.second_of_day == track::kNoFix)
+            {
+                printf(",,,,,");
+            }
+            else
+            {
+                printf("%d,%.7f,%.7f,%.1f,%.1f,", page.second_of_day, page.latitude / 1e7, page.longitude / 1e7,
+                       page.sog / 10.0, page.cog / 10.0);
+            }
+            printf("%.1f,%.1f\n", sample.heading / 10.0, sample.heel / 10.0);
+        }
+    }
+};
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s port   (a serial port set up with stty, or - for a saved dump on stdin)\n", argv[0]);
+        return 1;
+    }
+
+    bool is_port = strcmp(argv[1], "-") != 0;
+    int fd = is_port ? open(argv[1], O_RDWR | O_NOCTTY) : 0;
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    if (is_port)
+    {
+        static const char kCommand[] = "trackdump\n";
+        if (write(fd, kCommand, sizeof(kCommand) - 1) != sizeof(kCommand) - 1)
+        {
+            fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+            return 1;
+        }
+    }
+
+    printf("time_ms,second_of_day,latitude,longitude,sog,cog,heading,heel\n");
+
+    DumpHandler handler;
+    serial_decoder::SerialDecoder decoder(&handler, false);
+    uint8_t buffer[4096];
+
+    while (!handler.IsEnded())
+    {
+        struct pollfd input = {fd, POLLIN, 0};
+        if (poll(&input, 1, kTimeout) == 0)
+        {
+            fprintf(stderr, "%s: no data for %d ms\n", argv[1], kTimeout);
+            break;
+        }
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (length <= 0)
+        {
+            break;
+        }
+
+        decoder.Feed(buffer, length);
+    }
+
+    fprintf(stderr, "%lu pages (%lu s at %lu Hz)", handler.GetPageCount(),
+            handler.GetPageCount() * track::kSamplesPerPage * track::kSampleInterval / 1000,
+            1000 / track::kSampleInterval);
+    if (!handler.IsEnded() || handler.GetPageCount() != handler.GetExpectedCount())
+    {
+        fprintf(stderr, "; incomplete, the rover reported %lu\n", handler.GetExpectedCount());
+        return 1;
+    }
+    fprintf(stderr, "\n");
+
+    return 0;
+}